@@ -30,8 +30,11 @@ DEMOCPP="amalgamation_demo.cpp"
 #
 ALL_PUBLIC_H="
 $SCRIPTPATH/include/roaring/roaring_version.h
+$SCRIPTPATH/include/roaring/memory.h
 $SCRIPTPATH/include/roaring/roaring_types.h
 $SCRIPTPATH/include/roaring/roaring.h
+$SCRIPTPATH/include/roaring/roaring64.h
+$SCRIPTPATH/include/roaring/roaring_bsi.h
 "
 
 # .hh header files for the C++ API wrapper => Order does not matter at present
@@ -66,6 +69,7 @@ $SCRIPTPATH/include/roaring/containers/mixed_union.h
 $SCRIPTPATH/include/roaring/containers/mixed_xor.h
 $SCRIPTPATH/include/roaring/containers/containers.h
 $SCRIPTPATH/include/roaring/roaring_array.h
+$SCRIPTPATH/include/roaring/art/art.h
 $SCRIPTPATH/include/roaring/misc/configreport.h
 "
 
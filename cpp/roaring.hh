@@ -91,7 +91,7 @@ class Roaring {
      * The pointer to the C struct will be invalid after the call.
      */
     explicit Roaring(roaring_bitmap_t *s) noexcept : roaring (*s) {
-        free(s);  // deallocate the passed-in pointer
+        roaring_free(s);  // deallocate the passed-in pointer
     }
 
     /**
@@ -114,6 +114,19 @@ class Roaring {
      */
     void add(uint32_t x) { api::roaring_bitmap_add(&roaring, x); }
 
+    /**
+     * Context for the bulk operations, see roaring_bulk_context_t.
+     */
+    typedef api::roaring_bulk_context_t BulkContext;
+
+    /**
+     * Add value x, reusing the container found by the previous bulk
+     * operation with the same context when x shares its high 16 bits.
+     */
+    void addBulk(BulkContext &context, uint32_t x) {
+        api::roaring_bitmap_add_bulk(&roaring, &context, x);
+    }
+
     /**
      * Add value x
      * Returns true if a new value was added, false if the value was already existing.
@@ -143,6 +156,14 @@ class Roaring {
      */
     void remove(uint32_t x) { api::roaring_bitmap_remove(&roaring, x); }
 
+    /**
+     * Remove value x, reusing the container found by the previous bulk
+     * operation with the same context.
+     */
+    void removeBulk(BulkContext &context, uint32_t x) {
+        api::roaring_bitmap_remove_bulk(&roaring, &context, x);
+    }
+
     /**
      * Remove value x
      * Returns true if a new value was removed, false if the value was not existing.
@@ -170,6 +191,14 @@ class Roaring {
         return api::roaring_bitmap_contains(&roaring, x);
     }
 
+    /**
+     * Check if value x is present, reusing the container found by the
+     * previous bulk operation with the same context.
+     */
+    bool containsBulk(BulkContext &context, uint32_t x) const {
+        return api::roaring_bitmap_contains_bulk(&roaring, &context, x);
+    }
+
     /**
     * Check if all values from x (included) to y (excluded) are present
     */
@@ -364,6 +393,16 @@ class Roaring {
         return api::roaring_bitmap_select(&roaring, rnk, element);
     }
 
+    /**
+     * Selects the elements of the ranks in [begin, end), which must be sorted
+     * in increasing order, walking the bitmap only once. Returns how many
+     * ranks were selected: the ones past the cardinality all come last.
+     */
+    size_t select_many(const uint32_t *begin, const uint32_t *end,
+                       uint32_t *element) const {
+        return api::roaring_bitmap_select_many(&roaring, begin, end, element);
+    }
+
     /**
      * Computes the size of the intersection between two bitmaps.
      *
@@ -429,6 +468,15 @@ class Roaring {
         return api::roaring_bitmap_rank(&roaring, x);
     }
 
+    /**
+    * Sets ans[i] to rank(begin[i]) for every value in [begin, end), which
+    * must be sorted in increasing order, walking the bitmap only once.
+    */
+    void rank_many(const uint32_t *begin, const uint32_t *end,
+                   uint64_t *ans) const {
+        api::roaring_bitmap_rank_many(&roaring, begin, end, ans);
+    }
+
     /**
     * write a bitmap to a char buffer. This is meant to be compatible with
     * the
@@ -623,7 +671,7 @@ class Roaring {
      */
     static Roaring fastunion(size_t n, const Roaring **inputs) {
         const roaring_bitmap_t **x =
-            (const roaring_bitmap_t **)malloc(n * sizeof(roaring_bitmap_t *));
+            (const roaring_bitmap_t **)roaring_malloc(n * sizeof(roaring_bitmap_t *));
         if (x == NULL) {
             ROARING_TERMINATE("failed memory alloc in fastunion");
         }
@@ -631,11 +679,11 @@ class Roaring {
 
         roaring_bitmap_t *c_ans = api::roaring_bitmap_or_many(n, x);
         if (c_ans == NULL) {
-            free(x);
+            roaring_free(x);
             ROARING_TERMINATE("failed memory alloc in fastunion");
         }
         Roaring ans(c_ans);
-        free(x);
+        roaring_free(x);
         return ans;
     }
 
@@ -16,61 +16,248 @@ A C++ header for 64-bit Roaring Bitmaps, implemented by way of a map of many
 #include <stdexcept>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "roaring.hh"
 using roaring::Roaring;
 
 namespace roaring {
 
-class Roaring64MapSetBitForwardIterator;
-class Roaring64MapSetBitBiDirectionalIterator;
+/**
+ * A drop-in replacement for std::map<uint32_t, Roaring> as the storage of
+ * BasicRoaring64Map, keeping the entries sorted in a vector. The keys are
+ * also kept in an array of their own, so that lookups binary-search
+ * contiguous 32-bit keys, and iterating or merging walks contiguous entries
+ * instead of tree nodes. This is a good fit when there are few distinct high
+ * 32 bits (up to a few thousands); inserting a new key costs a shift of the
+ * entries after it.
+ *
+ * Unlike with std::map, inserting or erasing an entry invalidates the
+ * iterators and references to the other entries.
+ */
+class Roaring64FlatStorage {
+  public:
+    typedef uint32_t key_type;
+    typedef Roaring mapped_type;
+    typedef std::pair<uint32_t, Roaring> value_type;
+    typedef std::vector<value_type>::size_type size_type;
+    typedef std::vector<value_type>::iterator iterator;
+    typedef std::vector<value_type>::const_iterator const_iterator;
+    typedef std::vector<value_type>::reverse_iterator reverse_iterator;
+    typedef std::vector<value_type>::const_reverse_iterator
+        const_reverse_iterator;
+
+    iterator begin() { return entries.begin(); }
+    iterator end() { return entries.end(); }
+    const_iterator begin() const { return entries.begin(); }
+    const_iterator end() const { return entries.end(); }
+    const_iterator cbegin() const { return entries.cbegin(); }
+    const_iterator cend() const { return entries.cend(); }
+    const_reverse_iterator crbegin() const { return entries.crbegin(); }
+    const_reverse_iterator crend() const { return entries.crend(); }
+
+    size_type size() const { return entries.size(); }
+    bool empty() const { return entries.empty(); }
+
+    void clear() {
+        keys.clear();
+        entries.clear();
+        last = 0;
+    }
+
+    void swap(Roaring64FlatStorage &o) {
+        keys.swap(o.keys);
+        entries.swap(o.entries);
+        std::swap(last, o.last);
+    }
+
+    iterator lower_bound(uint32_t key) {
+        return entries.begin() + position(key);
+    }
+    const_iterator lower_bound(uint32_t key) const {
+        return entries.cbegin() + position(key);
+    }
+
+    iterator find(uint32_t key) {
+        size_t i = cachedPosition(key);
+        return (i < keys.size() && keys[i] == key) ? entries.begin() + i
+                                                   : entries.end();
+    }
+    const_iterator find(uint32_t key) const {
+        size_t i = position(key);
+        return (i < keys.size() && keys[i] == key) ? entries.cbegin() + i
+                                                   : entries.cend();
+    }
+
+    size_type count(uint32_t key) const { return find(key) == cend() ? 0 : 1; }
+
+    /**
+     * Returns the bitmap for the given key, inserting an empty one if
+     * there is none.
+     */
+    Roaring &operator[](uint32_t key) {
+        size_t i = cachedPosition(key);
+        if (i == keys.size() || keys[i] != key) {
+            insertAt(i, value_type(key, Roaring()));
+        }
+        return entries[i].second;
+    }
+
+    std::pair<iterator, bool> emplace(value_type &&value) {
+        size_t i = cachedPosition(value.first);
+        if (i < keys.size() && keys[i] == value.first) {
+            return std::make_pair(entries.begin() + i, false);
+        }
+        return std::make_pair(insertAt(i, std::move(value)), true);
+    }
+    std::pair<iterator, bool> insert(const value_type &value) {
+        return emplace(value_type(value));
+    }
+
+    /**
+     * Inserts the value just before hint when that keeps the keys sorted,
+     * which makes building the storage in increasing order of keys linear.
+     * Returns the entry with the key of value, which is left unchanged if
+     * it was already present.
+     */
+    iterator insert(const_iterator hint, value_type &&value) {
+        size_t i = hint - entries.cbegin();
+        if ((i < keys.size() && keys[i] <= value.first) ||
+            (i > 0 && keys[i - 1] >= value.first)) {
+            return emplace(std::move(value)).first;
+        }
+        return insertAt(i, std::move(value));
+    }
+    iterator insert(const_iterator hint, const value_type &value) {
+        return insert(hint, value_type(value));
+    }
+
+    iterator erase(const_iterator pos) {
+        size_t i = pos - entries.cbegin();
+        keys.erase(keys.begin() + i);
+        return entries.erase(entries.begin() + i);
+    }
+
+  private:
+    // index of the first key that is not smaller than key
+    size_t position(uint32_t key) const {
+        if (keys.empty() || keys.back() < key) return keys.size();
+        return std::lower_bound(keys.begin(), keys.end(), key) - keys.begin();
+    }
+
+    // same as position(), trying first the position found last time, which
+    // serves runs of operations on the same high bits
+    size_t cachedPosition(uint32_t key) {
+        if (last < keys.size() && keys[last] == key) return last;
+        last = position(key);
+        return last;
+    }
+
+    iterator insertAt(size_t i, value_type &&value) {
+        keys.insert(keys.begin() + i, value.first);
+        return entries.insert(entries.begin() + i, std::move(value));
+    }
+
+    std::vector<uint32_t> keys{};
+    std::vector<value_type> entries{};
+    size_t last{0};
+};
+
+template <class Storage>
+class BasicRoaring64MapSetBitForwardIterator;
+template <class Storage>
+class BasicRoaring64MapSetBitBiDirectionalIterator;
+
+/**
+ * Layout of the frozen 64-bit format, written by
+ * BasicRoaring64Map::writeFrozen() and read in place by
+ * Roaring64MapFrozenView. Like the 32-bit frozen format, it uses the native
+ * byte order:
+ *
+ *   uint32_t cookie       Roaring64MapFrozenFormat::cookie
+ *   uint32_t reserved     zero
+ *   uint64_t n            the number of non-empty 32-bit bitmaps
+ *   uint32_t keys[n]      the high 32 bits of the values of each bitmap, in
+ *                         increasing order, followed by zeros up to a
+ *                         multiple of 8 bytes
+ *   uint64_t offsets[n]   where bitmap i starts, in bytes from the start of
+ *                         the buffer: always a multiple of 32
+ *   uint64_t lengths[n]   the size of bitmap i in bytes
+ *   the n bitmaps         each written by roaring_bitmap_frozen_serialize()
+ *                         at its offset, with zeros in between
+ *
+ * The header is enough to locate any bitmap, so opening a view costs
+ * O(number of containers), whatever the size of the data.
+ */
+struct Roaring64MapFrozenFormat {
+    static const uint32_t cookie = 0x34365A46;  // "FZ64"
+
+    static size_t headerSizeInBytes(uint64_t n) {
+        return 2 * sizeof(uint32_t) + sizeof(uint64_t) +
+               ((n * sizeof(uint32_t) + 7) & ~size_t(7)) +
+               2 * n * sizeof(uint64_t);
+    }
+
+    // the 32-bit frozen views need 32-byte aligned data
+    static size_t alignOffset(size_t offset) {
+        return (offset + 31) & ~size_t(31);
+    }
+};
+
+/**
+ * A 64-bit bitmap, made of the Roaring bitmaps of the 32 low bits of the
+ * values, indexed by their 32 high bits in Storage: either a
+ * std::map<uint32_t, Roaring> (Roaring64Map) or a Roaring64FlatStorage
+ * (Roaring64FlatMap).
+ */
+template <class Storage>
+class BasicRoaring64Map {
 
-class Roaring64Map {
   typedef api::roaring_bitmap_t roaring_bitmap_t;
 
   public:
     /**
      * Create an empty bitmap
      */
-    Roaring64Map() = default;
+    BasicRoaring64Map() = default;
 
     /**
      * Construct a bitmap from a list of 32-bit integer values.
      */
-    Roaring64Map(size_t n, const uint32_t *data) { addMany(n, data); }
+    BasicRoaring64Map(size_t n, const uint32_t *data) { addMany(n, data); }
 
     /**
      * Construct a bitmap from a list of 64-bit integer values.
      */
-    Roaring64Map(size_t n, const uint64_t *data) { addMany(n, data); }
+    BasicRoaring64Map(size_t n, const uint64_t *data) { addMany(n, data); }
 
     /**
      * Construct a 64-bit map from a 32-bit one
      */
-    explicit Roaring64Map(const Roaring &r) { emplaceOrInsert(0, r); }
+    explicit BasicRoaring64Map(const Roaring &r) { emplaceOrInsert(0, r); }
 
     /**
      * Construct a roaring object from the C struct.
      *
      * Passing a NULL point is unsafe.
      */
-    explicit Roaring64Map(roaring_bitmap_t *s) {
+    explicit BasicRoaring64Map(roaring_bitmap_t *s) {
         Roaring r(s);
         emplaceOrInsert(0, r);
     }
 
-    Roaring64Map(const Roaring64Map& r)
+    BasicRoaring64Map(const BasicRoaring64Map& r)
       : roarings(r.roarings),
         copyOnWrite(r.copyOnWrite) { }
 
-    Roaring64Map(Roaring64Map&& r)
+    BasicRoaring64Map(BasicRoaring64Map&& r)
       : roarings(r.roarings),
         copyOnWrite(r.copyOnWrite) { }
 
 	/**
 	 * Assignment operator.
 	 */
-	Roaring64Map &operator=(const Roaring64Map &r) {
+	BasicRoaring64Map &operator=(const BasicRoaring64Map &r) {
 		roarings = r.roarings;
 		return *this;
 	}
@@ -78,8 +265,8 @@ class Roaring64Map {
 	/**
      * Construct a bitmap from a list of integer values.
      */
-    static Roaring64Map bitmapOf(size_t n...) {
-        Roaring64Map ans;
+    static BasicRoaring64Map bitmapOf(size_t n...) {
+        BasicRoaring64Map ans;
         va_list vl;
         va_start(vl, n);
         for (size_t i = 0; i < n; i++) {
@@ -204,12 +391,14 @@ class Roaring64Map {
      * Check if value x is present
      */
     bool contains(uint32_t x) const {
-        return roarings.count(0) == 0 ? false : roarings.at(0).contains(x);
+        auto roaring_iter = roarings.find(0);
+        return roaring_iter != roarings.cend() &&
+               roaring_iter->second.contains(x);
     }
     bool contains(uint64_t x) const {
-        return roarings.count(highBytes(x)) == 0
-                   ? false
-                   : roarings.at(highBytes(x)).contains(lowBytes(x));
+        auto roaring_iter = roarings.find(highBytes(x));
+        return roaring_iter != roarings.cend() &&
+               roaring_iter->second.contains(lowBytes(x));
     }
 
     /**
@@ -218,10 +407,16 @@ class Roaring64Map {
      * writing the result in the current bitmap. The provided bitmap is not
      * modified.
      */
-    Roaring64Map &operator&=(const Roaring64Map &r) {
+    BasicRoaring64Map &operator&=(const BasicRoaring64Map &r) {
+        // both maps are sorted by key: walk them together
+        auto rhs_iter = r.roarings.cbegin();
         for (auto &map_entry : roarings) {
-            if (r.roarings.count(map_entry.first) == 1)
-                map_entry.second &= r.roarings.at(map_entry.first);
+            while (rhs_iter != r.roarings.cend() &&
+                   rhs_iter->first < map_entry.first)
+                ++rhs_iter;
+            if (rhs_iter != r.roarings.cend() &&
+                rhs_iter->first == map_entry.first)
+                map_entry.second &= rhs_iter->second;
             else
                 map_entry.second = Roaring();
         }
@@ -234,10 +429,15 @@ class Roaring64Map {
      * writing the result in the current bitmap. The provided bitmap is not
      * modified.
      */
-    Roaring64Map &operator-=(const Roaring64Map &r) {
+    BasicRoaring64Map &operator-=(const BasicRoaring64Map &r) {
+        auto rhs_iter = r.roarings.cbegin();
         for (auto &map_entry : roarings) {
-            if (r.roarings.count(map_entry.first) == 1)
-                map_entry.second -= r.roarings.at(map_entry.first);
+            while (rhs_iter != r.roarings.cend() &&
+                   rhs_iter->first < map_entry.first)
+                ++rhs_iter;
+            if (rhs_iter == r.roarings.cend()) break;
+            if (rhs_iter->first == map_entry.first)
+                map_entry.second -= rhs_iter->second;
         }
         return *this;
     }
@@ -249,13 +449,22 @@ class Roaring64Map {
      *
      * See also the fastunion function to aggregate many bitmaps more quickly.
      */
-    Roaring64Map &operator|=(const Roaring64Map &r) {
+    BasicRoaring64Map &operator|=(const BasicRoaring64Map &r) {
+        if (this == &r) return *this;
+        // both maps are sorted by key: walk them together, inserting the
+        // missing keys at the current position
+        auto lhs_iter = roarings.begin();
         for (const auto &map_entry : r.roarings) {
-            if (roarings.count(map_entry.first) == 0) {
-                roarings[map_entry.first] = map_entry.second;
-                roarings[map_entry.first].setCopyOnWrite(copyOnWrite);
-            } else
-                roarings[map_entry.first] |= map_entry.second;
+            while (lhs_iter != roarings.end() &&
+                   lhs_iter->first < map_entry.first)
+                ++lhs_iter;
+            if (lhs_iter != roarings.end() &&
+                lhs_iter->first == map_entry.first) {
+                lhs_iter->second |= map_entry.second;
+            } else {
+                lhs_iter = roarings.insert(lhs_iter, map_entry);
+                lhs_iter->second.setCopyOnWrite(copyOnWrite);
+            }
         }
         return *this;
     }
@@ -266,13 +475,23 @@ class Roaring64Map {
      * writing the result in the current bitmap. The provided bitmap is not
      * modified.
      */
-    Roaring64Map &operator^=(const Roaring64Map &r) {
+    BasicRoaring64Map &operator^=(const BasicRoaring64Map &r) {
+        if (this == &r) {
+            clear();
+            return *this;
+        }
+        auto lhs_iter = roarings.begin();
         for (const auto &map_entry : r.roarings) {
-            if (roarings.count(map_entry.first) == 0) {
-                roarings[map_entry.first] = map_entry.second;
-                roarings[map_entry.first].setCopyOnWrite(copyOnWrite);
-            } else
-                roarings[map_entry.first] ^= map_entry.second;
+            while (lhs_iter != roarings.end() &&
+                   lhs_iter->first < map_entry.first)
+                ++lhs_iter;
+            if (lhs_iter != roarings.end() &&
+                lhs_iter->first == map_entry.first) {
+                lhs_iter->second ^= map_entry.second;
+            } else {
+                lhs_iter = roarings.insert(lhs_iter, map_entry);
+                lhs_iter->second.setCopyOnWrite(copyOnWrite);
+            }
         }
         return *this;
     }
@@ -280,7 +499,7 @@ class Roaring64Map {
     /**
      * Exchange the content of this bitmap with another.
      */
-    void swap(Roaring64Map &r) { roarings.swap(r.roarings); }
+    void swap(BasicRoaring64Map &r) { roarings.swap(r.roarings); }
 
     /**
      * Get the cardinality of the bitmap (number of elements).
@@ -301,7 +520,7 @@ class Roaring64Map {
         return std::accumulate(
             roarings.cbegin(), roarings.cend(), (uint64_t)0,
             [](uint64_t previous,
-               const std::pair<uint32_t, Roaring> &map_entry) {
+               const typename Storage::value_type &map_entry) {
                 return previous + map_entry.second.cardinality();
             });
     }
@@ -311,7 +530,7 @@ class Roaring64Map {
     */
     bool isEmpty() const {
         return std::all_of(roarings.cbegin(), roarings.cend(),
-                           [](const std::pair<uint32_t, Roaring> &map_entry) {
+                           [](const typename Storage::value_type &map_entry) {
                                return map_entry.second.isEmpty();
                            });
     }
@@ -328,7 +547,7 @@ class Roaring64Map {
                        ((uint64_t)(std::numeric_limits<uint32_t>::max)()) + 1
                    ? std::all_of(
                          roarings.cbegin(), roarings.cend(),
-                         [](const std::pair<uint32_t, Roaring> &roaring_map_entry) {
+                         [](const typename Storage::value_type &roaring_map_entry) {
                              // roarings within map are saturated if cardinality
                              // is uint32_t max + 1
                              return roaring_map_entry.second.cardinality() ==
@@ -342,7 +561,7 @@ class Roaring64Map {
     /**
     * Returns true if the bitmap is subset of the other.
     */
-    bool isSubset(const Roaring64Map &r) const {
+    bool isSubset(const BasicRoaring64Map &r) const {
         for (const auto &map_entry : roarings) {
             auto roaring_iter = r.roarings.find(map_entry.first);
             if (roaring_iter == r.roarings.cend())
@@ -358,7 +577,7 @@ class Roaring64Map {
     * Throws std::length_error in the special case where the bitmap is full
     * (cardinality() == 2^64). Check isFull() before calling to avoid exception.
     */
-    bool isStrictSubset(const Roaring64Map &r) const {
+    bool isStrictSubset(const BasicRoaring64Map &r) const {
         return isSubset(r) && cardinality() != r.cardinality();
     }
 
@@ -372,7 +591,7 @@ class Roaring64Map {
         // Annoyingly, VS 2017 marks std::accumulate() as [[nodiscard]]
         (void)std::accumulate(roarings.cbegin(), roarings.cend(), ans,
                               [](uint64_t *previous,
-                                 const std::pair<uint32_t, Roaring> &map_entry) {
+                                 const typename Storage::value_type &map_entry) {
                                   for (uint32_t low_bits : map_entry.second)
                                       *previous++ =
                                           uniteBytes(map_entry.first, low_bits);
@@ -383,7 +602,7 @@ class Roaring64Map {
     /**
      * Return true if the two bitmaps contain the same elements.
      */
-    bool operator==(const Roaring64Map &r) const {
+    bool operator==(const BasicRoaring64Map &r) const {
         // we cannot use operator == on the map because either side may contain
         // empty Roaring Bitmaps
         auto lhs_iter = roarings.cbegin();
@@ -470,7 +689,7 @@ class Roaring64Map {
     bool removeRunCompression() {
         return std::accumulate(
             roarings.begin(), roarings.end(), true,
-            [](bool previous, std::pair<const uint32_t, Roaring> &map_entry) {
+            [](bool previous, typename Storage::value_type &map_entry) {
                 return map_entry.second.removeRunCompression() && previous;
             });
     }
@@ -484,7 +703,7 @@ class Roaring64Map {
     bool runOptimize() {
         return std::accumulate(
             roarings.begin(), roarings.end(), true,
-            [](bool previous, std::pair<const uint32_t, Roaring> &map_entry) {
+            [](bool previous, typename Storage::value_type &map_entry) {
                 return map_entry.second.runOptimize() && previous;
             });
     }
@@ -500,7 +719,7 @@ class Roaring64Map {
             if (iter->second.isEmpty()) {
                 // empty Roarings are 84 bytes
                 savedBytes += 88;
-                roarings.erase(iter++);
+                iter = roarings.erase(iter);
             } else {
                 savedBytes += iter->second.shrinkToFit();
                 iter++;
@@ -520,7 +739,7 @@ class Roaring64Map {
      */
     void iterate(api::roaring_iterator64 iterator, void *ptr) const {
         std::for_each(roarings.begin(), roarings.cend(),
-                      [=](const std::pair<const uint32_t, Roaring> &map_entry) {
+                      [=](const typename Storage::value_type &map_entry) {
                           roaring_iterate64(&map_entry.second.roaring, iterator,
                                             uint64_t(map_entry.first) << 32,
                                             ptr);
@@ -586,7 +805,7 @@ class Roaring64Map {
         buf += sizeof(uint64_t);
         std::for_each(
             roarings.cbegin(), roarings.cend(),
-            [&buf, portable](const std::pair<const uint32_t, Roaring> &map_entry) {
+            [&buf, portable](const typename Storage::value_type &map_entry) {
                 // push map key
                 std::memcpy(buf, &map_entry.first, sizeof(uint32_t));
                 // ^-- Note: `*((uint32_t*)buf) = map_entry.first;` is undefined
@@ -611,8 +830,8 @@ class Roaring64Map {
      * This function is unsafe in the sense that if you provide bad data,
      * many bytes could be read, possibly causing a buffer overflow. See also readSafe.
      */
-    static Roaring64Map read(const char *buf, bool portable = true) {
-        Roaring64Map result;
+    static BasicRoaring64Map read(const char *buf, bool portable = true) {
+        BasicRoaring64Map result;
         // get map size
         uint64_t map_size = *((uint64_t *)buf);
         buf += sizeof(uint64_t);
@@ -640,8 +859,8 @@ class Roaring64Map {
      * can save space compared to the portable format (e.g., for very
      * sparse bitmaps).
      */
-    static Roaring64Map readSafe(const char *buf, size_t maxbytes) {
-        Roaring64Map result;
+    static BasicRoaring64Map readSafe(const char *buf, size_t maxbytes) {
+        BasicRoaring64Map result;
         // get map size
         uint64_t map_size = *((uint64_t *)buf);
         buf += sizeof(uint64_t);
@@ -687,42 +906,103 @@ class Roaring64Map {
             roarings.cbegin(), roarings.cend(),
             sizeof(uint64_t) + roarings.size() * sizeof(uint32_t),
             [=](size_t previous,
-                const std::pair<uint32_t, Roaring> &map_entry) {
+                const typename Storage::value_type &map_entry) {
                 // add in bytes used by each Roaring
                 return previous + map_entry.second.getSizeInBytes(portable);
             });
     }
 
+    /**
+     * How many bytes are required to serialize this bitmap with
+     * writeFrozen().
+     */
+    size_t getFrozenSizeInBytes() const {
+        uint64_t n = 0;
+        for (const auto &map_entry : roarings) {
+            if (!map_entry.second.isEmpty()) n++;
+        }
+        size_t size = Roaring64MapFrozenFormat::headerSizeInBytes(n);
+        for (const auto &map_entry : roarings) {
+            if (map_entry.second.isEmpty()) continue;
+            size = Roaring64MapFrozenFormat::alignOffset(size) +
+                   api::roaring_bitmap_frozen_size_in_bytes(
+                       &map_entry.second.roaring);
+        }
+        return size;
+    }
+
+    /**
+     * Serializes the bitmap in the frozen 64-bit format (see
+     * Roaring64MapFrozenFormat), which Roaring64MapFrozenView can query
+     * without deserializing it, e.g., from a memory-mapped file. Writes
+     * getFrozenSizeInBytes() bytes. Like the 32-bit frozen format, it is
+     * not portable across platforms.
+     */
+    void writeFrozen(char *buf) const {
+        uint64_t n = 0;
+        for (const auto &map_entry : roarings) {
+            if (!map_entry.second.isEmpty()) n++;
+        }
+        const size_t header_size =
+            Roaring64MapFrozenFormat::headerSizeInBytes(n);
+        std::memset(buf, 0, header_size);
+        const uint32_t cookie = Roaring64MapFrozenFormat::cookie;
+        std::memcpy(buf, &cookie, sizeof(uint32_t));
+        std::memcpy(buf + 2 * sizeof(uint32_t), &n, sizeof(uint64_t));
+        char *keys = buf + 2 * sizeof(uint32_t) + sizeof(uint64_t);
+        char *offsets = buf + header_size - 2 * n * sizeof(uint64_t);
+        char *lengths = offsets + n * sizeof(uint64_t);
+
+        size_t size = header_size;
+        for (const auto &map_entry : roarings) {
+            if (map_entry.second.isEmpty()) continue;
+            const size_t aligned = Roaring64MapFrozenFormat::alignOffset(size);
+            std::memset(buf + size, 0, aligned - size);
+            const uint64_t offset = aligned;
+            const uint64_t length = api::roaring_bitmap_frozen_size_in_bytes(
+                &map_entry.second.roaring);
+            api::roaring_bitmap_frozen_serialize(&map_entry.second.roaring,
+                                                 buf + aligned);
+            std::memcpy(keys, &map_entry.first, sizeof(uint32_t));
+            std::memcpy(offsets, &offset, sizeof(uint64_t));
+            std::memcpy(lengths, &length, sizeof(uint64_t));
+            keys += sizeof(uint32_t);
+            offsets += sizeof(uint64_t);
+            lengths += sizeof(uint64_t);
+            size = aligned + length;
+        }
+    }
+
     /**
      * Computes the intersection between two bitmaps and returns new bitmap.
      * The current bitmap and the provided bitmap are unchanged.
      */
-    Roaring64Map operator&(const Roaring64Map &o) const {
-        return Roaring64Map(*this) &= o;
+    BasicRoaring64Map operator&(const BasicRoaring64Map &o) const {
+        return BasicRoaring64Map(*this) &= o;
     }
 
     /**
      * Computes the difference between two bitmaps and returns new bitmap.
      * The current bitmap and the provided bitmap are unchanged.
      */
-    Roaring64Map operator-(const Roaring64Map &o) const {
-        return Roaring64Map(*this) -= o;
+    BasicRoaring64Map operator-(const BasicRoaring64Map &o) const {
+        return BasicRoaring64Map(*this) -= o;
     }
 
     /**
      * Computes the union between two bitmaps and returns new bitmap.
      * The current bitmap and the provided bitmap are unchanged.
      */
-    Roaring64Map operator|(const Roaring64Map &o) const {
-        return Roaring64Map(*this) |= o;
+    BasicRoaring64Map operator|(const BasicRoaring64Map &o) const {
+        return BasicRoaring64Map(*this) |= o;
     }
 
     /**
      * Computes the symmetric union between two bitmaps and returns new bitmap.
      * The current bitmap and the provided bitmap are unchanged.
      */
-    Roaring64Map operator^(const Roaring64Map &o) const {
-        return Roaring64Map(*this) ^= o;
+    BasicRoaring64Map operator^(const BasicRoaring64Map &o) const {
+        return BasicRoaring64Map(*this) ^= o;
     }
 
     /**
@@ -732,7 +1012,7 @@ class Roaring64Map {
         if (copyOnWrite == val) return;
         copyOnWrite = val;
         std::for_each(roarings.begin(), roarings.end(),
-                      [=](std::pair<const uint32_t, Roaring> &map_entry) {
+                      [=](typename Storage::value_type &map_entry) {
                           map_entry.second.setCopyOnWrite(val);
                       });
     }
@@ -762,7 +1042,7 @@ class Roaring64Map {
                 (void *)&outer_iter_data);
             std::for_each(
                 ++map_iter, roarings.cend(),
-                [](const std::pair<const uint32_t, Roaring> &map_entry) {
+                [](const typename Storage::value_type &map_entry) {
                     map_entry.second.iterate(
                         [](uint32_t low_bits, void *high_bits) -> bool {
                             std::printf(",%llu",
@@ -804,7 +1084,7 @@ class Roaring64Map {
             std::for_each(
                 ++map_iter, roarings.cend(),
                 [&outer_iter_data](
-                    const std::pair<const uint32_t, Roaring> &map_entry) {
+                    const typename Storage::value_type &map_entry) {
                     outer_iter_data.high_bits = map_entry.first;
                     map_entry.second.iterate(
                         [](uint32_t low_bits, void *inner_iter_data) -> bool {
@@ -833,19 +1113,48 @@ class Roaring64Map {
      * computes the logical or (union) between "n" bitmaps (referenced by a
      * pointer).
      */
-    static Roaring64Map fastunion(size_t n, const Roaring64Map **inputs) {
-        Roaring64Map ans;
-        // not particularly fast
+    static BasicRoaring64Map fastunion(size_t n, const BasicRoaring64Map **inputs) {
+        BasicRoaring64Map ans;
+        // gather the bitmaps of all inputs by key, then compute one
+        // Roaring::fastunion per key, appending the results in key order
+        std::vector<std::pair<uint32_t, const Roaring *>> entries;
         for (size_t lcv = 0; lcv < n; ++lcv) {
-            ans |= *(inputs[lcv]);
+            for (const auto &map_entry : inputs[lcv]->roarings) {
+                entries.push_back(
+                    std::make_pair(map_entry.first, &map_entry.second));
+            }
+        }
+        std::stable_sort(entries.begin(), entries.end(),
+                         [](const std::pair<uint32_t, const Roaring *> &a,
+                            const std::pair<uint32_t, const Roaring *> &b) {
+                             return a.first < b.first;
+                         });
+        std::vector<const Roaring *> group;
+        for (size_t start = 0; start < entries.size();) {
+            const uint32_t key = entries[start].first;
+            group.clear();
+            size_t end = start;
+            for (; end < entries.size() && entries[end].first == key; ++end) {
+                group.push_back(entries[end].second);
+            }
+            auto roaring_iter = ans.roarings.insert(
+                ans.roarings.end(),
+                std::make_pair(key, group.size() == 1
+                                        ? *group[0]
+                                        : Roaring::fastunion(group.size(),
+                                                             group.data())));
+            roaring_iter->second.setCopyOnWrite(ans.copyOnWrite);
+            start = end;
         }
         return ans;
     }
 
-    friend class Roaring64MapSetBitForwardIterator;
-	friend class Roaring64MapSetBitBiDirectionalIterator;
-    typedef Roaring64MapSetBitForwardIterator const_iterator;
-    typedef Roaring64MapSetBitBiDirectionalIterator const_bidirectional_iterator;
+    template <class> friend class BasicRoaring64MapSetBitForwardIterator;
+    friend class Roaring64MapFrozenView;
+    template <class> friend class BasicRoaring64MapSetBitBiDirectionalIterator;
+    typedef BasicRoaring64MapSetBitForwardIterator<Storage> const_iterator;
+    typedef BasicRoaring64MapSetBitBiDirectionalIterator<Storage>
+        const_bidirectional_iterator;
 
     /**
     * Returns an iterator that can be used to access the position of the
@@ -868,7 +1177,7 @@ class Roaring64Map {
     const_iterator end() const;
 
    private:
-    std::map<uint32_t, Roaring> roarings{}; // The empty constructor silences warnings from pedantic static analyzers.
+    Storage roarings{}; // The empty constructor silences warnings from pedantic static analyzers.
     bool copyOnWrite{false};
     static uint32_t highBytes(const uint64_t in) { return uint32_t(in >> 32); }
     static uint32_t lowBytes(const uint64_t in) { return uint32_t(in); }
@@ -890,20 +1199,22 @@ class Roaring64Map {
 /**
  * Used to go through the set bits. Not optimally fast, but convenient.
  */
-class Roaring64MapSetBitForwardIterator {
+template <class Storage>
+class BasicRoaring64MapSetBitForwardIterator {
    public:
     typedef std::forward_iterator_tag iterator_category;
     typedef uint64_t *pointer;
     typedef uint64_t &reference_type;
     typedef uint64_t value_type;
     typedef int64_t difference_type;
-    typedef Roaring64MapSetBitForwardIterator type_of_iterator;
+    typedef BasicRoaring64MapSetBitForwardIterator type_of_iterator;
 
     /**
      * Provides the location of the set bit.
      */
     value_type operator*() const {
-        return Roaring64Map::uniteBytes(map_iter->first, i.current_value);
+        return BasicRoaring64Map<Storage>::uniteBytes(map_iter->first,
+                                                      i.current_value);
     }
 
     bool operator<(const type_of_iterator &o) const {
@@ -941,7 +1252,7 @@ class Roaring64MapSetBitForwardIterator {
     }
 
     type_of_iterator operator++(int) {  // i++, must return orig. value
-        Roaring64MapSetBitForwardIterator orig(*this);
+        BasicRoaring64MapSetBitForwardIterator orig(*this);
         roaring_advance_uint32_iterator(&i);
         while (!i.has_value) {
             map_iter++;
@@ -952,11 +1263,11 @@ class Roaring64MapSetBitForwardIterator {
     }
 
     bool move(const value_type& x) {
-      map_iter = p.lower_bound(Roaring64Map::highBytes(x));
+      map_iter = p.lower_bound(BasicRoaring64Map<Storage>::highBytes(x));
       if (map_iter != p.cend()) {
         roaring_init_iterator(&map_iter->second.roaring, &i);
-        if (map_iter->first == Roaring64Map::highBytes(x)) {
-          if (roaring_move_uint32_iterator_equalorlarger(&i, Roaring64Map::lowBytes(x)))
+        if (map_iter->first == BasicRoaring64Map<Storage>::highBytes(x)) {
+          if (roaring_move_uint32_iterator_equalorlarger(&i, BasicRoaring64Map<Storage>::lowBytes(x)))
             return true;
           map_iter++;
           if (map_iter == map_end) return false;
@@ -967,33 +1278,33 @@ class Roaring64MapSetBitForwardIterator {
       return false;
     }
 
-    bool operator==(const Roaring64MapSetBitForwardIterator &o) const {
+    bool operator==(const BasicRoaring64MapSetBitForwardIterator &o) const {
       if (map_iter == map_end && o.map_iter == o.map_end) return true;
       if (o.map_iter == o.map_end) return false;
       return **this == *o;
     }
 
-    bool operator!=(const Roaring64MapSetBitForwardIterator &o) const {
+    bool operator!=(const BasicRoaring64MapSetBitForwardIterator &o) const {
       if (map_iter == map_end && o.map_iter == o.map_end) return false;
       if (o.map_iter == o.map_end) return true;
       return **this != *o;
     }
 
-    Roaring64MapSetBitForwardIterator &operator=(const Roaring64MapSetBitForwardIterator& r) {
+    BasicRoaring64MapSetBitForwardIterator &operator=(const BasicRoaring64MapSetBitForwardIterator& r) {
       map_iter = r.map_iter;
       map_end = r.map_end;
       i = r.i;
       return *this;
     }
 
-    Roaring64MapSetBitForwardIterator(const Roaring64MapSetBitForwardIterator& r)
+    BasicRoaring64MapSetBitForwardIterator(const BasicRoaring64MapSetBitForwardIterator& r)
       : p(r.p),
       map_iter(r.map_iter),
       map_end(r.map_end),
       i(r.i)
     { }
 
-    Roaring64MapSetBitForwardIterator(const Roaring64Map &parent,
+    BasicRoaring64MapSetBitForwardIterator(const BasicRoaring64Map<Storage> &parent,
         bool exhausted = false)
       : p(parent.roarings), map_end(parent.roarings.cend()) {
         if (exhausted || parent.roarings.empty()) {
@@ -1010,24 +1321,30 @@ class Roaring64MapSetBitForwardIterator {
       }
 
    protected:
-	const std::map<uint32_t, Roaring>& p;
-    std::map<uint32_t, Roaring>::const_iterator map_iter{}; // The empty constructor silences warnings from pedantic static analyzers.
-    std::map<uint32_t, Roaring>::const_iterator map_end{}; // The empty constructor silences warnings from pedantic static analyzers.
+	const Storage& p;
+    typename Storage::const_iterator map_iter{}; // The empty constructor silences warnings from pedantic static analyzers.
+    typename Storage::const_iterator map_end{}; // The empty constructor silences warnings from pedantic static analyzers.
     api::roaring_uint32_iterator_t i{}; // The empty constructor silences warnings from pedantic static analyzers.
 };
 
-class Roaring64MapSetBitBiDirectionalIterator final :public Roaring64MapSetBitForwardIterator {
+template <class Storage>
+class BasicRoaring64MapSetBitBiDirectionalIterator final :public BasicRoaring64MapSetBitForwardIterator<Storage> {
+	typedef BasicRoaring64MapSetBitForwardIterator<Storage> base_type;
+	using base_type::map_iter;
+	using base_type::map_end;
+	using base_type::i;
+
  public:
-	explicit Roaring64MapSetBitBiDirectionalIterator(const Roaring64Map &parent,
+	explicit BasicRoaring64MapSetBitBiDirectionalIterator(const BasicRoaring64Map<Storage> &parent,
 											bool exhausted = false)
-        : Roaring64MapSetBitForwardIterator(parent, exhausted), map_begin(parent.roarings.cbegin()) {}
+        : base_type(parent, exhausted), map_begin(parent.roarings.cbegin()) {}
 
-	Roaring64MapSetBitBiDirectionalIterator &operator=(const Roaring64MapSetBitForwardIterator& r) {
-		*(Roaring64MapSetBitForwardIterator*)this = r;
+	BasicRoaring64MapSetBitBiDirectionalIterator &operator=(const base_type& r) {
+		*(base_type*)this = r;
 		return *this;
 	}
 
-	Roaring64MapSetBitBiDirectionalIterator& operator--() { //  --i, must return dec.value
+	BasicRoaring64MapSetBitBiDirectionalIterator& operator--() { //  --i, must return dec.value
 		if (map_iter == map_end) {
 			--map_iter;
 			roaring_init_iterator_last(&map_iter->second.roaring, &i);
@@ -1043,8 +1360,8 @@ class Roaring64MapSetBitBiDirectionalIterator final :public Roaring64MapSetBitFo
         return *this;
     }
 
-	Roaring64MapSetBitBiDirectionalIterator operator--(int) {  // i--, must return orig. value
-        Roaring64MapSetBitBiDirectionalIterator orig(*this);
+	BasicRoaring64MapSetBitBiDirectionalIterator operator--(int) {  // i--, must return orig. value
+        BasicRoaring64MapSetBitBiDirectionalIterator orig(*this);
 		if (map_iter == map_end) {
 			--map_iter;
 			roaring_init_iterator_last(&map_iter->second.roaring, &i);
@@ -1061,17 +1378,270 @@ class Roaring64MapSetBitBiDirectionalIterator final :public Roaring64MapSetBitFo
     }
 
  protected:
-	std::map<uint32_t, Roaring>::const_iterator map_begin;
+	typename Storage::const_iterator map_begin;
 };
 
-inline Roaring64MapSetBitForwardIterator Roaring64Map::begin() const {
-    return Roaring64MapSetBitForwardIterator(*this);
+template <class Storage>
+inline BasicRoaring64MapSetBitForwardIterator<Storage>
+BasicRoaring64Map<Storage>::begin() const {
+    return BasicRoaring64MapSetBitForwardIterator<Storage>(*this);
 }
 
-inline Roaring64MapSetBitForwardIterator Roaring64Map::end() const {
-    return Roaring64MapSetBitForwardIterator(*this, true);
+template <class Storage>
+inline BasicRoaring64MapSetBitForwardIterator<Storage>
+BasicRoaring64Map<Storage>::end() const {
+    return BasicRoaring64MapSetBitForwardIterator<Storage>(*this, true);
 }
 
+typedef BasicRoaring64Map<std::map<uint32_t, Roaring>> Roaring64Map;
+typedef BasicRoaring64MapSetBitForwardIterator<std::map<uint32_t, Roaring>>
+    Roaring64MapSetBitForwardIterator;
+typedef BasicRoaring64MapSetBitBiDirectionalIterator<
+    std::map<uint32_t, Roaring>>
+    Roaring64MapSetBitBiDirectionalIterator;
+
+/**
+ * Same as Roaring64Map, with the bitmaps of the high 32 bits kept in a
+ * sorted vector rather than a tree: faster lookups and iteration when there
+ * are few distinct high 32 bits.
+ */
+typedef BasicRoaring64Map<Roaring64FlatStorage> Roaring64FlatMap;
+
+/**
+ * A read-only 64-bit bitmap backed by a buffer written by
+ * BasicRoaring64Map::writeFrozen(). The containers are not copied: only
+ * their index is built when the view is created, and queries read the
+ * buffer directly. The buffer must be aligned by 32 bytes, and must not be
+ * freed or modified while the view exists.
+ */
+class Roaring64MapFrozenView {
+    typedef api::roaring_bitmap_t roaring_bitmap_t;
+
+  public:
+    /**
+     * Creates an empty view.
+     */
+    Roaring64MapFrozenView() = default;
+
+    /**
+     * Creates a view of the length bytes at buf. Throws std::runtime_error
+     * (or terminates, without exceptions) if they are not a valid frozen
+     * 64-bit bitmap. See also reset().
+     */
+    Roaring64MapFrozenView(const char *buf, size_t length) {
+        if (!reset(buf, length)) {
+#if ROARING_EXCEPTIONS
+            throw std::runtime_error("invalid frozen 64-bit bitmap");
+#else
+            ROARING_TERMINATE("invalid frozen 64-bit bitmap");
+#endif
+        }
+    }
+
+    Roaring64MapFrozenView(const Roaring64MapFrozenView &) = delete;
+    Roaring64MapFrozenView &operator=(const Roaring64MapFrozenView &) = delete;
+
+    Roaring64MapFrozenView(Roaring64MapFrozenView &&r) noexcept
+        : keys(std::move(r.keys)), bitmaps(std::move(r.bitmaps)) {
+        r.keys.clear();
+        r.bitmaps.clear();
+    }
+
+    ~Roaring64MapFrozenView() { clear(); }
+
+    /**
+     * Makes this a view of the length bytes at buf. Returns false, leaving
+     * the view empty, if they are not a valid frozen 64-bit bitmap.
+     */
+    bool reset(const char *buf, size_t length) {
+        clear();
+        if (!init(buf, length)) {
+            clear();
+            return false;
+        }
+        return true;
+    }
+
+    /**
+     * Check if value x is present
+     */
+    bool contains(uint64_t x) const {
+        size_t i = position(highBytes(x));
+        return i < keys.size() && keys[i] == highBytes(x) &&
+               api::roaring_bitmap_contains(bitmaps[i], lowBytes(x));
+    }
+
+    /**
+     * Returns the number of values in the bitmap. The cardinality of a full
+     * bitmap (2^64) cannot be represented, but is not expected in a view.
+     */
+    uint64_t cardinality() const {
+        uint64_t card = 0;
+        for (const roaring_bitmap_t *bitmap : bitmaps) {
+            card += api::roaring_bitmap_get_cardinality(bitmap);
+        }
+        return card;
+    }
+
+    bool isEmpty() const { return bitmaps.empty(); }
+
+    /**
+     * Return the smallest value, or the largest 64-bit integer if empty.
+     */
+    uint64_t minimum() const {
+        if (bitmaps.empty()) return (std::numeric_limits<uint64_t>::max)();
+        return uniteBytes(keys.front(),
+                          api::roaring_bitmap_minimum(bitmaps.front()));
+    }
+
+    /**
+     * Return the largest value, or zero if empty.
+     */
+    uint64_t maximum() const {
+        if (bitmaps.empty()) return 0;
+        return uniteBytes(keys.back(),
+                          api::roaring_bitmap_maximum(bitmaps.back()));
+    }
+
+    /**
+     * Returns the number of integers that are smaller or equal to x.
+     */
+    uint64_t rank(uint64_t x) const {
+        const size_t end = position(highBytes(x));
+        uint64_t result = 0;
+        for (size_t i = 0; i < end; i++) {
+            result += api::roaring_bitmap_get_cardinality(bitmaps[i]);
+        }
+        if (end < keys.size() && keys[end] == highBytes(x)) {
+            result += api::roaring_bitmap_rank(bitmaps[end], lowBytes(x));
+        }
+        return result;
+    }
+
+    /**
+     * If the cardinality of the bitmap is strictly greater than rnk, sets
+     * element to the element of given rank and returns true. Otherwise,
+     * returns false.
+     */
+    bool select(uint64_t rnk, uint64_t *element) const {
+        for (size_t i = 0; i < bitmaps.size(); i++) {
+            const uint64_t sub_cardinality =
+                api::roaring_bitmap_get_cardinality(bitmaps[i]);
+            if (rnk < sub_cardinality) {
+                uint32_t low_bits;
+                if (!api::roaring_bitmap_select(bitmaps[i], (uint32_t)rnk,
+                                                &low_bits))
+                    return false;
+                *element = uniteBytes(keys[i], low_bits);
+                return true;
+            }
+            rnk -= sub_cardinality;
+        }
+        return false;
+    }
+
+    /**
+     * Calls iterator on the values, in increasing order, until it returns
+     * false.
+     */
+    void iterate(api::roaring_iterator64 iterator, void *ptr) const {
+        for (size_t i = 0; i < bitmaps.size(); i++) {
+            if (!api::roaring_iterate64(bitmaps[i], iterator,
+                                        uint64_t(keys[i]) << 32, ptr))
+                return;
+        }
+    }
+
+    /**
+     * Writes the values to ans, which must have room for cardinality()
+     * values.
+     */
+    void toUint64Array(uint64_t *ans) const {
+        std::vector<uint32_t> low_bits;
+        for (size_t i = 0; i < bitmaps.size(); i++) {
+            low_bits.resize(api::roaring_bitmap_get_cardinality(bitmaps[i]));
+            api::roaring_bitmap_to_uint32_array(bitmaps[i], low_bits.data());
+            for (uint32_t low : low_bits) *ans++ = uniteBytes(keys[i], low);
+        }
+    }
+
+    /**
+     * Copies the view into a regular, mutable bitmap.
+     */
+    template <class Storage>
+    void copyTo(BasicRoaring64Map<Storage> &r) const {
+        r.clear();
+        for (size_t i = 0; i < bitmaps.size(); i++) {
+            Roaring copy(api::roaring_bitmap_copy(bitmaps[i]));
+            r.roarings.insert(r.roarings.end(),
+                              std::make_pair(keys[i], std::move(copy)));
+        }
+    }
+
+  private:
+    bool init(const char *buf, size_t length) {
+        if ((uintptr_t)buf % 32 != 0) return false;
+        const size_t fixed = 2 * sizeof(uint32_t) + sizeof(uint64_t);
+        if (length < fixed) return false;
+        uint32_t cookie;
+        std::memcpy(&cookie, buf, sizeof(uint32_t));
+        if (cookie != Roaring64MapFrozenFormat::cookie) return false;
+        uint64_t n;
+        std::memcpy(&n, buf + 2 * sizeof(uint32_t), sizeof(uint64_t));
+        // each bitmap takes at least 20 bytes of header
+        if (n > (length - fixed) / 20) return false;
+        const size_t header_size =
+            Roaring64MapFrozenFormat::headerSizeInBytes(n);
+        if (header_size > length) return false;
+        const char *key_ptr = buf + fixed;
+        const char *offset_ptr = buf + header_size - 2 * n * sizeof(uint64_t);
+        const char *length_ptr = offset_ptr + n * sizeof(uint64_t);
+        keys.resize((size_t)n);
+        bitmaps.reserve((size_t)n);
+        for (size_t i = 0; i < n; i++) {
+            std::memcpy(&keys[i], key_ptr + i * sizeof(uint32_t),
+                        sizeof(uint32_t));
+            if (i > 0 && keys[i] <= keys[i - 1]) return false;
+            uint64_t offset, size;
+            std::memcpy(&offset, offset_ptr + i * sizeof(uint64_t),
+                        sizeof(uint64_t));
+            std::memcpy(&size, length_ptr + i * sizeof(uint64_t),
+                        sizeof(uint64_t));
+            if (offset < header_size || offset > length ||
+                size > length - offset)
+                return false;
+            const roaring_bitmap_t *bitmap = api::roaring_bitmap_frozen_view(
+                buf + offset, (size_t)size);
+            if (bitmap == nullptr) return false;
+            bitmaps.push_back(bitmap);
+        }
+        return true;
+    }
+
+    void clear() {
+        for (const roaring_bitmap_t *bitmap : bitmaps) {
+            api::roaring_bitmap_free(bitmap);
+        }
+        bitmaps.clear();
+        keys.clear();
+    }
+
+    // index of the first key that is not smaller than high
+    size_t position(uint32_t high) const {
+        return std::lower_bound(keys.begin(), keys.end(), high) - keys.begin();
+    }
+
+    static uint32_t highBytes(const uint64_t in) { return uint32_t(in >> 32); }
+    static uint32_t lowBytes(const uint64_t in) { return uint32_t(in); }
+    static uint64_t uniteBytes(const uint32_t highBytes,
+                               const uint32_t lowBytes) {
+        return (uint64_t(highBytes) << 32) | uint64_t(lowBytes);
+    }
+
+    std::vector<uint32_t> keys{};
+    std::vector<const roaring_bitmap_t *> bitmaps{};
+};
+
 }  // namespace roaring
 
 #endif /* INCLUDE_ROARING_64_MAP_HH_ */
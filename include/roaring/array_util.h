@@ -133,6 +133,27 @@ int32_t intersect_vector16_cardinality(const uint16_t *__restrict__ A,
                                        const uint16_t *__restrict__ B,
                                        size_t s_b);
 
+#if CROARING_COMPILER_SUPPORTS_AVX512
+/**
+ * AVX-512 variant of intersect_vector16: blocks of 32 values from A are
+ * compared against blocks of 8 values from B, and the matches are
+ * compressed straight into C. Unlike intersect_vector16, it never writes
+ * past the end of the result, so C only needs the capacity of the
+ * minimum of s_a and s_b. Only call it when croaring_avx512() is true.
+ */
+int32_t intersect_vector16_avx512(const uint16_t *__restrict__ A, size_t s_a,
+                                  const uint16_t *__restrict__ B, size_t s_b,
+                                  uint16_t *C);
+
+/**
+ * Compute the cardinality of the intersection using AVX-512 instructions
+ */
+int32_t intersect_vector16_cardinality_avx512(const uint16_t *__restrict__ A,
+                                              size_t s_a,
+                                              const uint16_t *__restrict__ B,
+                                              size_t s_b);
+#endif
+
 /* Computes the intersection between one small and one large set of uint16_t.
  * Stores the result into buffer and return the number of elements. */
 int32_t intersect_skewed_uint16(const uint16_t *smallarray, size_t size_s,
@@ -234,6 +255,22 @@ size_t union_uint32_card(const uint32_t *set_1, size_t size_1,
 size_t fast_union_uint16(const uint16_t *set_1, size_t size_1, const uint16_t *set_2,
                     size_t size_2, uint16_t *buffer);
 
+/**
+ * Intersection of two sorted arrays with the fastest kernel for the running
+ * processor (see intersect_vector16 and intersect_vector16_avx512), which is
+ * selected once, on first use. C should have capacity greater than the
+ * minimum of s_a and s_b + 8, since the SSE kernel may write past the
+ * result.
+ */
+int32_t fast_intersect_uint16(const uint16_t *A, size_t s_a,
+                              const uint16_t *B, size_t s_b, uint16_t *C);
+
+/**
+ * Cardinality of the intersection, dispatched like fast_intersect_uint16.
+ */
+int32_t fast_intersect_uint16_cardinality(const uint16_t *A, size_t s_a,
+                                          const uint16_t *B, size_t s_b);
+
 
 bool memequals(const void *s1, const void *s2, size_t n);
 
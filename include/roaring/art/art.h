@@ -0,0 +1,111 @@
+/*
+ * art.h
+ *
+ * An adaptive radix tree (Leis et al., "The adaptive radix tree: ARTful
+ * indexing for main-memory databases", ICDE 2013) over keys of
+ * ART_KEY_BYTES bytes, ordered as big-endian integers. Each inner node holds
+ * 4, 16, 48 or 256 children depending on how many it has, and skips the key
+ * bytes shared by all its leaves (path compression). A lookup visits at most
+ * ART_KEY_BYTES inner nodes, and an insertion or a removal changes at most
+ * two of them, whatever the number of keys.
+ *
+ * The values are the leaves of the tree, and are allocated by the caller:
+ * a value starts with an art_val_t holding its key, and must be at least
+ * 2-byte aligned, since the tree marks the leaves with the low bit of their
+ * address.
+ */
+#ifndef INCLUDE_ROARING_ART_ART_H
+#define INCLUDE_ROARING_ART_ART_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define ART_KEY_BYTES 6
+
+#ifdef __cplusplus
+extern "C" { namespace roaring { namespace internal {
+#endif
+
+typedef uint8_t art_key_chunk_t;
+
+// an inner node, or a marked pointer to a value
+typedef void art_node_t;
+
+typedef struct art_val_s {
+    art_key_chunk_t key[ART_KEY_BYTES];
+} art_val_t;
+
+typedef struct art_s {
+    art_node_t *root;  // NULL when empty
+} art_t;
+
+static inline void art_init(art_t *art) { art->root = NULL; }
+
+static inline bool art_is_empty(const art_t *art) { return art->root == NULL; }
+
+/**
+ * Inserts val under key, which must not be in the tree yet. The key is
+ * copied to val. Returns false, leaving the tree unchanged, in case of
+ * allocation failure.
+ */
+bool art_insert(art_t *art, const art_key_chunk_t *key, art_val_t *val);
+
+/**
+ * Removes key from the tree and returns its value, or NULL if it is absent.
+ */
+art_val_t *art_erase(art_t *art, const art_key_chunk_t *key);
+
+/**
+ * Returns the value of key, or NULL if it is absent.
+ */
+art_val_t *art_find(const art_t *art, const art_key_chunk_t *key);
+
+/**
+ * Frees the inner nodes, but not the values, which the caller must free
+ * (before or after, the values are not read).
+ */
+void art_free(art_t *art);
+
+typedef struct art_iterator_frame_s {
+    art_node_t *node;
+    uint8_t child;  // key byte of the child being visited
+} art_iterator_frame_t;
+
+/**
+ * Visits the values in increasing order of their keys. Any change to the
+ * tree invalidates the iterators, except art_iterator_erase() on the
+ * iterator it is given.
+ */
+typedef struct art_iterator_s {
+    art_val_t *value;  // NULL past the end
+    uint8_t frame_count;
+    art_iterator_frame_t frames[ART_KEY_BYTES];  // path to value
+} art_iterator_t;
+
+/**
+ * Returns an iterator on the first value if first is true, on the last
+ * value otherwise.
+ */
+art_iterator_t art_init_iterator(const art_t *art, bool first);
+
+/**
+ * Moves to the next value. Returns false past the end.
+ */
+bool art_iterator_next(art_iterator_t *iterator);
+
+/**
+ * Returns an iterator on the first value whose key is not smaller than key.
+ */
+art_iterator_t art_lower_bound(const art_t *art, const art_key_chunk_t *key);
+
+/**
+ * Removes the value of the iterator from the tree, moves the iterator to
+ * the next value, and returns the removed value.
+ */
+art_val_t *art_iterator_erase(art_t *art, art_iterator_t *iterator);
+
+#ifdef __cplusplus
+} } }  // extern "C" { namespace roaring { namespace internal {
+#endif
+
+#endif  // INCLUDE_ROARING_ART_ART_H
@@ -154,6 +154,17 @@ size_t bitset_extract_setbits_avx2(const uint64_t *words, size_t length,
                                    uint32_t *out, size_t outcapacity,
                                    uint32_t base);
 
+#if CROARING_COMPILER_SUPPORTS_AVX512
+/*
+ * Same as bitset_extract_setbits_avx2, but decodes a full 64-bit word at
+ * a time using AVX-512 (VBMI2) compression. Only call it when
+ * croaring_avx512() is true.
+ */
+size_t bitset_extract_setbits_avx512(const uint64_t *words, size_t length,
+                                     uint32_t *out, size_t outcapacity,
+                                     uint32_t base);
+#endif
+
 /*
  * Given a bitset containing "length" 64-bit words, write out the position
  * of all the set bits to "out", values start at "base".
@@ -287,7 +298,7 @@ static inline __m256i popcount256(__m256i v) {
     const __m256i popcnt2 = _mm256_shuffle_epi8(lookupneg, hi);
     return _mm256_sad_epu8(popcnt1, popcnt2);
 }
-CROARING_UNTARGET_REGION
+CROARING_UNTARGET_AVX2
 
 CROARING_TARGET_AVX2
 /**
@@ -299,7 +310,7 @@ static inline void CSA(__m256i *h, __m256i *l, __m256i a, __m256i b,
     *h = _mm256_or_si256(_mm256_and_si256(a, b), _mm256_and_si256(u, c));
     *l = _mm256_xor_si256(u, c);
 }
-CROARING_UNTARGET_REGION
+CROARING_UNTARGET_AVX2
 
 CROARING_TARGET_AVX2
 /**
@@ -363,7 +374,7 @@ inline static uint64_t avx2_harley_seal_popcount256(const __m256i *data,
            (uint64_t)(_mm256_extract_epi64(total, 2)) +
            (uint64_t)(_mm256_extract_epi64(total, 3));
 }
-CROARING_UNTARGET_REGION
+CROARING_UNTARGET_AVX2
 
 #define AVXPOPCNTFNC(opname, avx_intrinsic)                                    \
     static inline uint64_t avx2_harley_seal_popcount256_##opname(              \
@@ -547,32 +558,62 @@ CROARING_UNTARGET_REGION
 
 CROARING_TARGET_AVX2
 AVXPOPCNTFNC(or, _mm256_or_si256)
-CROARING_UNTARGET_REGION
+CROARING_UNTARGET_AVX2
 
 CROARING_TARGET_AVX2
 AVXPOPCNTFNC(union, _mm256_or_si256)
-CROARING_UNTARGET_REGION
+CROARING_UNTARGET_AVX2
 
 CROARING_TARGET_AVX2
 AVXPOPCNTFNC(and, _mm256_and_si256)
-CROARING_UNTARGET_REGION
+CROARING_UNTARGET_AVX2
 
 CROARING_TARGET_AVX2
 AVXPOPCNTFNC(intersection, _mm256_and_si256)
-CROARING_UNTARGET_REGION
+CROARING_UNTARGET_AVX2
 
 CROARING_TARGET_AVX2
 AVXPOPCNTFNC (xor, _mm256_xor_si256)
-CROARING_UNTARGET_REGION
+CROARING_UNTARGET_AVX2
 
 CROARING_TARGET_AVX2
 AVXPOPCNTFNC(andnot, _mm256_andnot_si256)
-CROARING_UNTARGET_REGION
+CROARING_UNTARGET_AVX2
 
 /***
  * END Harley-Seal popcount functions.
  */
 
+#if CROARING_COMPILER_SUPPORTS_AVX512
+CROARING_AVX512_IGNORE_UNINITIALIZED
+CROARING_TARGET_AVX512
+/**
+ * Population count of "size" 512-bit words using the native VPOPCNTQ
+ * instruction; there is no need for Harley-Seal with AVX-512.
+ */
+static inline uint64_t avx512_vpopcount(const __m512i *data,
+                                        const uint64_t size) {
+    __m512i total = _mm512_setzero_si512();
+    const uint64_t limit = size - size % 4;
+    uint64_t i = 0;
+    for (; i < limit; i += 4) {
+        __m512i p1 = _mm512_popcnt_epi64(_mm512_loadu_si512(data + i));
+        __m512i p2 = _mm512_popcnt_epi64(_mm512_loadu_si512(data + i + 1));
+        __m512i p3 = _mm512_popcnt_epi64(_mm512_loadu_si512(data + i + 2));
+        __m512i p4 = _mm512_popcnt_epi64(_mm512_loadu_si512(data + i + 3));
+        total = _mm512_add_epi64(total, _mm512_add_epi64(p1, p2));
+        total = _mm512_add_epi64(total, _mm512_add_epi64(p3, p4));
+    }
+    for (; i < size; i++) {
+        total = _mm512_add_epi64(
+            total, _mm512_popcnt_epi64(_mm512_loadu_si512(data + i)));
+    }
+    return (uint64_t)_mm512_reduce_add_epi64(total);
+}
+CROARING_UNTARGET_AVX512
+CROARING_AVX512_RESTORE_UNINITIALIZED
+#endif  // CROARING_COMPILER_SUPPORTS_AVX512
+
 #endif  // CROARING_IS_X64
 
 #ifdef __cplusplus
@@ -402,6 +402,45 @@ inline int array_container_rank(const array_container_t *arr, uint16_t x) {
     }
 }
 
+/*
+ * Sets ans[i] to start_rank plus the number of values equal or smaller than
+ * the low 16 bits of begin[i], for the leading values of the sorted range
+ * [begin, end) that share the high 16 bits of *begin. Returns how many values
+ * were ranked.
+ */
+uint32_t array_container_rank_many(const array_container_t *arr,
+                                   uint64_t start_rank, const uint32_t *begin,
+                                   const uint32_t *end, uint64_t *ans);
+
+/*
+ * Sets element[i] to the value of rank begin[i], supposing that the first
+ * element has rank start_rank, for the leading ranks of the sorted range
+ * [begin, end) that fall within this container. Returns how many ranks were
+ * selected.
+ */
+uint32_t array_container_select_many(const array_container_t *arr,
+                                     uint32_t start_rank,
+                                     const uint32_t *begin,
+                                     const uint32_t *end, uint32_t *element);
+
+/*
+ * Sets results[i] to whether the low 16 bits of vals[i] are in the container.
+ * Probes that come in increasing order gallop forward from the previous one.
+ */
+void array_container_contains_many(const array_container_t *arr,
+                                   const uint32_t *vals, size_t n,
+                                   bool *results);
+
+/*
+ * Adds offset to all the values of the container. The values that stay below
+ * 1 << 16 go to *lo, the others (less 1 << 16) to *hi. Either of lo and hi may
+ * be NULL when those values are not wanted. A part without values is NULL.
+ * Returns false, leaving *lo and *hi unset, if an allocation fails.
+ */
+bool array_container_offset(const array_container_t *c,
+                            array_container_t **lo, array_container_t **hi,
+                            uint16_t offset);
+
 /* Returns the index of the first value equal or smaller than x, or -1 */
 inline int array_container_index_equalorlarger(const array_container_t *arr, uint16_t x) {
     const int32_t idx = binarySearch(arr->array, arr->cardinality, x);
@@ -489,6 +489,39 @@ uint16_t bitset_container_maximum(const bitset_container_t *container);
 /* Returns the number of values equal or smaller than x */
 int bitset_container_rank(const bitset_container_t *container, uint16_t x);
 
+/*
+ * Sets ans[i] to start_rank plus the number of values equal or smaller than
+ * the low 16 bits of begin[i], for the leading values of the sorted range
+ * [begin, end) that share the high 16 bits of *begin. Returns how many values
+ * were ranked.
+ */
+uint32_t bitset_container_rank_many(const bitset_container_t *container,
+                                    uint64_t start_rank,
+                                    const uint32_t *begin,
+                                    const uint32_t *end, uint64_t *ans);
+
+/*
+ * Sets element[i] to the value of rank begin[i], supposing that the first
+ * element has rank start_rank, for the leading ranks of the sorted range
+ * [begin, end) that fall within this container. Returns how many ranks were
+ * selected.
+ */
+uint32_t bitset_container_select_many(const bitset_container_t *container,
+                                      uint32_t start_rank,
+                                      const uint32_t *begin,
+                                      const uint32_t *end, uint32_t *element);
+
+/*
+ * Adds offset to all the values of the container. The values that stay below
+ * 1 << 16 go to *lo, the others (less 1 << 16) to *hi. Either of lo and hi may
+ * be NULL when those values are not wanted. A part without values is NULL.
+ * Returns false, leaving *lo and *hi unset, if an allocation fails.
+ * The parts are bitsets whatever their cardinality.
+ */
+bool bitset_container_offset(const bitset_container_t *c,
+                             bitset_container_t **lo, bitset_container_t **hi,
+                             uint16_t offset);
+
 /* Returns the index of the first value equal or larger than x, or -1 */
 int bitset_container_index_equalorlarger(const bitset_container_t *container, uint16_t x);
 
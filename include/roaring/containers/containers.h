@@ -59,7 +59,7 @@ extern "C" { namespace roaring { namespace internal {
 STRUCT_CONTAINER(shared_container_s) {
     container_t *container;
     uint8_t typecode;
-    uint32_t counter;  // to be managed atomically
+    croaring_refcount_t counter;  // see croaring_refcount_inc/dec
 };
 
 typedef struct shared_container_s shared_container_t;
@@ -592,6 +592,35 @@ static inline bool container_contains(
     }
 }
 
+/**
+ * Sets results[i] to whether the low 16 bits of vals[i] are in the container,
+ * reusing the search position between probes that come in increasing order.
+ */
+static inline void container_contains_many(
+    const container_t *c, uint8_t typecode,
+    const uint32_t *vals, size_t n, bool *results
+){
+    c = container_unwrap_shared(c, &typecode);
+    switch (typecode) {
+        case BITSET_CONTAINER_TYPE:
+            for (size_t i = 0; i < n; i++) {
+                results[i] = bitset_container_get(const_CAST_bitset(c),
+                                                  (uint16_t)vals[i]);
+            }
+            return;
+        case ARRAY_CONTAINER_TYPE:
+            array_container_contains_many(const_CAST_array(c),
+                                          vals, n, results);
+            return;
+        case RUN_CONTAINER_TYPE:
+            run_container_contains_many(const_CAST_run(c), vals, n, results);
+            return;
+        default:
+            assert(false);
+            __builtin_unreachable();
+    }
+}
+
 /**
  * Check whether a range of values from range_start (included) to range_end (excluded)
  * is in a container, requires a typecode
@@ -2291,6 +2320,143 @@ static inline int container_rank(
     return false;
 }
 
+/*
+ * Ranks the leading values of the sorted range [begin, end) that share the
+ * high 16 bits of *begin, counting from start_rank: ans[i] is start_rank plus
+ * the number of values of the container equal or smaller than the low 16 bits
+ * of begin[i]. Returns how many values were ranked.
+ */
+static inline uint32_t container_rank_many(
+    const container_t *c, uint8_t type,
+    uint64_t start_rank, const uint32_t *begin, const uint32_t *end,
+    uint64_t *ans
+){
+    c = container_unwrap_shared(c, &type);
+    switch (type) {
+        case BITSET_CONTAINER_TYPE:
+            return bitset_container_rank_many(const_CAST_bitset(c),
+                                              start_rank, begin, end, ans);
+        case ARRAY_CONTAINER_TYPE:
+            return array_container_rank_many(const_CAST_array(c),
+                                             start_rank, begin, end, ans);
+        case RUN_CONTAINER_TYPE:
+            return run_container_rank_many(const_CAST_run(c),
+                                           start_rank, begin, end, ans);
+        default:
+            assert(false);
+            __builtin_unreachable();
+    }
+    assert(false);
+    __builtin_unreachable();
+    return 0;
+}
+
+/*
+ * Selects the leading ranks of the sorted range [begin, end) that fall within
+ * the container, supposing that its first element has rank start_rank:
+ * element[i] is the low 16 bits of the value of rank begin[i]. Returns how
+ * many ranks were selected.
+ */
+static inline uint32_t container_select_many(
+    const container_t *c, uint8_t type,
+    uint32_t start_rank, const uint32_t *begin, const uint32_t *end,
+    uint32_t *element
+){
+    c = container_unwrap_shared(c, &type);
+    switch (type) {
+        case BITSET_CONTAINER_TYPE:
+            return bitset_container_select_many(const_CAST_bitset(c),
+                                                start_rank, begin, end,
+                                                element);
+        case ARRAY_CONTAINER_TYPE:
+            return array_container_select_many(const_CAST_array(c),
+                                               start_rank, begin, end,
+                                               element);
+        case RUN_CONTAINER_TYPE:
+            return run_container_select_many(const_CAST_run(c),
+                                             start_rank, begin, end,
+                                             element);
+        default:
+            assert(false);
+            __builtin_unreachable();
+    }
+    assert(false);
+    __builtin_unreachable();
+    return 0;
+}
+
+/*
+ * Adds offset to all the values of the container, which lands across two
+ * keys: the values that stay below 1 << 16 go to *lo, the others (less
+ * 1 << 16) to *hi. Either of lo and hi may be NULL when those values are not
+ * wanted. A part without values is NULL. Returns false, leaving *lo and *hi
+ * unset, if an allocation fails.
+ */
+static inline bool container_add_offset(
+    const container_t *c, uint8_t type,
+    container_t **lo, uint8_t *lo_type,
+    container_t **hi, uint8_t *hi_type,
+    uint16_t offset
+){
+    assert(offset != 0);
+    c = container_unwrap_shared(c, &type);
+    switch (type) {
+        case ARRAY_CONTAINER_TYPE:
+            *lo_type = *hi_type = ARRAY_CONTAINER_TYPE;
+            return array_container_offset(const_CAST_array(c),
+                                          (array_container_t **)lo,
+                                          (array_container_t **)hi, offset);
+        case RUN_CONTAINER_TYPE:
+            *lo_type = *hi_type = RUN_CONTAINER_TYPE;
+            return run_container_offset(const_CAST_run(c),
+                                        (run_container_t **)lo,
+                                        (run_container_t **)hi, offset);
+        case BITSET_CONTAINER_TYPE: {
+            bitset_container_t *parts[2] = {NULL, NULL};
+            if (!bitset_container_offset(const_CAST_bitset(c),
+                                         lo ? &parts[0] : NULL,
+                                         hi ? &parts[1] : NULL, offset)) {
+                return false;
+            }
+            container_t *outs[2] = {parts[0], parts[1]};
+            uint8_t out_types[2] = {BITSET_CONTAINER_TYPE,
+                                    BITSET_CONTAINER_TYPE};
+            for (int k = 0; k < 2; k++) {
+                if (parts[k] == NULL ||
+                    parts[k]->cardinality > DEFAULT_MAX_SIZE) {
+                    continue;
+                }
+                array_container_t *array =
+                    array_container_from_bitset(parts[k]);
+                if (array == NULL) {
+                    for (int j = 0; j < 2; j++) {
+                        if (outs[j] != NULL) {
+                            container_free(outs[j], out_types[j]);
+                        }
+                    }
+                    return false;
+                }
+                bitset_container_free(parts[k]);
+                outs[k] = array;
+                out_types[k] = ARRAY_CONTAINER_TYPE;
+            }
+            if (lo != NULL) {
+                *lo = outs[0];
+                *lo_type = out_types[0];
+            }
+            if (hi != NULL) {
+                *hi = outs[1];
+                *hi_type = out_types[1];
+            }
+            return true;
+        }
+        default:
+            assert(false);
+            __builtin_unreachable();
+    }
+    return false;
+}
+
 /**
  * Add all values in range [min, max] to a given container.
  *
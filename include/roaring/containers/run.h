@@ -559,6 +559,45 @@ inline uint16_t run_container_maximum(const run_container_t *run) {
 /* Returns the number of values equal or smaller than x */
 int run_container_rank(const run_container_t *arr, uint16_t x);
 
+/*
+ * Sets ans[i] to start_rank plus the number of values equal or smaller than
+ * the low 16 bits of begin[i], for the leading values of the sorted range
+ * [begin, end) that share the high 16 bits of *begin. Returns how many values
+ * were ranked.
+ */
+uint32_t run_container_rank_many(const run_container_t *container,
+                                 uint64_t start_rank, const uint32_t *begin,
+                                 const uint32_t *end, uint64_t *ans);
+
+/*
+ * Sets element[i] to the value of rank begin[i], supposing that the first
+ * element has rank start_rank, for the leading ranks of the sorted range
+ * [begin, end) that fall within this container. Returns how many ranks were
+ * selected.
+ */
+uint32_t run_container_select_many(const run_container_t *container,
+                                   uint32_t start_rank, const uint32_t *begin,
+                                   const uint32_t *end, uint32_t *element);
+
+/*
+ * Sets results[i] to whether the low 16 bits of vals[i] are in the container.
+ * Probes that come in increasing order resume from the run of the previous
+ * one.
+ */
+void run_container_contains_many(const run_container_t *run,
+                                 const uint32_t *vals, size_t n,
+                                 bool *results);
+
+/*
+ * Adds offset to all the values of the container. The values that stay below
+ * 1 << 16 go to *lo, the others (less 1 << 16) to *hi. Either of lo and hi may
+ * be NULL when those values are not wanted. A part without values is NULL.
+ * Returns false, leaving *lo and *hi unset, if an allocation fails.
+ */
+bool run_container_offset(const run_container_t *c,
+                          run_container_t **lo, run_container_t **hi,
+                          uint16_t offset);
+
 /* Returns the index of the first run containing a value at least as large as x, or -1 */
 inline int run_container_index_equalorlarger(const run_container_t *arr, uint16_t x) {
     int32_t index = interleavedBinarySearch(arr->runs, arr->n_runs, x);
@@ -65,9 +65,20 @@ enum croaring_instruction_set {
   CROARING_BMI1 = 0x20,
   CROARING_BMI2 = 0x40,
   CROARING_ALTIVEC = 0x80,
+  CROARING_AVX512F = 0x100,
+  CROARING_AVX512DQ = 0x200,
+  CROARING_AVX512BW = 0x400,
+  CROARING_AVX512VBMI2 = 0x800,
+  CROARING_AVX512BITALG = 0x1000,
+  CROARING_AVX512VPOPCNTDQ = 0x2000,
   CROARING_UNINITIALIZED = 0x8000
 };
 
+// The subset of AVX-512 our kernels rely upon (Ice Lake and later).
+#define CROARING_AVX512_REQUIRED                                          \
+  (CROARING_AVX512F | CROARING_AVX512DQ | CROARING_AVX512BW |             \
+   CROARING_AVX512VBMI2 | CROARING_AVX512BITALG | CROARING_AVX512VPOPCNTDQ)
+
 #if defined(__PPC64__)
 
 static inline uint32_t dynamic_croaring_detect_supported_architectures() {
@@ -118,6 +129,18 @@ static inline void cpuid(uint32_t *eax, uint32_t *ebx, uint32_t *ecx,
 #endif
 }
 
+// Reads the extended control register XCR0, which tells us which register
+// states the operating system saves on context switches.
+static inline uint64_t xgetbv() {
+#if defined(_MSC_VER)
+  return _xgetbv(0);
+#else
+  uint32_t xcr0_lo, xcr0_hi;
+  __asm__("xgetbv\n\t" : "=a" (xcr0_lo), "=d" (xcr0_hi) : "c" (0));
+  return xcr0_lo | ((uint64_t)xcr0_hi << 32);
+#endif
+}
+
 static inline uint32_t dynamic_croaring_detect_supported_architectures() {
   uint32_t eax, ebx, ecx, edx;
   uint32_t host_isa = 0x0;
@@ -125,8 +148,17 @@ static inline uint32_t dynamic_croaring_detect_supported_architectures() {
   static uint32_t cpuid_avx2_bit = 1 << 5;      ///< @private Bit 5 of EBX for EAX=0x7
   static uint32_t cpuid_bmi1_bit = 1 << 3;      ///< @private bit 3 of EBX for EAX=0x7
   static uint32_t cpuid_bmi2_bit = 1 << 8;      ///< @private bit 8 of EBX for EAX=0x7
+  static uint32_t cpuid_avx512f_bit = 1 << 16;  ///< @private bit 16 of EBX for EAX=0x7
+  static uint32_t cpuid_avx512dq_bit = 1 << 17; ///< @private bit 17 of EBX for EAX=0x7
+  static uint32_t cpuid_avx512bw_bit = 1 << 30; ///< @private bit 30 of EBX for EAX=0x7
+  static uint32_t cpuid_avx512vbmi2_bit = 1 << 6;      ///< @private bit 6 of ECX for EAX=0x7
+  static uint32_t cpuid_avx512bitalg_bit = 1 << 12;    ///< @private bit 12 of ECX for EAX=0x7
+  static uint32_t cpuid_avx512vpopcntdq_bit = 1 << 14; ///< @private bit 14 of ECX for EAX=0x7
   static uint32_t cpuid_sse42_bit = 1 << 20;    ///< @private bit 20 of ECX for EAX=0x1
   static uint32_t cpuid_pclmulqdq_bit = 1 << 1; ///< @private bit  1 of ECX for EAX=0x1
+  static uint32_t cpuid_osxsave_bit = 1 << 27;  ///< @private bit 27 of ECX for EAX=0x1
+  // XMM, YMM, opmask and both halves of the ZMM register file
+  static uint64_t xcr0_avx512_mask = 0xe6;      ///< @private bits 1,2,5,6,7 of XCR0
   // ECX for EAX=0x7
   eax = 0x7;
   ecx = 0x0;
@@ -142,6 +174,30 @@ static inline uint32_t dynamic_croaring_detect_supported_architectures() {
     host_isa |= CROARING_BMI2;
   }
 
+  if (ebx & cpuid_avx512f_bit) {
+    host_isa |= CROARING_AVX512F;
+  }
+
+  if (ebx & cpuid_avx512dq_bit) {
+    host_isa |= CROARING_AVX512DQ;
+  }
+
+  if (ebx & cpuid_avx512bw_bit) {
+    host_isa |= CROARING_AVX512BW;
+  }
+
+  if (ecx & cpuid_avx512vbmi2_bit) {
+    host_isa |= CROARING_AVX512VBMI2;
+  }
+
+  if (ecx & cpuid_avx512bitalg_bit) {
+    host_isa |= CROARING_AVX512BITALG;
+  }
+
+  if (ecx & cpuid_avx512vpopcntdq_bit) {
+    host_isa |= CROARING_AVX512VPOPCNTDQ;
+  }
+
   // EBX for EAX=0x1
   eax = 0x1;
   cpuid(&eax, &ebx, &ecx, &edx);
@@ -154,6 +210,15 @@ static inline uint32_t dynamic_croaring_detect_supported_architectures() {
     host_isa |= CROARING_PCLMULQDQ;
   }
 
+  // The CPU may support AVX-512 while the operating system does not
+  // preserve the ZMM registers, in which case we must not use them.
+  if ((host_isa & CROARING_AVX512_REQUIRED) != 0) {
+    if (((ecx & cpuid_osxsave_bit) == 0) ||
+        ((xgetbv() & xcr0_avx512_mask) != xcr0_avx512_mask)) {
+      host_isa &= ~(uint32_t)CROARING_AVX512_REQUIRED;
+    }
+  }
+
   return host_isa;
 }
 #else // fallback
@@ -212,6 +277,17 @@ static inline bool croaring_avx2() {
 }
 #endif
 
+#if defined(ROARING_DISABLE_AVX) || defined(ROARING_DISABLE_AVX512)
+static inline bool croaring_avx512() {
+  return false;
+}
+#else
+static inline bool croaring_avx512() {
+  return (croaring_detect_supported_architectures() & CROARING_AVX512_REQUIRED)
+         == CROARING_AVX512_REQUIRED;
+}
+#endif
+
 
 #else // defined(__x86_64__) || defined(_M_AMD64) // x64
 
@@ -219,6 +295,10 @@ static inline bool croaring_avx2() {
   return false;
 }
 
+static inline bool croaring_avx512() {
+  return false;
+}
+
 static inline uint32_t croaring_detect_supported_architectures() {
     // no runtime dispatch
     return dynamic_croaring_detect_supported_architectures();
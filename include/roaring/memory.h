@@ -0,0 +1,102 @@
+/*
+ * memory.h
+ *
+ */
+
+#ifndef INCLUDE_ROARING_MEMORY_H_
+#define INCLUDE_ROARING_MEMORY_H_
+
+#include <stddef.h>  // for `size_t`
+
+#ifdef __cplusplus
+extern "C" {  // allocation hooks are in global scope, like portability.h
+#endif
+
+typedef void* (*roaring_malloc_p)(size_t);
+typedef void* (*roaring_realloc_p)(void*, size_t);
+typedef void* (*roaring_calloc_p)(size_t, size_t);
+typedef void (*roaring_free_p)(void*);
+typedef void* (*roaring_aligned_malloc_p)(size_t alignment, size_t size);
+typedef void (*roaring_aligned_free_p)(void*);
+
+/**
+ * Allocation functions used by the library for everything it allocates:
+ * bitmaps, their containers and all temporary buffers. The semantics are
+ * those of the standard C functions; aligned_malloc takes the alignment
+ * first (a power of two) and its memory is released with aligned_free.
+ */
+typedef struct roaring_memory_s {
+    roaring_malloc_p malloc;
+    roaring_realloc_p realloc;
+    roaring_calloc_p calloc;
+    roaring_free_p free;
+    roaring_aligned_malloc_p aligned_malloc;
+    roaring_aligned_free_p aligned_free;
+} roaring_memory_t;
+
+/**
+ * Replaces the allocation functions used by the library. All six hooks must
+ * be set. Call it before creating any bitmap: memory allocated with the
+ * previous hooks would otherwise be released with the new ones. This
+ * function is not thread-safe.
+ */
+void roaring_init_memory_hook(roaring_memory_t memory_hook);
+
+/**
+ * Restores the standard C allocation functions.
+ */
+void roaring_reset_memory_hook(void);
+
+/**
+ * An arena hands out memory by bumping a pointer through a few large
+ * chunks, and releases all of it at once. It is meant for "scratch" bitmaps:
+ * the temporary results of a query, which are then dropped together.
+ */
+typedef struct roaring_arena_s roaring_arena_t;
+
+/**
+ * Creates an arena whose first chunk holds chunk_size bytes; further chunks
+ * are allocated, larger and larger, when needed. The chunks come from the
+ * memory hooks. Returns NULL in case of failure.
+ */
+roaring_arena_t *roaring_arena_create(size_t chunk_size);
+
+/**
+ * Releases everything allocated from the arena at once, invalidating all
+ * the bitmaps built in it. The largest chunk is kept for reuse.
+ */
+void roaring_arena_reset(roaring_arena_t *arena);
+
+/**
+ * Releases the arena and all its memory.
+ */
+void roaring_arena_free(roaring_arena_t *arena);
+
+/**
+ * Makes the arena current on the calling thread (NULL goes back to the
+ * memory hooks) and returns the previously current arena, if any.
+ *
+ * While an arena is current, every block the library allocates on this
+ * thread comes from the arena, whichever bitmap it is for, and releasing
+ * a block of the arena does nothing: freeing a scratch bitmap is optional.
+ * Blocks allocated before, from the hooks, are still released normally.
+ *
+ * Scratch bitmaps may be read from anywhere until the arena is reset, but
+ * they must only be modified or freed while their arena is current, and
+ * their containers must not be shared with copy-on-write bitmaps that
+ * outlive the arena.
+ */
+roaring_arena_t *roaring_arena_set_current(roaring_arena_t *arena);
+
+void* roaring_malloc(size_t);
+void* roaring_realloc(void*, size_t);
+void* roaring_calloc(size_t, size_t);
+void roaring_free(void*);
+void* roaring_aligned_malloc(size_t alignment, size_t size);
+void roaring_aligned_free(void*);
+
+#ifdef __cplusplus
+}  // extern "C" {
+#endif
+
+#endif  // INCLUDE_ROARING_MEMORY_H_
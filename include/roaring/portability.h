@@ -21,6 +21,7 @@
 #endif // !(defined(_XOPEN_SOURCE)) || (_XOPEN_SOURCE < 700)
 
 #include "isadetection.h"
+#include "memory.h"
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdlib.h>  // will provide posix_memalign with _POSIX_C_SOURCE as defined above
@@ -284,14 +285,162 @@ static inline int hamming(uint64_t x) {
 #endif
 
 #define CROARING_TARGET_AVX2 CROARING_TARGET_REGION("avx2,bmi,pclmul,lzcnt")
+#define CROARING_UNTARGET_AVX2 CROARING_UNTARGET_REGION
 
 #ifdef __AVX2__
 // No need for runtime dispatching.
 // It is unnecessary and harmful to old clang to tag regions.
 #undef CROARING_TARGET_AVX2
 #define CROARING_TARGET_AVX2
-#undef CROARING_UNTARGET_REGION
-#define CROARING_UNTARGET_REGION
+#undef CROARING_UNTARGET_AVX2
+#define CROARING_UNTARGET_AVX2
+#endif
+
+// The AVX-512 kernels assume Ice Lake or better: besides the foundation
+// (F, DQ, BW) they use VBMI2 compression and native 64-bit popcounts.
+#ifdef CROARING_IS_X64
+#ifndef CROARING_COMPILER_SUPPORTS_AVX512
+#if defined(__clang__)
+#define CROARING_COMPILER_SUPPORTS_AVX512 1
+#elif defined(__GNUC__) && (__GNUC__ >= 8)
+#define CROARING_COMPILER_SUPPORTS_AVX512 1
+#elif defined(_MSC_VER) && (_MSC_VER >= 1920)
+#define CROARING_COMPILER_SUPPORTS_AVX512 1
+#endif
+#endif // CROARING_COMPILER_SUPPORTS_AVX512
+#endif // CROARING_IS_X64
+#ifndef CROARING_COMPILER_SUPPORTS_AVX512
+#define CROARING_COMPILER_SUPPORTS_AVX512 0
+#endif
+
+#define CROARING_TARGET_AVX512 CROARING_TARGET_REGION("avx2,bmi,bmi2,pclmul,lzcnt,popcnt,avx512f,avx512dq,avx512bw,avx512vbmi2,avx512bitalg,avx512vpopcntdq")
+#define CROARING_UNTARGET_AVX512 CROARING_UNTARGET_REGION
+
+// Declares a static function pointer "name" initially set to "resolver".
+// The resolver picks the best kernel for the running processor, stores it
+// in "name" and forwards the call: later calls go straight to the kernel,
+// without checking the instruction sets again. The pointer is atomic for the
+// same reason as the buffer in croaring_detect_supported_architectures().
+#ifdef CROARING_IS_X64
+#if defined(__cplusplus)
+#define CROARING_DISPATCH_POINTER(type, name, resolver) \
+  static std::atomic<type> name{resolver}
+#elif defined(_MSC_VER) && !defined(__clang__)
+#define CROARING_DISPATCH_POINTER(type, name, resolver) \
+  static type name = resolver
+#else
+#define CROARING_DISPATCH_POINTER(type, name, resolver) \
+  static _Atomic(type) name = resolver
+#endif
+#endif // CROARING_IS_X64
+
+// Reference counts of shared (copy-on-write) containers. Bitmaps sharing a
+// container may live in different threads (see roaring_bitmap_snapshot), so
+// the count is updated atomically. croaring_refcount_dec returns true when
+// the count falls to zero: the caller then holds the last reference.
+// croaring_lock_t is a spin lock (zero-initialized means unlocked), meant for
+// short critical sections such as those of roaring_concurrent_bitmap_t.
+// While it waits, croaring_cpu_relax tells the core (and its hyperthread
+// sibling) that it is spinning.
+#if defined(_MSC_VER) && !defined(__clang__)
+static inline void croaring_cpu_relax(void) {
+#if defined(_M_X64) || defined(_M_IX86)
+  _mm_pause();
+#elif defined(_M_ARM64) || defined(_M_ARM)
+  __yield();
+#endif
+}
+typedef volatile long croaring_refcount_t;
+static inline void croaring_refcount_inc(croaring_refcount_t *val) {
+  _InterlockedIncrement(val);
+}
+static inline bool croaring_refcount_dec(croaring_refcount_t *val) {
+  return _InterlockedDecrement(val) == 0;
+}
+static inline uint32_t croaring_refcount_get(const croaring_refcount_t *val) {
+  return (uint32_t)*val;
+}
+typedef volatile long croaring_lock_t;
+static inline void croaring_lock(croaring_lock_t *lock) {
+  while (_InterlockedExchange(lock, 1) != 0) {
+    while (*lock != 0) croaring_cpu_relax();
+  }
+}
+static inline void croaring_unlock(croaring_lock_t *lock) {
+  _InterlockedExchange(lock, 0);
+}
+#elif defined(__GNUC__) || defined(__clang__)
+static inline void croaring_cpu_relax(void) {
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_ia32_pause();
+#elif defined(__aarch64__) || (defined(__arm__) && __ARM_ARCH >= 7)
+  __asm__ __volatile__("yield");
+#endif
+}
+typedef uint32_t croaring_refcount_t;
+static inline void croaring_refcount_inc(croaring_refcount_t *val) {
+  // a new reference can only be made from an existing one: no ordering needed
+  __atomic_fetch_add(val, 1, __ATOMIC_RELAXED);
+}
+static inline bool croaring_refcount_dec(croaring_refcount_t *val) {
+  // the last owner must see the writes of all the others before freeing
+  return __atomic_fetch_sub(val, 1, __ATOMIC_ACQ_REL) == 1;
+}
+static inline uint32_t croaring_refcount_get(const croaring_refcount_t *val) {
+  return __atomic_load_n(val, __ATOMIC_ACQUIRE);
+}
+typedef bool croaring_lock_t;
+static inline void croaring_lock(croaring_lock_t *lock) {
+  while (__atomic_test_and_set(lock, __ATOMIC_ACQUIRE)) {
+    // wait without writing to the cache line until the lock looks free
+    while (__atomic_load_n(lock, __ATOMIC_RELAXED)) croaring_cpu_relax();
+  }
+}
+static inline void croaring_unlock(croaring_lock_t *lock) {
+  __atomic_clear(lock, __ATOMIC_RELEASE);
+}
+#else
+// No atomic primitive known for this compiler: shared containers must then
+// not be used from several threads, and roaring_concurrent_bitmap_create
+// fails. The lock below only serves single-threaded builds.
+#define CROARING_NO_ATOMICS 1
+typedef uint32_t croaring_refcount_t;
+static inline void croaring_refcount_inc(croaring_refcount_t *val) {
+  *val += 1;
+}
+static inline bool croaring_refcount_dec(croaring_refcount_t *val) {
+  *val -= 1;
+  return *val == 0;
+}
+static inline uint32_t croaring_refcount_get(const croaring_refcount_t *val) {
+  return *val;
+}
+typedef bool croaring_lock_t;
+static inline void croaring_lock(croaring_lock_t *lock) { *lock = true; }
+static inline void croaring_unlock(croaring_lock_t *lock) { *lock = false; }
+#endif
+
+#if defined(__GNUC__) && !defined(__clang__)
+// Some GCC versions wrongly report the _mm512_undefined_* values used inside
+// their own intrinsic headers as uninitialized.
+#define CROARING_AVX512_IGNORE_UNINITIALIZED                 \
+  _Pragma("GCC diagnostic push")                             \
+  _Pragma("GCC diagnostic ignored \"-Wuninitialized\"")      \
+  _Pragma("GCC diagnostic ignored \"-Wmaybe-uninitialized\"")
+#define CROARING_AVX512_RESTORE_UNINITIALIZED _Pragma("GCC diagnostic pop")
+#else
+#define CROARING_AVX512_IGNORE_UNINITIALIZED
+#define CROARING_AVX512_RESTORE_UNINITIALIZED
+#endif
+
+#if defined(__AVX512F__) && defined(__AVX512DQ__) && defined(__AVX512BW__) && \
+    defined(__AVX512VBMI2__) && defined(__AVX512BITALG__) &&                 \
+    defined(__AVX512VPOPCNTDQ__)
+// No need for runtime dispatching.
+#undef CROARING_TARGET_AVX512
+#define CROARING_TARGET_AVX512
+#undef CROARING_UNTARGET_AVX512
+#define CROARING_UNTARGET_AVX512
 #endif
 
 #endif /* INCLUDE_PORTABILITY_H_ */
@@ -9,6 +9,7 @@
 #include <stdint.h>
 #include <stddef.h>  // for `size_t`
 
+#include <roaring/memory.h>
 #include <roaring/roaring_types.h>
 #include <roaring/roaring_version.h>
 
@@ -63,6 +64,82 @@ roaring_bitmap_t *roaring_bitmap_from_range(uint64_t min, uint64_t max,
  */
 roaring_bitmap_t *roaring_bitmap_of_ptr(size_t n_args, const uint32_t *vals);
 
+/**
+ * Creates a new bitmap from `n_args` values that are sorted in strictly
+ * increasing order (no duplicates). Returns NULL if the allocation fails.
+ *
+ * This is much faster than `roaring_bitmap_of_ptr()`: each group of values
+ * sharing their high 16 bits goes straight into a single container of the
+ * smallest type for it (array, bitset or run), sized exactly.
+ */
+roaring_bitmap_t *roaring_bitmap_from_sorted(size_t n_args,
+                                             const uint32_t *vals);
+
+/**
+ * (For advanced users.)
+ *
+ * Appends values that come in increasing order to a bitmap, as when
+ * ingesting ids from a log. The values of the current 16-bit key are buffered
+ * and, once the key changes, turned into a single container of the smallest
+ * type, appended to the bitmap: there is no per-value key search nor
+ * container conversion on the way.
+ *
+ * The bitmap does not see the buffered values until the builder is flushed.
+ */
+typedef struct roaring_bulk_builder_s {
+    roaring_bitmap_t *r;
+    uint16_t key;      // high 16 bits of the buffered values
+    int32_t count;     // number of buffered values
+    uint16_t *values;  // low 16 bits of the buffered values, room for 65536
+} roaring_bulk_builder_t;
+
+/**
+ * Initializes a builder appending to `r`. Returns false if the allocation of
+ * the buffer fails. Client is responsible for calling
+ * `roaring_bulk_builder_finish()`.
+ */
+bool roaring_bulk_builder_init(roaring_bulk_builder_t *builder,
+                               roaring_bitmap_t *r);
+
+/**
+ * Hands the buffered values over to the bitmap, so that it can be read.
+ * Returns false if the allocation of the container fails, in which case the
+ * buffered values are lost.
+ */
+bool roaring_bulk_builder_flush(roaring_bulk_builder_t *builder);
+
+/**
+ * Flushes the builder and releases its buffer. The bitmap stays with the
+ * client. Returns false if the flush failed.
+ */
+bool roaring_bulk_builder_finish(roaring_bulk_builder_t *builder);
+
+/**
+ * Adds `val`. Values must come in non-decreasing order, and their high 16
+ * bits must not be smaller than those of the values already in the bitmap:
+ * values sharing the last key of the bitmap are merged into its container.
+ *
+ * Returns false if `val` starts a new key and flushing the values of the
+ * previous one failed (see `roaring_bulk_builder_flush()`): those are lost,
+ * but `val` is buffered all the same.
+ */
+static inline bool roaring_bulk_builder_add(roaring_bulk_builder_t *builder,
+                                            uint32_t val) {
+    const uint16_t key = (uint16_t)(val >> 16);
+    const uint16_t low = (uint16_t)val;
+    bool is_ok = true;
+    if (builder->count > 0) {
+        if (key != builder->key) {
+            is_ok = roaring_bulk_builder_flush(builder);
+        } else if (builder->values[builder->count - 1] == low) {
+            return true;  // already added
+        }
+    }
+    builder->key = key;
+    builder->values[builder->count++] = low;
+    return is_ok;
+}
+
 /*
  * Whether you want to use copy-on-write.
  * Saves memory and avoids copies, but needs more care in a threaded context.
@@ -100,6 +177,85 @@ roaring_bitmap_t *roaring_bitmap_of(size_t n, ...);
  */
 roaring_bitmap_t *roaring_bitmap_copy(const roaring_bitmap_t *r);
 
+/**
+ * Returns a copy-on-write copy of `r`, which can be handed to another thread.
+ * This enables copy-on-write on `r` and makes every container of `r` shared
+ * with the snapshot, so it only takes time and memory proportional to the
+ * number of containers. A container is only duplicated when either side
+ * later modifies it.
+ *
+ * The shared containers are reference counted atomically, so `r` and each
+ * of its snapshots may then be used, modified and freed by different threads
+ * independently. The snapshot itself must be taken by the thread that owns
+ * `r`, since it modifies `r`. To publish to several threads, take one
+ * snapshot per thread rather than sharing a single one: functions reading a
+ * copy-on-write bitmap may themselves share its containers, which modifies it.
+ * Compilers without known atomic primitives (see CROARING_NO_ATOMICS in
+ * portability.h) only get plain counts: snapshots then stay in one thread.
+ *
+ * The caller is responsible for memory management. Returns NULL on failure.
+ */
+roaring_bitmap_t *roaring_bitmap_snapshot(roaring_bitmap_t *r);
+
+/**
+ * A bitmap that many threads can add values to at the same time. The 16-bit
+ * keys (the high 16 bits of the values) are dealt to stripes modulo their
+ * number, each stripe with its own bitmap and spin lock, so that threads
+ * inserting values in different stripes do not wait for each other, even when
+ * all the values are small. Once the insertions are done,
+ * `roaring_concurrent_bitmap_to_bitmap()` turns it into a regular bitmap.
+ */
+typedef struct roaring_concurrent_bitmap_s roaring_concurrent_bitmap_t;
+
+/**
+ * Creates an empty concurrent bitmap with `n_stripes` stripes, between 1 and
+ * 65536. More stripes mean less contention, in particular when the threads
+ * insert values that are close to each other; a few times the number of
+ * threads is a good start. Returns NULL on failure, and always when the
+ * compiler has no known atomic primitives (see CROARING_NO_ATOMICS in
+ * portability.h).
+ */
+roaring_concurrent_bitmap_t *roaring_concurrent_bitmap_create(
+    uint32_t n_stripes);
+
+/**
+ * Frees the concurrent bitmap and the values it still holds.
+ */
+void roaring_concurrent_bitmap_free(roaring_concurrent_bitmap_t *cb);
+
+/**
+ * Adds `val`. Thread-safe.
+ */
+void roaring_concurrent_bitmap_add(roaring_concurrent_bitmap_t *cb,
+                                   uint32_t val);
+
+/**
+ * Adds the `n_args` values of `vals`. Thread-safe. The lock of a stripe is
+ * taken once for each run of consecutive values falling in it, so that
+ * sorted or clustered batches are inserted nearly as fast as with
+ * `roaring_bitmap_add_many()`.
+ */
+void roaring_concurrent_bitmap_add_many(roaring_concurrent_bitmap_t *cb,
+                                        size_t n_args, const uint32_t *vals);
+
+/**
+ * Checks whether `val` is present. Thread-safe.
+ */
+bool roaring_concurrent_bitmap_contains(roaring_concurrent_bitmap_t *cb,
+                                        uint32_t val);
+
+/**
+ * Moves all the values into a new bitmap, leaving `cb` empty and ready for
+ * more insertions. The containers are not copied: the stripes are merged by
+ * key, in time proportional to the number of containers plus at most one
+ * step per key up to the largest one.
+ *
+ * Not thread-safe: no other thread may use `cb` during the call.
+ * The caller is responsible for freeing the result. Returns NULL on failure.
+ */
+roaring_bitmap_t *roaring_concurrent_bitmap_to_bitmap(
+    roaring_concurrent_bitmap_t *cb);
+
 /**
  * Copies a bitmap from src to dest. It is assumed that the pointer dest
  * is to an already allocated bitmap. The content of the dest bitmap is
@@ -175,6 +331,17 @@ uint64_t roaring_bitmap_xor_cardinality(const roaring_bitmap_t *r1,
 void roaring_bitmap_and_inplace(roaring_bitmap_t *r1,
                                 const roaring_bitmap_t *r2);
 
+/**
+ * Compute the intersection of 'number' bitmaps.
+ * Caller is responsible for freeing the result.
+ *
+ * This is faster than chaining `roaring_bitmap_and_inplace()` since only the
+ * keys common to all bitmaps are visited, and each container intersection
+ * starts with the smallest containers and stops early once it goes empty.
+ */
+roaring_bitmap_t *roaring_bitmap_and_many(size_t number,
+                                          const roaring_bitmap_t **rs);
+
 /**
  * Computes the union between two bitmaps and returns new bitmap. The caller is
  * responsible for memory management.
@@ -205,6 +372,78 @@ roaring_bitmap_t *roaring_bitmap_or_many(size_t number,
 roaring_bitmap_t *roaring_bitmap_or_many_heap(uint32_t number,
                                               const roaring_bitmap_t **rs);
 
+/**
+ * Operators of the nodes of an expression, see `roaring_bitmap_evaluate()`.
+ */
+enum {
+    ROARING_EXPRESSION_INPUT,   // inputs[left]
+    ROARING_EXPRESSION_AND,     // nodes[left] & nodes[right]
+    ROARING_EXPRESSION_OR,      // nodes[left] | nodes[right]
+    ROARING_EXPRESSION_XOR,     // nodes[left] ^ nodes[right]
+    ROARING_EXPRESSION_ANDNOT   // nodes[left] & ~nodes[right]
+};
+
+typedef struct roaring_expression_node_s {
+    uint8_t op;      // one of ROARING_EXPRESSION_*
+    uint32_t left;   // index of an input bitmap, or of an earlier node
+    uint32_t right;  // index of an earlier node, ignored for inputs
+} roaring_expression_node_t;
+
+/**
+ * Evaluates a boolean expression over the `n_inputs` bitmaps `inputs`, and
+ * returns its result as a new bitmap. Caller is responsible for freeing it.
+ *
+ * The expression is a DAG of `n_nodes` nodes, each an input bitmap or an
+ * operator over two earlier nodes; its result is the last node. For instance,
+ * `(A | B) & ~C` is {INPUT 0, INPUT 1, OR 0 1, INPUT 2, ANDNOT 2 3}. Returns
+ * NULL if a node refers to a missing input or to a node that does not come
+ * before it, or if the allocation fails.
+ *
+ * This is faster than chaining pairwise operations: the expression is
+ * evaluated one 16-bit key at a time across all inputs, in scratch bitsets
+ * that are reused from key to key, so that only the result is allocated.
+ */
+roaring_bitmap_t *roaring_bitmap_evaluate(
+    size_t n_nodes, const roaring_expression_node_t *nodes,
+    size_t n_inputs, const roaring_bitmap_t **inputs);
+
+/**
+ * Compute the union of 'number' bitmaps using up to 'num_shards' independent
+ * tasks, each one computing the union over its own range of 16-bit keys.
+ * The shards are balanced according to the number of containers per range.
+ *
+ * The tasks are handed to `executor` (see `roaring_executor` in
+ * roaring_types.h), which may run them concurrently on a thread pool; when
+ * `executor` is NULL, the tasks run one after the other on the calling
+ * thread.  The results of the shards are concatenated without any merge.
+ *
+ * The input bitmaps must not be modified while the union is computed.
+ * Caller is responsible for freeing the result.
+ * Returns NULL in case of failure (e.g., insufficient memory).
+ */
+roaring_bitmap_t *roaring_bitmap_or_many_parallel(size_t number,
+                                                  const roaring_bitmap_t **rs,
+                                                  size_t num_shards,
+                                                  roaring_executor executor,
+                                                  void *executor_data);
+
+/**
+ * Compute the values found in at least `threshold` of the `number` bitmaps
+ * (T-occurrence query), e.g., for approximate matching over posting lists.
+ * A threshold of 1 is a union, a threshold of `number` an intersection.
+ * Caller is responsible for freeing the result.
+ *
+ * Keys found in fewer than `threshold` bitmaps are skipped without looking
+ * at their containers. For the others, occurrences are counted per value
+ * when the containers hold few values, or with bit-sliced counters (one
+ * bitset per bit of the counts) when they hold many.
+ *
+ * Returns NULL if `threshold` is zero or in case of failure.
+ */
+roaring_bitmap_t *roaring_bitmap_threshold_many(size_t number,
+                                                const roaring_bitmap_t **rs,
+                                                uint32_t threshold);
+
 /**
  * Computes the symmetric difference (xor) between two bitmaps
  * and returns new bitmap. The caller is responsible for memory management.
@@ -307,6 +546,44 @@ static inline void roaring_bitmap_remove_range(roaring_bitmap_t *r,
     roaring_bitmap_remove_range_closed(r, (uint32_t)min, (uint32_t)(max - 1));
 }
 
+/**
+ * (For advanced users.)
+ *
+ * Caches the container of the last value handed to `roaring_bitmap_add_bulk()`,
+ * `roaring_bitmap_contains_bulk()` or `roaring_bitmap_remove_bulk()`, so that
+ * the next value with the same high 16 bits skips the search for its
+ * container. Zero it before its first use, with
+ * `memset(&context, 0, sizeof(context))`.
+ *
+ * A context must only be used with one bitmap, and must be zeroed again
+ * whenever that bitmap is modified other than through these functions with
+ * this context.
+ */
+typedef struct roaring_bulk_context_s {
+    ROARING_CONTAINER_T *container;
+    int idx;
+    uint16_t key;
+    uint8_t typecode;
+} roaring_bulk_context_t;
+
+/**
+ * Add value val, using context from a previous insert for speed
+ * optimization.
+ *
+ * This is faster than `roaring_bitmap_add()` when consecutive values often
+ * share their high 16 bits, as with unsorted but locally clustered values.
+ */
+void roaring_bitmap_add_bulk(roaring_bitmap_t *r,
+                             roaring_bulk_context_t *context, uint32_t val);
+
+/**
+ * Remove value val, using context from a previous operation for speed
+ * optimization (see `roaring_bitmap_add_bulk()`).
+ */
+void roaring_bitmap_remove_bulk(roaring_bitmap_t *r,
+                                roaring_bulk_context_t *context,
+                                uint32_t val);
+
 /**
  * Remove multiple values
  */
@@ -324,6 +601,27 @@ bool roaring_bitmap_remove_checked(roaring_bitmap_t *r, uint32_t x);
  */
 bool roaring_bitmap_contains(const roaring_bitmap_t *r, uint32_t val);
 
+/**
+ * Sets results[i] to whether vals[i] is present, for i in [0, n_args).
+ *
+ * The values may come in any order, but this is much faster than calling
+ * `roaring_bitmap_contains()` for each of them when they are sorted or mostly
+ * sorted: consecutive values with the same high 16 bits share one container
+ * lookup, the keys are searched forward from the previous ones, and within a
+ * container the search resumes where the previous value left it.
+ */
+void roaring_bitmap_contains_many(const roaring_bitmap_t *r, size_t n_args,
+                                  const uint32_t *vals, bool *results);
+
+/**
+ * Check if value is present, using context from a previous operation for
+ * speed optimization (see `roaring_bitmap_add_bulk()`). Keys greater than the
+ * one of the context are sought forward from it.
+ */
+bool roaring_bitmap_contains_bulk(const roaring_bitmap_t *r,
+                                  roaring_bulk_context_t *context,
+                                  uint32_t val);
+
 /**
  * Check whether a range of values from range_start (included)
  * to range_end (excluded) is present
@@ -480,6 +778,31 @@ size_t roaring_bitmap_portable_size_in_bytes(const roaring_bitmap_t *r);
  */
 size_t roaring_bitmap_portable_serialize(const roaring_bitmap_t *r, char *buf);
 
+/**
+ * Streaming version of `roaring_bitmap_portable_serialize()`: the same bytes
+ * are handed to `write`, the header first and then one call per container
+ * (two for run containers), straight from the bitmap's memory. No buffer of
+ * the serialized size is needed, so the output can go directly to a file or
+ * a compression stream.
+ *
+ * Returns how many bytes were written, or 0 if `write` failed.
+ */
+size_t roaring_bitmap_portable_serialize_stream(const roaring_bitmap_t *r,
+                                                roaring_write_function write,
+                                                void *param);
+
+/**
+ * Streaming version of `roaring_bitmap_portable_deserialize_safe()`: the
+ * input is pulled through `read`, the header first and then one container at
+ * a time, each read straight into its own storage.
+ *
+ * In case of failure (`read` failed, or the data is not a valid bitmap),
+ * NULL is returned. Reading stops right after the bitmap, so that other data
+ * may follow it in the stream.
+ */
+roaring_bitmap_t *roaring_bitmap_portable_deserialize_stream(
+    roaring_read_function read, void *param);
+
 /*
  * "Frozen" serialization format imitates memory layout of roaring_bitmap_t.
  * Deserialized bitmap is a constant view of the underlying buffer.
@@ -524,6 +847,24 @@ void roaring_bitmap_frozen_serialize(const roaring_bitmap_t *r, char *buf);
 const roaring_bitmap_t *roaring_bitmap_frozen_view(const char *buf,
                                                    size_t length);
 
+/**
+ * Creates constant bitmap that is a view of a buffer in the portable format,
+ * as written by `roaring_bitmap_portable_serialize()`, reading no more than
+ * length bytes. In case of failure, NULL is returned.
+ *
+ * Only the container index is built: containers point into the buffer, so
+ * that opening a view is proportional to the number of containers rather
+ * than to the size of the data. The buffer needs no particular alignment,
+ * but containers that are not aligned (2 bytes for arrays and runs, 32 bytes
+ * for bitsets) are copied.
+ *
+ * Bitmap returned by this function can be used in all readonly contexts.
+ * Bitmap must be freed as usual, by calling roaring_bitmap_free().
+ * Underlying buffer must not be freed or modified while it backs any bitmaps.
+ */
+const roaring_bitmap_t *roaring_bitmap_portable_view(const char *buf,
+                                                     size_t length);
+
 /**
  * Iterate over the bitmap elements. The function iterator is called once for
  * all the values with ptr (can be NULL) as the second parameter of each call.
@@ -640,6 +981,18 @@ roaring_bitmap_t *roaring_bitmap_flip(const roaring_bitmap_t *r1,
 void roaring_bitmap_flip_inplace(roaring_bitmap_t *r1, uint64_t range_start,
                                  uint64_t range_end);
 
+/**
+ * Adds the (possibly negative) offset to all the values of the bitmap and
+ * returns the result as a new bitmap. Values that would fall outside of
+ * [0, UINT32_MAX] are dropped. Caller is responsible for freeing the result.
+ *
+ * When the offset is a multiple of 1 << 16, only the keys change. Otherwise
+ * each container is shifted as a whole and split across two keys, with no
+ * work per value.
+ */
+roaring_bitmap_t *roaring_bitmap_add_offset(const roaring_bitmap_t *r,
+                                            int64_t offset);
+
 /**
  * Selects the element at index 'rank' where the smallest element is at index 0.
  * If the size of the roaring bitmap is strictly greater than rank, then this
@@ -661,6 +1014,88 @@ bool roaring_bitmap_select(const roaring_bitmap_t *r, uint32_t rank,
  */
 uint64_t roaring_bitmap_rank(const roaring_bitmap_t *r, uint32_t x);
 
+/**
+ * roaring_bitmap_rank_many sets ans[i] to `roaring_bitmap_rank(r, begin[i])`
+ * for every value in [begin, end), which must be sorted in increasing order.
+ * `ans` must have room for (end - begin) values.
+ *
+ * This is faster than calling `roaring_bitmap_rank()` for each value since the
+ * bitmap is walked only once, carrying over the number of values seen so far.
+ */
+void roaring_bitmap_rank_many(const roaring_bitmap_t *r, const uint32_t *begin,
+                              const uint32_t *end, uint64_t *ans);
+
+/**
+ * roaring_bitmap_select_many sets element[i] to the element of rank begin[i]
+ * (see `roaring_bitmap_select()`) for the ranks in [begin, end), which must be
+ * sorted in increasing order. `element` must have room for (end - begin)
+ * values.
+ *
+ * Returns how many ranks were selected: since the ranks are sorted, the ones
+ * that are not smaller than the cardinality of the bitmap all come last.
+ */
+size_t roaring_bitmap_select_many(const roaring_bitmap_t *r,
+                                  const uint32_t *begin, const uint32_t *end,
+                                  uint32_t *element);
+
+/**
+ * (For advanced users.)
+ *
+ * Cumulative cardinalities of the containers of a bitmap:
+ * `cardinalities[i]` is the number of values in the containers before
+ * container `i`, and `cardinalities[size]` is the cardinality of the bitmap.
+ * It lets rank and select find their container by binary search instead of
+ * summing the cardinalities of all the containers that come before it.
+ *
+ * The index is a snapshot: it describes the bitmap as it was when the index
+ * was built, and is not told about later changes. After modifying the bitmap,
+ * call `roaring_rank_index_rebuild()` before the next indexed query; until
+ * then the indexed functions return wrong answers. Frozen and portable views
+ * never change, so their index stays valid as long as the view.
+ */
+typedef struct roaring_rank_index_s {
+    int32_t size;
+    uint64_t *cardinalities;
+} roaring_rank_index_t;
+
+/**
+ * Builds the rank index of `r` (see `roaring_rank_index_t`), or returns NULL
+ * if the allocation fails. Client is responsible for calling
+ * `roaring_rank_index_free()`.
+ */
+roaring_rank_index_t *roaring_rank_index_create(const roaring_bitmap_t *r);
+
+/**
+ * Brings `index` up to date with `r` after `r` was modified, reusing its
+ * memory when the number of containers did not grow. Returns false if the
+ * allocation fails, in which case the index must not be used with `r`.
+ */
+bool roaring_rank_index_rebuild(const roaring_bitmap_t *r,
+                                roaring_rank_index_t *index);
+
+/**
+ * Frees the memory.
+ */
+void roaring_rank_index_free(roaring_rank_index_t *index);
+
+/**
+ * Same as `roaring_bitmap_select()`, in O(log #containers) plus the select
+ * within the container. `index` must be up to date with `r` (see
+ * `roaring_rank_index_t`).
+ */
+bool roaring_bitmap_select_indexed(const roaring_bitmap_t *r,
+                                   const roaring_rank_index_t *index,
+                                   uint32_t rank, uint32_t *element);
+
+/**
+ * Same as `roaring_bitmap_rank()`, in O(log #containers) plus the rank within
+ * the container. `index` must be up to date with `r` (see
+ * `roaring_rank_index_t`).
+ */
+uint64_t roaring_bitmap_rank_indexed(const roaring_bitmap_t *r,
+                                     const roaring_rank_index_t *index,
+                                     uint32_t x);
+
 /**
  * Returns the smallest value in the set, or UINT32_MAX if the set is empty.
  */
@@ -789,6 +1224,112 @@ void roaring_free_uint32_iterator(roaring_uint32_iterator_t *it);
 uint32_t roaring_read_uint32_iterator(roaring_uint32_iterator_t *it,
                                       uint32_t* buf, uint32_t count);
 
+/*
+ * Reads the next ${count} ranges of consecutive values from the iterator into
+ * the user-supplied ${ranges}, as pairs: the range [ranges[2*i],
+ * ranges[2*i+1]) holds all the values from its start (included) to its end
+ * (excluded). Ranges are maximal, including across containers. Returns the
+ * number of ranges read, which is smaller than ${count} once the iterator is
+ * drained.
+ *
+ * Values are never materialized one by one: runs are read as such, spans of
+ * arrays are found by galloping, and spans of bitsets 64 bits at a time.
+ * Like `roaring_read_uint32_iterator()`, the first range starts at
+ * ${it}->current_value, and the iterator is then positioned at the first value
+ * after the last range.
+ */
+uint32_t roaring_read_uint32_iterator_ranges(roaring_uint32_iterator_t *it,
+                                             uint64_t *ranges, uint32_t count);
+
+/*********************
+* Cursors iterate through the result of an expression over bitmaps, such as
+* (A & B & C) | (D & ~E), without computing it: values are produced one at a
+* time, in increasing order, so that a consumer needing only the first few
+* of them (LIMIT, top-k) does not pay for the whole result.
+
+roaring_cursor_t *ab[2] = {roaring_cursor_create(a), roaring_cursor_create(b)};
+roaring_cursor_t *c = roaring_cursor_and(2, ab);
+while (c->has_value) {
+  printf("value = %d\n", c->current_value);
+  roaring_cursor_advance(c);
+}
+roaring_cursor_free(c);
+
+An intersection leapfrogs: each input in turn seeks the largest value
+reached so far, skipping whole containers when their keys differ.
+As with iterators, the bitmaps must not be modified while cursors use them.
+*/
+
+/**
+ * Operators of cursors, see `roaring_cursor_t`.
+ */
+enum {
+    ROARING_CURSOR_BITMAP,  // the values of a bitmap
+    ROARING_CURSOR_AND,
+    ROARING_CURSOR_OR,
+    ROARING_CURSOR_ANDNOT,  // children[0] & ~children[1]
+};
+
+typedef struct roaring_cursor_s {
+    uint32_t current_value;
+    bool has_value;
+
+    uint8_t op;
+    uint32_t n_children;
+    struct roaring_cursor_s **children;  // owned by the cursor
+    roaring_uint32_iterator_t iterator;  // for ROARING_CURSOR_BITMAP
+} roaring_cursor_t;
+
+/**
+ * Creates a cursor over the values of `r`, positioned at the first one.
+ * Returns NULL on failure.
+ */
+roaring_cursor_t *roaring_cursor_create(const roaring_bitmap_t *r);
+
+/**
+ * Creates a cursor over the intersection (resp. the union) of the `n` >= 1
+ * cursors of `children`, positioned at its first value. The new cursor takes
+ * ownership of the children, which must not be used anymore, even on
+ * failure: they are then freed. A NULL child also makes the call fail, so
+ * that nested expressions can be built in one go and checked once.
+ * Returns NULL on failure.
+ */
+roaring_cursor_t *roaring_cursor_and(size_t n, roaring_cursor_t **children);
+roaring_cursor_t *roaring_cursor_or(size_t n, roaring_cursor_t **children);
+
+/**
+ * Creates a cursor over the values of `a` that `b` does not have. Takes
+ * ownership of `a` and `b` like `roaring_cursor_and()`.
+ */
+roaring_cursor_t *roaring_cursor_andnot(roaring_cursor_t *a,
+                                        roaring_cursor_t *b);
+
+/**
+ * Frees a cursor and all its children.
+ */
+void roaring_cursor_free(roaring_cursor_t *c);
+
+/**
+ * Moves the cursor to the next value. If there is one, then `c->has_value`
+ * is true and the value is in `c->current_value`. Returns `c->has_value`.
+ */
+bool roaring_cursor_advance(roaring_cursor_t *c);
+
+/**
+ * Moves the cursor to the first value >= `val`. Cursors only move forward:
+ * if `val` is not above `c->current_value`, the cursor stays where it is.
+ * Returns `c->has_value`.
+ */
+bool roaring_cursor_move_equalorlarger(roaring_cursor_t *c, uint32_t val);
+
+/**
+ * Reads the next `count` values of the cursor into `buf`, starting with
+ * `c->current_value`, and returns how many were read: fewer than `count`
+ * once the cursor is drained. The cursor is then positioned at the next value.
+ */
+uint32_t roaring_cursor_read(roaring_cursor_t *c, uint32_t *buf,
+                             uint32_t count);
+
 #ifdef __cplusplus
 } } }  // extern "C" { namespace roaring { namespace api {
 #endif
@@ -13,6 +13,8 @@ extern "C" { namespace roaring {
 
 // Note: in pure C++ code, you should avoid putting `using` in header files
 using api::roaring_array_t;
+using api::roaring_write_function;
+using api::roaring_read_function;
 
 namespace internal {
 #endif
@@ -218,6 +220,22 @@ size_t ra_portable_serialize(const roaring_array_t *ra, char *buf);
  */
 bool ra_portable_deserialize(roaring_array_t *ra, const char *buf, const size_t maxbytes, size_t * readbytes);
 
+/**
+ * Streaming version of ra_portable_serialize: the output is handed to write
+ * piece by piece, the header first and then each container. Returns the
+ * number of bytes written, or 0 if write failed.
+ */
+size_t ra_portable_serialize_stream(const roaring_array_t *ra,
+                                    roaring_write_function write, void *param);
+
+/**
+ * Streaming version of ra_portable_deserialize, pulling its input from read.
+ * The roaring_array_t must be uninitialized. Returns false if the input is
+ * not a valid bitmap, in which case nothing needs to be cleared.
+ */
+bool ra_portable_deserialize_stream(roaring_array_t *ra,
+                                    roaring_read_function read, void *param);
+
 /**
  * Quickly checks whether there is a serialized bitmap at the pointer,
  * not exceeding size "maxbytes" in bytes. This function does not allocate
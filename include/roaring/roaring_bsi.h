@@ -0,0 +1,119 @@
+/*
+ * roaring_bsi.h
+ *
+ * A bit-sliced index (BSI) maps 32-bit row ids to unsigned 64-bit integer
+ * values (prices, timestamps...). It keeps one roaring bitmap per bit of the
+ * values, holding the rows whose value has that bit set, plus an existence
+ * bitmap of the rows that have a value. Comparisons, ranges and aggregates
+ * are then computed with a few bitmap operations per bit, instead of a scan
+ * of the values (O'Neil and Quass, "Improved query performance with variant
+ * indexes", SIGMOD 1997).
+ */
+#ifndef ROARING_BSI_H
+#define ROARING_BSI_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>  // for `size_t`
+
+#include <roaring/roaring.h>
+
+#ifdef __cplusplus
+extern "C" { namespace roaring { namespace api {
+#endif
+
+typedef struct roaring_bsi_s roaring_bsi_t;
+
+/**
+ * Comparison operators, see `roaring_bsi_compare()`.
+ */
+enum {
+    ROARING_BSI_EQ,
+    ROARING_BSI_NEQ,
+    ROARING_BSI_LT,
+    ROARING_BSI_LE,
+    ROARING_BSI_GT,
+    ROARING_BSI_GE,
+};
+
+/**
+ * Creates a new, empty index. Returns NULL in case of failure.
+ * Caller is responsible for freeing the result.
+ */
+roaring_bsi_t *roaring_bsi_create(void);
+
+/**
+ * Frees the memory.
+ */
+void roaring_bsi_free(roaring_bsi_t *bsi);
+
+/**
+ * Sets the value of `rows[i]` to `values[i]` for the `n` pairs, replacing
+ * the previous values of these rows. A row must not appear twice in the same
+ * call. The rows of each bit are gathered and added with
+ * `roaring_bitmap_add_many()`, so that sorted rows are the fastest.
+ * Returns false in case of failure, leaving the index unchanged.
+ */
+bool roaring_bsi_set_many(roaring_bsi_t *bsi, size_t n, const uint32_t *rows,
+                          const uint64_t *values);
+
+/**
+ * If `row` has a value, sets `*value` to it and returns true.
+ */
+bool roaring_bsi_get(const roaring_bsi_t *bsi, uint32_t row, uint64_t *value);
+
+/**
+ * Returns the number of rows that have a value.
+ */
+uint64_t roaring_bsi_get_cardinality(const roaring_bsi_t *bsi);
+
+/**
+ * Returns the rows of `filter` whose value compares to `value` with `op`
+ * (e.g., ROARING_BSI_LT for the rows whose value is < `value`). Only rows
+ * with a value are considered; a NULL `filter` stands for all of them.
+ * Caller is responsible for freeing the result.
+ */
+roaring_bitmap_t *roaring_bsi_compare(const roaring_bsi_t *bsi, uint8_t op,
+                                      uint64_t value,
+                                      const roaring_bitmap_t *filter);
+
+/**
+ * Returns the rows of `filter` whose value is between `min` and `max`,
+ * both included, as with `roaring_bsi_compare()`.
+ * Caller is responsible for freeing the result.
+ */
+roaring_bitmap_t *roaring_bsi_range(const roaring_bsi_t *bsi, uint64_t min,
+                                    uint64_t max,
+                                    const roaring_bitmap_t *filter);
+
+/**
+ * Returns the sum (modulo 2^64) of the values of the rows of `filter`, and
+ * sets `*count` to the number of these rows if `count` is not NULL. The sum
+ * only takes one intersection cardinality per bit.
+ */
+uint64_t roaring_bsi_sum(const roaring_bsi_t *bsi,
+                         const roaring_bitmap_t *filter, uint64_t *count);
+
+/**
+ * If a row of `filter` has a value, sets `*value` to the smallest (resp.
+ * greatest) of them and returns true.
+ */
+bool roaring_bsi_min(const roaring_bsi_t *bsi, const roaring_bitmap_t *filter,
+                     uint64_t *value);
+bool roaring_bsi_max(const roaring_bsi_t *bsi, const roaring_bitmap_t *filter,
+                     uint64_t *value);
+
+/**
+ * Returns the `k` rows of `filter` with the greatest values (all of them if
+ * there are fewer than `k`). Among rows with equal values, the smallest row
+ * ids are taken first. Caller is responsible for freeing the result.
+ */
+roaring_bitmap_t *roaring_bsi_top_k(const roaring_bsi_t *bsi,
+                                    const roaring_bitmap_t *filter,
+                                    uint64_t k);
+
+#ifdef __cplusplus
+} } }  // extern "C" { namespace roaring { namespace api {
+#endif
+
+#endif  /* ROARING_BSI_H */
@@ -7,6 +7,7 @@
 
 #include <stdbool.h>
 #include <stdint.h>
+#include <stddef.h>  // for `size_t`
 
 #ifdef __cplusplus
 extern "C" { namespace roaring { namespace api {
@@ -66,6 +67,35 @@ typedef struct roaring_array_s {
 typedef bool (*roaring_iterator)(uint32_t value, void *param);
 typedef bool (*roaring_iterator64)(uint64_t value, void *param);
 
+/**
+ * A task that can be handed to a `roaring_executor`: `index` identifies which
+ * part of the work described by `task_data` should be done.
+ */
+typedef void (*roaring_task)(void *task_data, size_t index);
+
+/**
+ * An executor calls `task(task_data, i)` once for every i in [0, count).
+ * The calls are independent and may run concurrently (e.g., on a thread
+ * pool), but the executor must not return before all of them completed.
+ * `executor_data` is passed through unchanged from the caller.
+ */
+typedef void (*roaring_executor)(roaring_task task, void *task_data,
+                                 size_t count, void *executor_data);
+
+/**
+ * Receives the next `length` bytes of a serialized bitmap. Returns false on
+ * failure (e.g., a short write), which stops the serialization.
+ */
+typedef bool (*roaring_write_function)(const char *data, size_t length,
+                                       void *param);
+
+/**
+ * Fills `data` with the next `length` bytes of a serialized bitmap. Returns
+ * false if they are not available (e.g., end of file), which stops the
+ * deserialization.
+ */
+typedef bool (*roaring_read_function)(char *data, size_t length, void *param);
+
 /**
 *  (For advanced users.)
 * The roaring_statistics_t can be used to collect detailed statistics about
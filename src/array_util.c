@@ -444,7 +444,7 @@ int32_t intersect_vector16(const uint16_t *__restrict__ A, size_t s_a,
     }
     return (int32_t)count;
 }
-CROARING_UNTARGET_REGION
+CROARING_UNTARGET_AVX2
 
 CROARING_TARGET_AVX2
 int32_t intersect_vector16_cardinality(const uint16_t *__restrict__ A,
@@ -516,7 +516,94 @@ int32_t intersect_vector16_cardinality(const uint16_t *__restrict__ A,
     }
     return (int32_t)count;
 }
-CROARING_UNTARGET_REGION
+CROARING_UNTARGET_AVX2
+
+#if CROARING_COMPILER_SUPPORTS_AVX512
+CROARING_AVX512_IGNORE_UNINITIALIZED
+CROARING_TARGET_AVX512
+/**
+ * Returns the mask of the 32 values in v_a that appear among B[0..7].
+ */
+static inline __mmask32 _avx512_block_matches(__m512i v_a,
+                                              const uint16_t *B) {
+    __mmask32 m = 0;
+    for (int j = 0; j < 8; j++) {
+        m |= _mm512_cmpeq_epi16_mask(v_a, _mm512_set1_epi16((short)B[j]));
+    }
+    return m;
+}
+
+int32_t intersect_vector16_avx512(const uint16_t *__restrict__ A, size_t s_a,
+                                  const uint16_t *__restrict__ B, size_t s_b,
+                                  uint16_t *C) {
+    size_t count = 0;
+    size_t i_a = 0, i_b = 0;
+    const size_t st_a = (s_a / 32) * 32;
+    const size_t st_b = (s_b / 8) * 8;
+    while ((i_a < st_a) && (i_b < st_b)) {
+        const __m512i v_a = _mm512_loadu_si512((const __m512i *)&A[i_a]);
+        const __mmask32 m = _avx512_block_matches(v_a, &B[i_b]);
+        // the values of a block are sorted, and compression keeps their order
+        _mm512_mask_compressstoreu_epi16(&C[count], m, v_a);
+        count += _mm_popcnt_u32(m);
+        const uint16_t a_max = A[i_a + 31];
+        const uint16_t b_max = B[i_b + 7];
+        if (a_max <= b_max) i_a += 32;
+        if (b_max <= a_max) i_b += 8;
+    }
+    // intersect the tail using scalar intersection
+    while (i_a < s_a && i_b < s_b) {
+        uint16_t a = A[i_a];
+        uint16_t b = B[i_b];
+        if (a < b) {
+            i_a++;
+        } else if (b < a) {
+            i_b++;
+        } else {
+            C[count] = a;  //==b;
+            count++;
+            i_a++;
+            i_b++;
+        }
+    }
+    return (int32_t)count;
+}
+
+int32_t intersect_vector16_cardinality_avx512(const uint16_t *__restrict__ A,
+                                              size_t s_a,
+                                              const uint16_t *__restrict__ B,
+                                              size_t s_b) {
+    size_t count = 0;
+    size_t i_a = 0, i_b = 0;
+    const size_t st_a = (s_a / 32) * 32;
+    const size_t st_b = (s_b / 8) * 8;
+    while ((i_a < st_a) && (i_b < st_b)) {
+        const __m512i v_a = _mm512_loadu_si512((const __m512i *)&A[i_a]);
+        count += _mm_popcnt_u32(_avx512_block_matches(v_a, &B[i_b]));
+        const uint16_t a_max = A[i_a + 31];
+        const uint16_t b_max = B[i_b + 7];
+        if (a_max <= b_max) i_a += 32;
+        if (b_max <= a_max) i_b += 8;
+    }
+    // intersect the tail using scalar intersection
+    while (i_a < s_a && i_b < s_b) {
+        uint16_t a = A[i_a];
+        uint16_t b = B[i_b];
+        if (a < b) {
+            i_a++;
+        } else if (b < a) {
+            i_b++;
+        } else {
+            count++;
+            i_a++;
+            i_b++;
+        }
+    }
+    return (int32_t)count;
+}
+CROARING_UNTARGET_AVX512
+CROARING_AVX512_RESTORE_UNINITIALIZED
+#endif  // CROARING_COMPILER_SUPPORTS_AVX512
 
 CROARING_TARGET_AVX2
 /////////
@@ -660,7 +747,7 @@ int32_t difference_vector16(const uint16_t *__restrict__ A, size_t s_a,
     }
     return count;
 }
-CROARING_UNTARGET_REGION
+CROARING_UNTARGET_AVX2
 #endif  // CROARING_IS_X64
 
 
@@ -1149,7 +1236,7 @@ static inline void sse_merge(const __m128i *vInput1,
     *vecMax = _mm_max_epu16(vecTmp, *vecMax);
     *vecMin = _mm_alignr_epi8(*vecMin, *vecMin, 2);
 }
-CROARING_UNTARGET_REGION
+CROARING_UNTARGET_AVX2
 // used by store_unique, generated by simdunion.py
 static uint8_t uniqshuf[] = {
     0x0,  0x1,  0x2,  0x3,  0x4,  0x5,  0x6,  0x7,  0x8,  0x9,  0xa,  0xb,
@@ -1508,7 +1595,7 @@ static inline int store_unique(__m128i old, __m128i newval, uint16_t *output) {
     _mm_storeu_si128((__m128i *)output, val);
     return numberofnewvalues;
 }
-CROARING_UNTARGET_REGION
+CROARING_UNTARGET_AVX2
 
 // working in-place, this function overwrites the repeated values
 // could be avoided?
@@ -1609,7 +1696,7 @@ uint32_t union_vector16(const uint16_t *__restrict__ array1, uint32_t length1,
     }
     return len;
 }
-CROARING_UNTARGET_REGION
+CROARING_UNTARGET_AVX2
 
 /**
  * End of the SIMD 16-bit union code
@@ -1638,7 +1725,7 @@ static inline int store_unique_xor(__m128i old, __m128i newval,
     _mm_storeu_si128((__m128i *)output, val);
     return numberofnewvalues;
 }
-CROARING_UNTARGET_REGION
+CROARING_UNTARGET_AVX2
 
 // working in-place, this function overwrites the repeated values
 // could be avoided? Warning: assumes len > 0
@@ -1756,7 +1843,7 @@ uint32_t xor_vector16(const uint16_t *__restrict__ array1, uint32_t length1,
     }
     return len;
 }
-CROARING_UNTARGET_REGION
+CROARING_UNTARGET_AVX2
 /**
  * End of SIMD 16-bit XOR code
  */
@@ -1858,37 +1945,123 @@ size_t union_uint32_card(const uint32_t *set_1, size_t size_1,
 
 
 
-size_t fast_union_uint16(const uint16_t *set_1, size_t size_1, const uint16_t *set_2,
-                    size_t size_2, uint16_t *buffer) {
+typedef size_t (*union_uint16_fn)(const uint16_t *set_1, size_t size_1,
+                                  const uint16_t *set_2, size_t size_2,
+                                  uint16_t *buffer);
+typedef int32_t (*intersect_uint16_fn)(const uint16_t *A, size_t s_a,
+                                       const uint16_t *B, size_t s_b,
+                                       uint16_t *C);
+typedef int32_t (*intersect_uint16_cardinality_fn)(const uint16_t *A,
+                                                   size_t s_a,
+                                                   const uint16_t *B,
+                                                   size_t s_b);
+
 #ifdef CROARING_IS_X64
+static size_t _avx2_union_uint16(const uint16_t *set_1, size_t size_1,
+                                 const uint16_t *set_2, size_t size_2,
+                                 uint16_t *buffer) {
+    return union_vector16(set_1, (uint32_t)size_1, set_2, (uint32_t)size_2,
+                          buffer);
+}
+
+static size_t _resolve_union_uint16(const uint16_t *set_1, size_t size_1,
+                                    const uint16_t *set_2, size_t size_2,
+                                    uint16_t *buffer);
+CROARING_DISPATCH_POINTER(union_uint16_fn, union_uint16_kernel,
+                          _resolve_union_uint16);
+
+static size_t _resolve_union_uint16(const uint16_t *set_1, size_t size_1,
+                                    const uint16_t *set_2, size_t size_2,
+                                    uint16_t *buffer) {
+    union_uint16_fn kernel = union_uint16;
     if( croaring_avx2() ) {
-        // compute union with smallest array first
-      if (size_1 < size_2) {
-        return union_vector16(set_1, (uint32_t)size_1,
-                                          set_2, (uint32_t)size_2, buffer);
-      } else {
-        return union_vector16(set_2, (uint32_t)size_2,
-                                          set_1, (uint32_t)size_1, buffer);
-      }
-    } else {
-       // compute union with smallest array first
-      if (size_1 < size_2) {
-        return union_uint16(
-            set_1, size_1, set_2, size_2, buffer);
-      } else {
-        return union_uint16(
-            set_2, size_2, set_1, size_1, buffer);
-      }
+        kernel = _avx2_union_uint16;
+    }
+    union_uint16_kernel = kernel;
+    return kernel(set_1, size_1, set_2, size_2, buffer);
+}
+
+static int32_t _resolve_intersect_uint16(const uint16_t *A, size_t s_a,
+                                         const uint16_t *B, size_t s_b,
+                                         uint16_t *C);
+CROARING_DISPATCH_POINTER(intersect_uint16_fn, intersect_uint16_kernel,
+                          _resolve_intersect_uint16);
+
+static int32_t _resolve_intersect_uint16(const uint16_t *A, size_t s_a,
+                                         const uint16_t *B, size_t s_b,
+                                         uint16_t *C) {
+    intersect_uint16_fn kernel = intersect_uint16;
+#if CROARING_COMPILER_SUPPORTS_AVX512
+    if( croaring_avx512() ) {
+        kernel = intersect_vector16_avx512;
+    } else
+#endif
+    if( croaring_avx2() ) {
+        kernel = intersect_vector16;
     }
+    intersect_uint16_kernel = kernel;
+    return kernel(A, s_a, B, s_b, C);
+}
+
+static int32_t _resolve_intersect_uint16_cardinality(const uint16_t *A,
+                                                     size_t s_a,
+                                                     const uint16_t *B,
+                                                     size_t s_b);
+CROARING_DISPATCH_POINTER(intersect_uint16_cardinality_fn,
+                          intersect_uint16_cardinality_kernel,
+                          _resolve_intersect_uint16_cardinality);
+
+static int32_t _resolve_intersect_uint16_cardinality(const uint16_t *A,
+                                                     size_t s_a,
+                                                     const uint16_t *B,
+                                                     size_t s_b) {
+    intersect_uint16_cardinality_fn kernel = intersect_uint16_cardinality;
+#if CROARING_COMPILER_SUPPORTS_AVX512
+    if( croaring_avx512() ) {
+        kernel = intersect_vector16_cardinality_avx512;
+    } else
+#endif
+    if( croaring_avx2() ) {
+        kernel = intersect_vector16_cardinality;
+    }
+    intersect_uint16_cardinality_kernel = kernel;
+    return kernel(A, s_a, B, s_b);
+}
+#endif // CROARING_IS_X64
+
+size_t fast_union_uint16(const uint16_t *set_1, size_t size_1, const uint16_t *set_2,
+                    size_t size_2, uint16_t *buffer) {
+#ifdef CROARING_IS_X64
+    union_uint16_fn kernel = union_uint16_kernel;
 #else
+    union_uint16_fn kernel = union_uint16;
+#endif
     // compute union with smallest array first
     if (size_1 < size_2) {
-        return union_uint16(
-            set_1, size_1, set_2, size_2, buffer);
+        return kernel(set_1, size_1, set_2, size_2, buffer);
     } else {
-        return union_uint16(
-            set_2, size_2, set_1, size_1, buffer);
+        return kernel(set_2, size_2, set_1, size_1, buffer);
     }
+}
+
+int32_t fast_intersect_uint16(const uint16_t *A, size_t s_a,
+                              const uint16_t *B, size_t s_b, uint16_t *C) {
+#ifdef CROARING_IS_X64
+    intersect_uint16_fn kernel = intersect_uint16_kernel;
+    return kernel(A, s_a, B, s_b, C);
+#else
+    return intersect_uint16(A, s_a, B, s_b, C);
+#endif
+}
+
+int32_t fast_intersect_uint16_cardinality(const uint16_t *A, size_t s_a,
+                                          const uint16_t *B, size_t s_b) {
+#ifdef CROARING_IS_X64
+    intersect_uint16_cardinality_fn kernel =
+        intersect_uint16_cardinality_kernel;
+    return kernel(A, s_a, B, s_b);
+#else
+    return intersect_uint16_cardinality(A, s_a, B, s_b);
 #endif
 }
 #ifdef CROARING_IS_X64
@@ -1931,7 +2104,7 @@ static inline bool _avx2_memequals(const void *s1, const void *s2, size_t n) {
 
     return true;
 }
-CROARING_UNTARGET_REGION
+CROARING_UNTARGET_AVX2
 #endif
 
 bool memequals(const void *s1, const void *s2, size_t n) {
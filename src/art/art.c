@@ -0,0 +1,661 @@
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <roaring/art/art.h>
+#include <roaring/memory.h>
+
+#ifdef __cplusplus
+extern "C" { namespace roaring { namespace internal {
+#endif
+
+enum {
+    ART_NODE4_TYPE,
+    ART_NODE16_TYPE,
+    ART_NODE48_TYPE,
+    ART_NODE256_TYPE,
+};
+
+// in a node48, the index of an absent child
+#define ART_NODE48_EMPTY 48
+
+/*
+ * An inner node at depth d (the number of key bytes above it) holds the
+ * leaves whose keys have its prefix at d, d + 1..., and its children are
+ * indexed by the key byte that follows the prefix. Since every inner node
+ * has a child byte, a prefix has at most ART_KEY_BYTES - 1 bytes.
+ */
+typedef struct art_inner_node_s {
+    uint8_t typecode;
+    uint8_t prefix_size;
+    art_key_chunk_t prefix[ART_KEY_BYTES - 1];
+} art_inner_node_t;
+
+typedef struct art_node4_s {
+    art_inner_node_t base;
+    uint8_t count;
+    art_key_chunk_t keys[4];  // sorted
+    art_node_t *children[4];
+} art_node4_t;
+
+typedef struct art_node16_s {
+    art_inner_node_t base;
+    uint8_t count;
+    art_key_chunk_t keys[16];  // sorted
+    art_node_t *children[16];
+} art_node16_t;
+
+typedef struct art_node48_s {
+    art_inner_node_t base;
+    uint8_t count;
+    uint8_t keys[256];  // index in children, or ART_NODE48_EMPTY
+    art_node_t *children[48];  // NULL in the free slots
+} art_node48_t;
+
+typedef struct art_node256_s {
+    art_inner_node_t base;
+    uint16_t count;
+    art_node_t *children[256];
+} art_node256_t;
+
+static inline bool art_is_leaf(const art_node_t *node) {
+    return ((uintptr_t)node & 1) != 0;
+}
+
+static inline art_node_t *art_leaf_to_node(art_val_t *val) {
+    return (art_node_t *)((uintptr_t)val | 1);
+}
+
+static inline art_val_t *art_node_to_leaf(const art_node_t *node) {
+    return (art_val_t *)((uintptr_t)node & ~(uintptr_t)1);
+}
+
+static void art_init_inner(art_inner_node_t *node, uint8_t typecode,
+                           const art_key_chunk_t *prefix,
+                           uint8_t prefix_size) {
+    assert(prefix_size < ART_KEY_BYTES);
+    node->typecode = typecode;
+    node->prefix_size = prefix_size;
+    memcpy(node->prefix, prefix, prefix_size);
+}
+
+static art_node4_t *art_node4_create(const art_key_chunk_t *prefix,
+                                     uint8_t prefix_size) {
+    art_node4_t *node = (art_node4_t *)roaring_malloc(sizeof(art_node4_t));
+    if (node == NULL) return NULL;
+    art_init_inner(&node->base, ART_NODE4_TYPE, prefix, prefix_size);
+    node->count = 0;
+    return node;
+}
+
+static art_node16_t *art_node16_create(const art_inner_node_t *header) {
+    art_node16_t *node = (art_node16_t *)roaring_malloc(sizeof(art_node16_t));
+    if (node == NULL) return NULL;
+    art_init_inner(&node->base, ART_NODE16_TYPE, header->prefix,
+                   header->prefix_size);
+    node->count = 0;
+    return node;
+}
+
+static art_node48_t *art_node48_create(const art_inner_node_t *header) {
+    art_node48_t *node = (art_node48_t *)roaring_malloc(sizeof(art_node48_t));
+    if (node == NULL) return NULL;
+    art_init_inner(&node->base, ART_NODE48_TYPE, header->prefix,
+                   header->prefix_size);
+    node->count = 0;
+    memset(node->keys, ART_NODE48_EMPTY, sizeof(node->keys));
+    memset(node->children, 0, sizeof(node->children));
+    return node;
+}
+
+static art_node256_t *art_node256_create(const art_inner_node_t *header) {
+    art_node256_t *node =
+        (art_node256_t *)roaring_malloc(sizeof(art_node256_t));
+    if (node == NULL) return NULL;
+    art_init_inner(&node->base, ART_NODE256_TYPE, header->prefix,
+                   header->prefix_size);
+    node->count = 0;
+    memset(node->children, 0, sizeof(node->children));
+    return node;
+}
+
+static int art_node_count(const art_inner_node_t *node) {
+    switch (node->typecode) {
+        case ART_NODE4_TYPE:
+            return ((const art_node4_t *)node)->count;
+        case ART_NODE16_TYPE:
+            return ((const art_node16_t *)node)->count;
+        case ART_NODE48_TYPE:
+            return ((const art_node48_t *)node)->count;
+        default:
+            return ((const art_node256_t *)node)->count;
+    }
+}
+
+// node4 and node16 share their layout: sorted keys and their children
+static void art_sorted_node(art_inner_node_t *node, art_key_chunk_t **keys,
+                            art_node_t ***children, uint8_t **count) {
+    if (node->typecode == ART_NODE4_TYPE) {
+        art_node4_t *n = (art_node4_t *)node;
+        *keys = n->keys;
+        *children = n->children;
+        *count = &n->count;
+    } else {
+        art_node16_t *n = (art_node16_t *)node;
+        *keys = n->keys;
+        *children = n->children;
+        *count = &n->count;
+    }
+}
+
+// the address of the child of node under byte, or NULL if there is none
+static art_node_t **art_find_child(art_inner_node_t *node,
+                                   art_key_chunk_t byte) {
+    switch (node->typecode) {
+        case ART_NODE4_TYPE:
+        case ART_NODE16_TYPE: {
+            art_key_chunk_t *keys;
+            art_node_t **children;
+            uint8_t *count;
+            art_sorted_node(node, &keys, &children, &count);
+            for (uint8_t i = 0; i < *count; i++) {
+                if (keys[i] == byte) return &children[i];
+            }
+            return NULL;
+        }
+        case ART_NODE48_TYPE: {
+            art_node48_t *n = (art_node48_t *)node;
+            const uint8_t index = n->keys[byte];
+            return index == ART_NODE48_EMPTY ? NULL : &n->children[index];
+        }
+        default: {
+            art_node256_t *n = (art_node256_t *)node;
+            return n->children[byte] == NULL ? NULL : &n->children[byte];
+        }
+    }
+}
+
+/*
+ * Returns the smallest byte >= from (resp. the greatest byte <= from, if
+ * forward is false) having a child, and sets *child to it. Returns -1 if
+ * there is none.
+ */
+static int art_seek_child(const art_inner_node_t *node, int from,
+                          bool forward, art_node_t **child) {
+    const int step = forward ? 1 : -1;
+    switch (node->typecode) {
+        case ART_NODE4_TYPE:
+        case ART_NODE16_TYPE: {
+            art_key_chunk_t *keys;
+            art_node_t **children;
+            uint8_t *count;
+            art_sorted_node((art_inner_node_t *)node, &keys, &children,
+                            &count);
+            for (int i = forward ? 0 : *count - 1; i >= 0 && i < *count;
+                 i += step) {
+                if (forward ? keys[i] >= from : keys[i] <= from) {
+                    *child = children[i];
+                    return keys[i];
+                }
+            }
+            return -1;
+        }
+        case ART_NODE48_TYPE: {
+            const art_node48_t *n = (const art_node48_t *)node;
+            for (int byte = from; byte >= 0 && byte < 256; byte += step) {
+                if (n->keys[byte] != ART_NODE48_EMPTY) {
+                    *child = n->children[n->keys[byte]];
+                    return byte;
+                }
+            }
+            return -1;
+        }
+        default: {
+            const art_node256_t *n = (const art_node256_t *)node;
+            for (int byte = from; byte >= 0 && byte < 256; byte += step) {
+                if (n->children[byte] != NULL) {
+                    *child = n->children[byte];
+                    return byte;
+                }
+            }
+            return -1;
+        }
+    }
+}
+
+static void art_sorted_insert(art_key_chunk_t *keys, art_node_t **children,
+                              uint8_t *count, art_key_chunk_t byte,
+                              art_node_t *child) {
+    uint8_t i = 0;
+    while (i < *count && keys[i] < byte) i++;
+    memmove(keys + i + 1, keys + i, *count - i);
+    memmove(children + i + 1, children + i,
+            (*count - i) * sizeof(art_node_t *));
+    keys[i] = byte;
+    children[i] = child;
+    (*count)++;
+}
+
+static void art_node48_insert(art_node48_t *node, art_key_chunk_t byte,
+                              art_node_t *child) {
+    uint8_t slot = 0;
+    while (node->children[slot] != NULL) slot++;
+    node->keys[byte] = slot;
+    node->children[slot] = child;
+    node->count++;
+}
+
+/*
+ * Adds child under byte, which must be free, moving node to a larger node
+ * if it is full. Returns the node that replaces node, or NULL, leaving node
+ * unchanged, in case of allocation failure.
+ */
+static art_inner_node_t *art_add_child(art_inner_node_t *node,
+                                       art_key_chunk_t byte,
+                                       art_node_t *child) {
+    switch (node->typecode) {
+        case ART_NODE4_TYPE: {
+            art_node4_t *n = (art_node4_t *)node;
+            if (n->count < 4) {
+                art_sorted_insert(n->keys, n->children, &n->count, byte,
+                                  child);
+                return node;
+            }
+            art_node16_t *bigger = art_node16_create(node);
+            if (bigger == NULL) return NULL;
+            memcpy(bigger->keys, n->keys, 4);
+            memcpy(bigger->children, n->children, 4 * sizeof(art_node_t *));
+            bigger->count = 4;
+            roaring_free(n);
+            art_sorted_insert(bigger->keys, bigger->children, &bigger->count,
+                              byte, child);
+            return &bigger->base;
+        }
+        case ART_NODE16_TYPE: {
+            art_node16_t *n = (art_node16_t *)node;
+            if (n->count < 16) {
+                art_sorted_insert(n->keys, n->children, &n->count, byte,
+                                  child);
+                return node;
+            }
+            art_node48_t *bigger = art_node48_create(node);
+            if (bigger == NULL) return NULL;
+            for (uint8_t i = 0; i < 16; i++) {
+                art_node48_insert(bigger, n->keys[i], n->children[i]);
+            }
+            roaring_free(n);
+            art_node48_insert(bigger, byte, child);
+            return &bigger->base;
+        }
+        case ART_NODE48_TYPE: {
+            art_node48_t *n = (art_node48_t *)node;
+            if (n->count < 48) {
+                art_node48_insert(n, byte, child);
+                return node;
+            }
+            art_node256_t *bigger = art_node256_create(node);
+            if (bigger == NULL) return NULL;
+            for (int b = 0; b < 256; b++) {
+                if (n->keys[b] != ART_NODE48_EMPTY) {
+                    bigger->children[b] = n->children[n->keys[b]];
+                }
+            }
+            bigger->count = 48;
+            roaring_free(n);
+            bigger->children[byte] = child;
+            bigger->count++;
+            return &bigger->base;
+        }
+        default: {
+            art_node256_t *n = (art_node256_t *)node;
+            n->children[byte] = child;
+            n->count++;
+            return node;
+        }
+    }
+}
+
+/*
+ * Moves node to a smaller node once it has few enough children. If the
+ * allocation fails, node simply stays as it is.
+ */
+static art_inner_node_t *art_shrink(art_inner_node_t *node) {
+    switch (node->typecode) {
+        case ART_NODE16_TYPE: {
+            art_node16_t *n = (art_node16_t *)node;
+            if (n->count > 3) return node;
+            art_node4_t *smaller =
+                art_node4_create(node->prefix, node->prefix_size);
+            if (smaller == NULL) return node;
+            memcpy(smaller->keys, n->keys, n->count);
+            memcpy(smaller->children, n->children,
+                   n->count * sizeof(art_node_t *));
+            smaller->count = n->count;
+            roaring_free(n);
+            return &smaller->base;
+        }
+        case ART_NODE48_TYPE: {
+            art_node48_t *n = (art_node48_t *)node;
+            if (n->count > 12) return node;
+            art_node16_t *smaller = art_node16_create(node);
+            if (smaller == NULL) return node;
+            for (int b = 0; b < 256; b++) {
+                if (n->keys[b] != ART_NODE48_EMPTY) {
+                    smaller->keys[smaller->count] = (art_key_chunk_t)b;
+                    smaller->children[smaller->count] =
+                        n->children[n->keys[b]];
+                    smaller->count++;
+                }
+            }
+            roaring_free(n);
+            return &smaller->base;
+        }
+        case ART_NODE256_TYPE: {
+            art_node256_t *n = (art_node256_t *)node;
+            if (n->count > 36) return node;
+            art_node48_t *smaller = art_node48_create(node);
+            if (smaller == NULL) return node;
+            for (int b = 0; b < 256; b++) {
+                if (n->children[b] != NULL) {
+                    art_node48_insert(smaller, (art_key_chunk_t)b,
+                                      n->children[b]);
+                }
+            }
+            roaring_free(n);
+            return &smaller->base;
+        }
+        default:
+            return node;
+    }
+}
+
+/*
+ * Removes the child under byte, and returns what replaces node: its only
+ * remaining child, which then takes over its prefix, or the node itself,
+ * possibly moved to a smaller node.
+ */
+static art_node_t *art_remove_child(art_inner_node_t *node,
+                                    art_key_chunk_t byte) {
+    switch (node->typecode) {
+        case ART_NODE4_TYPE:
+        case ART_NODE16_TYPE: {
+            art_key_chunk_t *keys;
+            art_node_t **children;
+            uint8_t *count;
+            art_sorted_node(node, &keys, &children, &count);
+            uint8_t i = 0;
+            while (keys[i] != byte) i++;
+            memmove(keys + i, keys + i + 1, *count - i - 1);
+            memmove(children + i, children + i + 1,
+                    (*count - i - 1) * sizeof(art_node_t *));
+            (*count)--;
+            break;
+        }
+        case ART_NODE48_TYPE: {
+            art_node48_t *n = (art_node48_t *)node;
+            n->children[n->keys[byte]] = NULL;
+            n->keys[byte] = ART_NODE48_EMPTY;
+            n->count--;
+            break;
+        }
+        default: {
+            art_node256_t *n = (art_node256_t *)node;
+            n->children[byte] = NULL;
+            n->count--;
+            break;
+        }
+    }
+    if (art_node_count(node) > 1) return art_shrink(node);
+
+    art_node_t *child;
+    const int child_byte = art_seek_child(node, 0, true, &child);
+    assert(child_byte >= 0);
+    if (!art_is_leaf(child)) {
+        // the child's key bytes are now found above it
+        art_inner_node_t *inner = (art_inner_node_t *)child;
+        const uint8_t size = node->prefix_size + 1 + inner->prefix_size;
+        assert(size < ART_KEY_BYTES);
+        art_key_chunk_t prefix[ART_KEY_BYTES];
+        memcpy(prefix, node->prefix, node->prefix_size);
+        prefix[node->prefix_size] = (art_key_chunk_t)child_byte;
+        memcpy(prefix + node->prefix_size + 1, inner->prefix,
+               inner->prefix_size);
+        memcpy(inner->prefix, prefix, size);
+        inner->prefix_size = size;
+    }
+    roaring_free(node);
+    return child;
+}
+
+/*
+ * Inserts val under key in the subtree of node, at depth, and returns the
+ * node that replaces node, or NULL, leaving the subtree unchanged, in case
+ * of allocation failure.
+ */
+static art_node_t *art_insert_at(art_node_t *node, const art_key_chunk_t *key,
+                                 uint8_t depth, art_val_t *val) {
+    if (art_is_leaf(node)) {
+        // both keys go under a new node, after their common bytes
+        const art_key_chunk_t *leaf_key = art_node_to_leaf(node)->key;
+        uint8_t common = 0;
+        while (leaf_key[depth + common] == key[depth + common]) {
+            common++;
+        }
+        art_node4_t *parent = art_node4_create(key + depth, common);
+        if (parent == NULL) return NULL;
+        art_sorted_insert(parent->keys, parent->children, &parent->count,
+                          leaf_key[depth + common], node);
+        art_sorted_insert(parent->keys, parent->children, &parent->count,
+                          key[depth + common], art_leaf_to_node(val));
+        return parent;
+    }
+    art_inner_node_t *inner = (art_inner_node_t *)node;
+    uint8_t common = 0;
+    while (common < inner->prefix_size &&
+           inner->prefix[common] == key[depth + common]) {
+        common++;
+    }
+    if (common < inner->prefix_size) {
+        // the key leaves the prefix: a new node splits it
+        art_node4_t *parent = art_node4_create(inner->prefix, common);
+        if (parent == NULL) return NULL;
+        const art_key_chunk_t inner_byte = inner->prefix[common];
+        inner->prefix_size -= common + 1;
+        memmove(inner->prefix, inner->prefix + common + 1,
+                inner->prefix_size);
+        art_sorted_insert(parent->keys, parent->children, &parent->count,
+                          inner_byte, inner);
+        art_sorted_insert(parent->keys, parent->children, &parent->count,
+                          key[depth + common], art_leaf_to_node(val));
+        return parent;
+    }
+    depth += inner->prefix_size;
+    art_node_t **slot = art_find_child(inner, key[depth]);
+    if (slot != NULL) {
+        art_node_t *child = art_insert_at(*slot, key, depth + 1, val);
+        if (child == NULL) return NULL;
+        *slot = child;
+        return node;
+    }
+    return art_add_child(inner, key[depth], art_leaf_to_node(val));
+}
+
+bool art_insert(art_t *art, const art_key_chunk_t *key, art_val_t *val) {
+    assert(((uintptr_t)val & 1) == 0);
+    assert(art_find(art, key) == NULL);
+    memcpy(val->key, key, ART_KEY_BYTES);
+    if (art->root == NULL) {
+        art->root = art_leaf_to_node(val);
+        return true;
+    }
+    art_node_t *root = art_insert_at(art->root, key, 0, val);
+    if (root == NULL) return false;
+    art->root = root;
+    return true;
+}
+
+// removes the leaf of key, which is in the subtree of node, at depth
+static art_node_t *art_erase_at(art_node_t *node, const art_key_chunk_t *key,
+                                uint8_t depth) {
+    if (art_is_leaf(node)) return NULL;
+    art_inner_node_t *inner = (art_inner_node_t *)node;
+    depth += inner->prefix_size;
+    art_node_t **slot = art_find_child(inner, key[depth]);
+    art_node_t *child = art_erase_at(*slot, key, depth + 1);
+    if (child != NULL) {
+        *slot = child;
+        return node;
+    }
+    return art_remove_child(inner, key[depth]);
+}
+
+art_val_t *art_erase(art_t *art, const art_key_chunk_t *key) {
+    art_val_t *val = art_find(art, key);
+    if (val == NULL) return NULL;
+    art->root = art_erase_at(art->root, key, 0);
+    return val;
+}
+
+art_val_t *art_find(const art_t *art, const art_key_chunk_t *key) {
+    art_node_t *node = art->root;
+    uint8_t depth = 0;
+    while (node != NULL && !art_is_leaf(node)) {
+        art_inner_node_t *inner = (art_inner_node_t *)node;
+        if (memcmp(inner->prefix, key + depth, inner->prefix_size) != 0) {
+            return NULL;
+        }
+        depth += inner->prefix_size;
+        art_node_t **slot = art_find_child(inner, key[depth]);
+        node = (slot == NULL) ? NULL : *slot;
+        depth++;
+    }
+    if (node == NULL) return NULL;
+    art_val_t *val = art_node_to_leaf(node);
+    return memcmp(val->key, key, ART_KEY_BYTES) == 0 ? val : NULL;
+}
+
+static void art_free_node(art_node_t *node) {
+    if (art_is_leaf(node)) return;
+    art_inner_node_t *inner = (art_inner_node_t *)node;
+    art_node_t *child;
+    for (int byte = art_seek_child(inner, 0, true, &child); byte >= 0;
+         byte = (byte < 255) ? art_seek_child(inner, byte + 1, true, &child)
+                             : -1) {
+        art_free_node(child);
+    }
+    roaring_free(inner);
+}
+
+void art_free(art_t *art) {
+    if (art->root != NULL) art_free_node(art->root);
+    art->root = NULL;
+}
+
+// follows the first (or last) children from node down to a leaf
+static void art_iterator_descend(art_iterator_t *iterator, art_node_t *node,
+                                 bool first) {
+    while (!art_is_leaf(node)) {
+        art_inner_node_t *inner = (art_inner_node_t *)node;
+        art_node_t *child;
+        const int byte = art_seek_child(inner, first ? 0 : 255, first, &child);
+        assert(byte >= 0);
+        art_iterator_frame_t *frame =
+            &iterator->frames[iterator->frame_count++];
+        frame->node = inner;
+        frame->child = (uint8_t)byte;
+        node = child;
+    }
+    iterator->value = art_node_to_leaf(node);
+}
+
+// moves to the first leaf after the children visited by the frames
+static bool art_iterator_ascend_next(art_iterator_t *iterator) {
+    while (iterator->frame_count > 0) {
+        art_iterator_frame_t *frame =
+            &iterator->frames[iterator->frame_count - 1];
+        art_node_t *child;
+        const int byte =
+            (frame->child < 255)
+                ? art_seek_child((art_inner_node_t *)frame->node,
+                                 frame->child + 1, true, &child)
+                : -1;
+        if (byte >= 0) {
+            frame->child = (uint8_t)byte;
+            art_iterator_descend(iterator, child, true);
+            return true;
+        }
+        iterator->frame_count--;
+    }
+    iterator->value = NULL;
+    return false;
+}
+
+art_iterator_t art_init_iterator(const art_t *art, bool first) {
+    art_iterator_t iterator;
+    iterator.value = NULL;
+    iterator.frame_count = 0;
+    if (art->root != NULL) art_iterator_descend(&iterator, art->root, first);
+    return iterator;
+}
+
+bool art_iterator_next(art_iterator_t *iterator) {
+    if (iterator->value == NULL) return false;
+    return art_iterator_ascend_next(iterator);
+}
+
+art_iterator_t art_lower_bound(const art_t *art, const art_key_chunk_t *key) {
+    art_iterator_t iterator;
+    iterator.value = NULL;
+    iterator.frame_count = 0;
+    art_node_t *node = art->root;
+    if (node == NULL) return iterator;
+    uint8_t depth = 0;
+    while (!art_is_leaf(node)) {
+        art_inner_node_t *inner = (art_inner_node_t *)node;
+        const int cmp = memcmp(inner->prefix, key + depth, inner->prefix_size);
+        if (cmp > 0) {  // all the keys below are greater
+            art_iterator_descend(&iterator, node, true);
+            return iterator;
+        }
+        if (cmp < 0) {  // all the keys below are smaller
+            art_iterator_ascend_next(&iterator);
+            return iterator;
+        }
+        depth += inner->prefix_size;
+        art_node_t *child;
+        const int byte = art_seek_child(inner, key[depth], true, &child);
+        if (byte < 0) {
+            art_iterator_ascend_next(&iterator);
+            return iterator;
+        }
+        art_iterator_frame_t *frame = &iterator.frames[iterator.frame_count++];
+        frame->node = inner;
+        frame->child = (uint8_t)byte;
+        if (byte > key[depth]) {
+            art_iterator_descend(&iterator, child, true);
+            return iterator;
+        }
+        node = child;
+        depth++;
+    }
+    iterator.value = art_node_to_leaf(node);
+    if (memcmp(iterator.value->key, key, ART_KEY_BYTES) < 0) {
+        art_iterator_ascend_next(&iterator);
+    }
+    return iterator;
+}
+
+art_val_t *art_iterator_erase(art_t *art, art_iterator_t *iterator) {
+    art_val_t *val = iterator->value;
+    if (val == NULL) return NULL;
+    art_key_chunk_t key[ART_KEY_BYTES];
+    memcpy(key, val->key, ART_KEY_BYTES);
+    art_erase(art, key);
+    *iterator = art_lower_bound(art, key);
+    return val;
+}
+
+#ifdef __cplusplus
+} } }  // extern "C" { namespace roaring { namespace internal {
+#endif
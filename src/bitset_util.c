@@ -605,7 +605,65 @@ size_t bitset_extract_setbits_avx2(const uint64_t *words, size_t length,
     }
     return out - initout;
 }
-CROARING_UNTARGET_REGION
+CROARING_UNTARGET_AVX2
+
+#if CROARING_COMPILER_SUPPORTS_AVX512
+// Byte indexes 0, 1, ..., 63, compressed by the bits of a word.
+static const uint8_t vbmi2_index_table[64] = {
+    0,  1,  2,  3,  4,  5,  6,  7,  8,  9,  10, 11, 12, 13, 14, 15,
+    16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31,
+    32, 33, 34, 35, 36, 37, 38, 39, 40, 41, 42, 43, 44, 45, 46, 47,
+    48, 49, 50, 51, 52, 53, 54, 55, 56, 57, 58, 59, 60, 61, 62, 63};
+
+CROARING_AVX512_IGNORE_UNINITIALIZED
+CROARING_TARGET_AVX512
+size_t bitset_extract_setbits_avx512(const uint64_t *words, size_t length,
+                                     uint32_t *out, size_t outcapacity,
+                                     uint32_t base) {
+    uint32_t *initout = out;
+    uint32_t *safeout = out + outcapacity;
+    const __m512i index_table = _mm512_loadu_si512(vbmi2_index_table);
+    __m512i baseVec = _mm512_set1_epi32(base);
+    const __m512i incVec = _mm512_set1_epi32(64);
+    size_t i = 0;
+    for (; (i < length) && (out + 64 <= safeout); ++i) {
+        uint64_t w = words[i];
+        if (w != 0) {
+            // the positions of the set bits, as bytes, packed to the front
+            __m512i vec = _mm512_maskz_compress_epi8(w, index_table);
+            __m512i r1 = _mm512_cvtepu8_epi32(_mm512_extracti32x4_epi32(vec, 0));
+            __m512i r2 = _mm512_cvtepu8_epi32(_mm512_extracti32x4_epi32(vec, 1));
+            __m512i r3 = _mm512_cvtepu8_epi32(_mm512_extracti32x4_epi32(vec, 2));
+            __m512i r4 = _mm512_cvtepu8_epi32(_mm512_extracti32x4_epi32(vec, 3));
+            _mm512_storeu_si512((__m512i *)out, _mm512_add_epi32(r1, baseVec));
+            _mm512_storeu_si512((__m512i *)(out + 16),
+                                _mm512_add_epi32(r2, baseVec));
+            _mm512_storeu_si512((__m512i *)(out + 32),
+                                _mm512_add_epi32(r3, baseVec));
+            _mm512_storeu_si512((__m512i *)(out + 48),
+                                _mm512_add_epi32(r4, baseVec));
+            out += _mm_popcnt_u64(w);
+        }
+        baseVec = _mm512_add_epi32(baseVec, incVec);
+    }
+    base += i * 64;
+    for (; (i < length) && (out < safeout); ++i) {
+        uint64_t w = words[i];
+        while ((w != 0) && (out < safeout)) {
+            uint64_t t = w & (~w + 1);
+            int r = __builtin_ctzll(w);
+            uint32_t val = r + base;
+            memcpy(out, &val, sizeof(uint32_t));
+            out++;
+            w ^= t;
+        }
+        base += 64;
+    }
+    return out - initout;
+}
+CROARING_UNTARGET_AVX512
+CROARING_AVX512_RESTORE_UNINITIALIZED
+#endif  // CROARING_COMPILER_SUPPORTS_AVX512
 #endif  // CROARING_IS_X64
 
 size_t bitset_extract_setbits(const uint64_t *words, size_t length,
@@ -709,7 +767,7 @@ size_t bitset_extract_setbits_sse_uint16(const uint64_t *words, size_t length,
     }
     return out - initout;
 }
-CROARING_UNTARGET_REGION
+CROARING_UNTARGET_AVX2
 #endif
 
 /*
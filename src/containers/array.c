@@ -31,16 +31,16 @@ extern inline bool array_container_full(const array_container_t *array);
 array_container_t *array_container_create_given_capacity(int32_t size) {
     array_container_t *container;
 
-    if ((container = (array_container_t *)malloc(sizeof(array_container_t))) ==
+    if ((container = (array_container_t *)roaring_malloc(sizeof(array_container_t))) ==
         NULL) {
         return NULL;
     }
 
     if( size <= 0 ) { // we don't want to rely on malloc(0)
         container->array = NULL;
-    } else if ((container->array = (uint16_t *)malloc(sizeof(uint16_t) * size)) ==
+    } else if ((container->array = (uint16_t *)roaring_malloc(sizeof(uint16_t) * size)) ==
         NULL) {
-        free(container);
+        roaring_free(container);
         return NULL;
     }
 
@@ -85,13 +85,13 @@ int array_container_shrink_to_fit(array_container_t *src) {
     int savings = src->capacity - src->cardinality;
     src->capacity = src->cardinality;
     if( src->capacity == 0) { // we do not want to rely on realloc for zero allocs
-      free(src->array);
+      roaring_free(src->array);
       src->array = NULL;
     } else {
       uint16_t *oldarray = src->array;
       src->array =
-        (uint16_t *)realloc(oldarray, src->capacity * sizeof(uint16_t));
-      if (src->array == NULL) free(oldarray);  // should never happen?
+        (uint16_t *)roaring_realloc(oldarray, src->capacity * sizeof(uint16_t));
+      if (src->array == NULL) roaring_free(oldarray);  // should never happen?
     }
     return savings;
 }
@@ -99,10 +99,10 @@ int array_container_shrink_to_fit(array_container_t *src) {
 /* Free memory. */
 void array_container_free(array_container_t *arr) {
     if(arr->array != NULL) {// Jon Strabala reports that some tools complain otherwise
-      free(arr->array);
+      roaring_free(arr->array);
       arr->array = NULL; // pedantic
     }
-    free(arr);
+    roaring_free(arr);
 }
 
 static inline int32_t grow_capacity(int32_t capacity) {
@@ -127,14 +127,14 @@ void array_container_grow(array_container_t *container, int32_t min,
 
     if (preserve) {
         container->array =
-            (uint16_t *)realloc(array, new_capacity * sizeof(uint16_t));
-        if (container->array == NULL) free(array);
+            (uint16_t *)roaring_realloc(array, new_capacity * sizeof(uint16_t));
+        if (container->array == NULL) roaring_free(array);
     } else {
         // Jon Strabala reports that some tools complain otherwise
         if (array != NULL) {
-          free(array);
+          roaring_free(array);
         }
-        container->array = (uint16_t *)malloc(new_capacity * sizeof(uint16_t));
+        container->array = (uint16_t *)roaring_malloc(new_capacity * sizeof(uint16_t));
     }
 
     //  handle the case where realloc fails
@@ -269,18 +269,8 @@ void array_container_intersection(const array_container_t *array1,
         out->cardinality = intersect_skewed_uint16(
             array2->array, card_2, array1->array, card_1, out->array);
     } else {
-#ifdef CROARING_IS_X64
-       if( croaring_avx2() ) {
-        out->cardinality = intersect_vector16(
+        out->cardinality = fast_intersect_uint16(
             array1->array, card_1, array2->array, card_2, out->array);
-       } else {
-        out->cardinality = intersect_uint16(array1->array, card_1,
-                                            array2->array, card_2, out->array);
-       }
-#else
-        out->cardinality = intersect_uint16(array1->array, card_1,
-                                            array2->array, card_2, out->array);
-#endif
     }
 }
 
@@ -297,18 +287,8 @@ int array_container_intersection_cardinality(const array_container_t *array1,
         return intersect_skewed_uint16_cardinality(array2->array, card_2,
                                                    array1->array, card_1);
     } else {
-#ifdef CROARING_IS_X64
-    if( croaring_avx2() ) {
-        return intersect_vector16_cardinality(array1->array, card_1,
-                                              array2->array, card_2);
-    } else {
-        return intersect_uint16_cardinality(array1->array, card_1,
-                                            array2->array, card_2);
-    }
-#else
-        return intersect_uint16_cardinality(array1->array, card_1,
-                                            array2->array, card_2);
-#endif
+        return fast_intersect_uint16_cardinality(array1->array, card_1,
+                                                 array2->array, card_2);
     }
 }
 
@@ -459,6 +439,94 @@ bool array_container_iterate64(const array_container_t *cont, uint32_t base,
     return true;
 }
 
+uint32_t array_container_rank_many(const array_container_t *arr,
+                                   uint64_t start_rank, const uint32_t *begin,
+                                   const uint32_t *end, uint64_t *ans) {
+    const uint16_t high = (uint16_t)((*begin) >> 16);
+    // the values are sorted, so the position only ever moves forward
+    int32_t pos = 0;
+    const uint32_t *iter = begin;
+    for (; iter != end; iter++) {
+        uint32_t x = *iter;
+        if ((uint16_t)(x >> 16) != high) break;
+        uint16_t xlow = (uint16_t)x;
+        if (pos < arr->cardinality && arr->array[pos] < xlow) {
+            pos = advanceUntil(arr->array, pos, arr->cardinality, xlow);
+        }
+        int32_t rank = pos;
+        if (pos < arr->cardinality && arr->array[pos] == xlow) {
+            rank++;
+        }
+        *(ans++) = start_rank + rank;
+    }
+    return (uint32_t)(iter - begin);
+}
+
+uint32_t array_container_select_many(const array_container_t *arr,
+                                     uint32_t start_rank,
+                                     const uint32_t *begin,
+                                     const uint32_t *end, uint32_t *element) {
+    const uint32_t *iter = begin;
+    for (; iter != end; iter++) {
+        uint32_t rank = *iter - start_rank;
+        if (rank >= (uint32_t)arr->cardinality) break;
+        *(element++) = arr->array[rank];
+    }
+    return (uint32_t)(iter - begin);
+}
+
+void array_container_contains_many(const array_container_t *arr,
+                                   const uint32_t *vals, size_t n,
+                                   bool *results) {
+    int32_t pos = 0;
+    uint16_t prev = 0;
+    for (size_t i = 0; i < n; i++) {
+        uint16_t low = (uint16_t)vals[i];
+        if (low < prev) {
+            pos = 0;  // out of order, start over
+        }
+        prev = low;
+        if (pos < arr->cardinality && arr->array[pos] < low) {
+            pos = advanceUntil(arr->array, pos, arr->cardinality, low);
+        }
+        results[i] = pos < arr->cardinality && arr->array[pos] == low;
+    }
+}
+
+bool array_container_offset(const array_container_t *c,
+                            array_container_t **lo, array_container_t **hi,
+                            uint16_t offset) {
+    // values from split onwards go past 1 << 16
+    assert(offset != 0);
+    int32_t split = binarySearch(c->array, c->cardinality,
+                                 (uint16_t)((1 << 16) - offset));
+    if (split < 0) split = -split - 1;
+    array_container_t *lo_part = NULL, *hi_part = NULL;
+    if (lo != NULL && split > 0) {
+        lo_part = array_container_create_given_capacity(split);
+        if (lo_part == NULL) return false;
+        for (int32_t i = 0; i < split; i++) {
+            lo_part->array[i] = c->array[i] + offset;
+        }
+        lo_part->cardinality = split;
+    }
+    if (hi != NULL && c->cardinality > split) {
+        int32_t card = c->cardinality - split;
+        hi_part = array_container_create_given_capacity(card);
+        if (hi_part == NULL) {
+            if (lo_part != NULL) array_container_free(lo_part);
+            return false;
+        }
+        for (int32_t i = 0; i < card; i++) {
+            hi_part->array[i] = (uint16_t)(c->array[split + i] + offset);
+        }
+        hi_part->cardinality = card;
+    }
+    if (lo != NULL) *lo = lo_part;
+    if (hi != NULL) *hi = hi_part;
+    return true;
+}
+
 #ifdef __cplusplus
 } } }  // extern "C" { namespace roaring { namespace internal {
 #endif
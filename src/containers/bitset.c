@@ -47,16 +47,16 @@ void bitset_container_set_all(bitset_container_t *bitset) {
 /* Create a new bitset. Return NULL in case of failure. */
 bitset_container_t *bitset_container_create(void) {
     bitset_container_t *bitset =
-        (bitset_container_t *)malloc(sizeof(bitset_container_t));
+        (bitset_container_t *)roaring_malloc(sizeof(bitset_container_t));
 
     if (!bitset) {
         return NULL;
     }
     // sizeof(__m256i) == 32
-    bitset->words = (uint64_t *)roaring_bitmap_aligned_malloc(
+    bitset->words = (uint64_t *)roaring_aligned_malloc(
         32, sizeof(uint64_t) * BITSET_CONTAINER_SIZE_IN_WORDS);
     if (!bitset->words) {
-        free(bitset);
+        roaring_free(bitset);
         return NULL;
     }
     bitset_container_clear(bitset);
@@ -102,25 +102,25 @@ void bitset_container_add_from_range(bitset_container_t *bitset, uint32_t min,
 /* Free memory. */
 void bitset_container_free(bitset_container_t *bitset) {
     if(bitset->words != NULL) {// Jon Strabala reports that some tools complain otherwise
-      roaring_bitmap_aligned_free(bitset->words);
+      roaring_aligned_free(bitset->words);
       bitset->words = NULL; // pedantic
     }
-    free(bitset);
+    roaring_free(bitset);
 }
 
 /* duplicate container. */
 bitset_container_t *bitset_container_clone(const bitset_container_t *src) {
     bitset_container_t *bitset =
-        (bitset_container_t *)malloc(sizeof(bitset_container_t));
+        (bitset_container_t *)roaring_malloc(sizeof(bitset_container_t));
 
     if (!bitset) {
         return NULL;
     }
     // sizeof(__m256i) == 32
-    bitset->words = (uint64_t *)roaring_bitmap_aligned_malloc(
+    bitset->words = (uint64_t *)roaring_aligned_malloc(
         32, sizeof(uint64_t) * BITSET_CONTAINER_SIZE_IN_WORDS);
     if (!bitset->words) {
-        free(bitset);
+        roaring_free(bitset);
         return NULL;
     }
     bitset->cardinality = src->cardinality;
@@ -153,6 +153,9 @@ bool bitset_container_intersect(const bitset_container_t *src_1,
 #ifndef WORDS_IN_AVX2_REG
 #define WORDS_IN_AVX2_REG sizeof(__m256i) / sizeof(uint64_t)
 #endif
+#ifndef WORDS_IN_AVX512_REG
+#define WORDS_IN_AVX512_REG sizeof(__m512i) / sizeof(uint64_t)
+#endif
 /* Get the number of bits set (force computation) */
 static inline int _scalar_bitset_container_compute_cardinality(const bitset_container_t *bitset) {
   const uint64_t *words = bitset->words;
@@ -165,16 +168,42 @@ static inline int _scalar_bitset_container_compute_cardinality(const bitset_cont
   }
   return sum;
 }
+#if CROARING_COMPILER_SUPPORTS_AVX512
+static int _avx512_bitset_container_compute_cardinality(const bitset_container_t *bitset) {
+  return (int) avx512_vpopcount(
+    (const __m512i *)bitset->words,
+    BITSET_CONTAINER_SIZE_IN_WORDS / (WORDS_IN_AVX512_REG));
+}
+#endif
+static int _avx2_bitset_container_compute_cardinality(const bitset_container_t *bitset) {
+  return (int) avx2_harley_seal_popcount256(
+    (const __m256i *)bitset->words,
+    BITSET_CONTAINER_SIZE_IN_WORDS / (WORDS_IN_AVX2_REG));
+}
+
+typedef int (*bitset_cardinality_fn)(const bitset_container_t *bitset);
+static int _resolve_bitset_container_compute_cardinality(const bitset_container_t *bitset);
+CROARING_DISPATCH_POINTER(bitset_cardinality_fn, bitset_cardinality_kernel,
+                          _resolve_bitset_container_compute_cardinality);
+
+static int _resolve_bitset_container_compute_cardinality(const bitset_container_t *bitset) {
+  bitset_cardinality_fn kernel = _scalar_bitset_container_compute_cardinality;
+#if CROARING_COMPILER_SUPPORTS_AVX512
+  if( croaring_avx512() ) {
+    kernel = _avx512_bitset_container_compute_cardinality;
+  } else
+#endif
+  if( croaring_avx2() ) {
+    kernel = _avx2_bitset_container_compute_cardinality;
+  }
+  bitset_cardinality_kernel = kernel;
+  return kernel(bitset);
+}
+
 /* Get the number of bits set (force computation) */
 int bitset_container_compute_cardinality(const bitset_container_t *bitset) {
-    if( croaring_avx2() ) {
-      return (int) avx2_harley_seal_popcount256(
-        (const __m256i *)bitset->words,
-        BITSET_CONTAINER_SIZE_IN_WORDS / (WORDS_IN_AVX2_REG));
-    } else {
-      return _scalar_bitset_container_compute_cardinality(bitset);
-
-    }
+    bitset_cardinality_fn kernel = bitset_cardinality_kernel;
+    return kernel(bitset);
 }
 
 #elif defined(USENEON)
@@ -314,73 +343,150 @@ int bitset_container_compute_cardinality(const bitset_container_t *bitset) {
 
 // we duplicate the function because other containers use the "or" term, makes API more consistent
 CROARING_TARGET_AVX2
-AVX_BITSET_CONTAINER_FN1(CROARING_TARGET_AVX2, or,    |, _mm256_or_si256, vorrq_u64, CROARING_UNTARGET_REGION)
-CROARING_UNTARGET_REGION
+AVX_BITSET_CONTAINER_FN1(CROARING_TARGET_AVX2, or,    |, _mm256_or_si256, vorrq_u64, CROARING_UNTARGET_AVX2)
+CROARING_UNTARGET_AVX2
 CROARING_TARGET_AVX2
-AVX_BITSET_CONTAINER_FN1(CROARING_TARGET_AVX2, union, |, _mm256_or_si256, vorrq_u64, CROARING_UNTARGET_REGION)
-CROARING_UNTARGET_REGION
+AVX_BITSET_CONTAINER_FN1(CROARING_TARGET_AVX2, union, |, _mm256_or_si256, vorrq_u64, CROARING_UNTARGET_AVX2)
+CROARING_UNTARGET_AVX2
 
 // we duplicate the function because other containers use the "intersection" term, makes API more consistent
 CROARING_TARGET_AVX2
-AVX_BITSET_CONTAINER_FN1(CROARING_TARGET_AVX2, and,          &, _mm256_and_si256, vandq_u64, CROARING_UNTARGET_REGION)
-CROARING_UNTARGET_REGION
+AVX_BITSET_CONTAINER_FN1(CROARING_TARGET_AVX2, and,          &, _mm256_and_si256, vandq_u64, CROARING_UNTARGET_AVX2)
+CROARING_UNTARGET_AVX2
 CROARING_TARGET_AVX2
-AVX_BITSET_CONTAINER_FN1(CROARING_TARGET_AVX2, intersection, &, _mm256_and_si256, vandq_u64, CROARING_UNTARGET_REGION)
-CROARING_UNTARGET_REGION
+AVX_BITSET_CONTAINER_FN1(CROARING_TARGET_AVX2, intersection, &, _mm256_and_si256, vandq_u64, CROARING_UNTARGET_AVX2)
+CROARING_UNTARGET_AVX2
 
 CROARING_TARGET_AVX2
-AVX_BITSET_CONTAINER_FN1(CROARING_TARGET_AVX2, xor,    ^,  _mm256_xor_si256,    veorq_u64, CROARING_UNTARGET_REGION)
-CROARING_UNTARGET_REGION
+AVX_BITSET_CONTAINER_FN1(CROARING_TARGET_AVX2, xor,    ^,  _mm256_xor_si256,    veorq_u64, CROARING_UNTARGET_AVX2)
+CROARING_UNTARGET_AVX2
 CROARING_TARGET_AVX2
-AVX_BITSET_CONTAINER_FN1(CROARING_TARGET_AVX2, andnot, &~, _mm256_andnot_si256, vbicq_u64, CROARING_UNTARGET_REGION)
-CROARING_UNTARGET_REGION
+AVX_BITSET_CONTAINER_FN1(CROARING_TARGET_AVX2, andnot, &~, _mm256_andnot_si256, vbicq_u64, CROARING_UNTARGET_AVX2)
+CROARING_UNTARGET_AVX2
 
 // we duplicate the function because other containers use the "or" term, makes API more consistent
 CROARING_TARGET_AVX2
-AVX_BITSET_CONTAINER_FN2(CROARING_TARGET_AVX2, or,    |, _mm256_or_si256, vorrq_u64, CROARING_UNTARGET_REGION)
-CROARING_UNTARGET_REGION
+AVX_BITSET_CONTAINER_FN2(CROARING_TARGET_AVX2, or,    |, _mm256_or_si256, vorrq_u64, CROARING_UNTARGET_AVX2)
+CROARING_UNTARGET_AVX2
 CROARING_TARGET_AVX2
-AVX_BITSET_CONTAINER_FN2(CROARING_TARGET_AVX2, union, |, _mm256_or_si256, vorrq_u64, CROARING_UNTARGET_REGION)
-CROARING_UNTARGET_REGION
+AVX_BITSET_CONTAINER_FN2(CROARING_TARGET_AVX2, union, |, _mm256_or_si256, vorrq_u64, CROARING_UNTARGET_AVX2)
+CROARING_UNTARGET_AVX2
 
 // we duplicate the function because other containers use the "intersection" term, makes API more consistent
 CROARING_TARGET_AVX2
-AVX_BITSET_CONTAINER_FN2(CROARING_TARGET_AVX2, and,          &, _mm256_and_si256, vandq_u64, CROARING_UNTARGET_REGION)
-CROARING_UNTARGET_REGION
+AVX_BITSET_CONTAINER_FN2(CROARING_TARGET_AVX2, and,          &, _mm256_and_si256, vandq_u64, CROARING_UNTARGET_AVX2)
+CROARING_UNTARGET_AVX2
 CROARING_TARGET_AVX2
-AVX_BITSET_CONTAINER_FN2(CROARING_TARGET_AVX2, intersection, &, _mm256_and_si256, vandq_u64, CROARING_UNTARGET_REGION)
-CROARING_UNTARGET_REGION
+AVX_BITSET_CONTAINER_FN2(CROARING_TARGET_AVX2, intersection, &, _mm256_and_si256, vandq_u64, CROARING_UNTARGET_AVX2)
+CROARING_UNTARGET_AVX2
 
 CROARING_TARGET_AVX2
-AVX_BITSET_CONTAINER_FN2(CROARING_TARGET_AVX2, xor,    ^,  _mm256_xor_si256,    veorq_u64, CROARING_UNTARGET_REGION)
-CROARING_UNTARGET_REGION
+AVX_BITSET_CONTAINER_FN2(CROARING_TARGET_AVX2, xor,    ^,  _mm256_xor_si256,    veorq_u64, CROARING_UNTARGET_AVX2)
+CROARING_UNTARGET_AVX2
 CROARING_TARGET_AVX2
-AVX_BITSET_CONTAINER_FN2(CROARING_TARGET_AVX2, andnot, &~, _mm256_andnot_si256, vbicq_u64, CROARING_UNTARGET_REGION)
-CROARING_UNTARGET_REGION
+AVX_BITSET_CONTAINER_FN2(CROARING_TARGET_AVX2, andnot, &~, _mm256_andnot_si256, vbicq_u64, CROARING_UNTARGET_AVX2)
+CROARING_UNTARGET_AVX2
 
 // we duplicate the function because other containers use the "or" term, makes API more consistent
 CROARING_TARGET_AVX2
-AVX_BITSET_CONTAINER_FN3(CROARING_TARGET_AVX2, or,    |, _mm256_or_si256, vorrq_u64, CROARING_UNTARGET_REGION)
-CROARING_UNTARGET_REGION
+AVX_BITSET_CONTAINER_FN3(CROARING_TARGET_AVX2, or,    |, _mm256_or_si256, vorrq_u64, CROARING_UNTARGET_AVX2)
+CROARING_UNTARGET_AVX2
 CROARING_TARGET_AVX2
-AVX_BITSET_CONTAINER_FN3(CROARING_TARGET_AVX2, union, |, _mm256_or_si256, vorrq_u64, CROARING_UNTARGET_REGION)
-CROARING_UNTARGET_REGION
+AVX_BITSET_CONTAINER_FN3(CROARING_TARGET_AVX2, union, |, _mm256_or_si256, vorrq_u64, CROARING_UNTARGET_AVX2)
+CROARING_UNTARGET_AVX2
 
 // we duplicate the function because other containers use the "intersection" term, makes API more consistent
 CROARING_TARGET_AVX2
-AVX_BITSET_CONTAINER_FN3(CROARING_TARGET_AVX2, and,          &, _mm256_and_si256, vandq_u64, CROARING_UNTARGET_REGION)
-CROARING_UNTARGET_REGION
+AVX_BITSET_CONTAINER_FN3(CROARING_TARGET_AVX2, and,          &, _mm256_and_si256, vandq_u64, CROARING_UNTARGET_AVX2)
+CROARING_UNTARGET_AVX2
 CROARING_TARGET_AVX2
-AVX_BITSET_CONTAINER_FN3(CROARING_TARGET_AVX2, intersection, &, _mm256_and_si256, vandq_u64, CROARING_UNTARGET_REGION)
-CROARING_UNTARGET_REGION
+AVX_BITSET_CONTAINER_FN3(CROARING_TARGET_AVX2, intersection, &, _mm256_and_si256, vandq_u64, CROARING_UNTARGET_AVX2)
+CROARING_UNTARGET_AVX2
 
 CROARING_TARGET_AVX2
-AVX_BITSET_CONTAINER_FN3(CROARING_TARGET_AVX2, xor,    ^,  _mm256_xor_si256,    veorq_u64, CROARING_UNTARGET_REGION)
-CROARING_UNTARGET_REGION
+AVX_BITSET_CONTAINER_FN3(CROARING_TARGET_AVX2, xor,    ^,  _mm256_xor_si256,    veorq_u64, CROARING_UNTARGET_AVX2)
+CROARING_UNTARGET_AVX2
 CROARING_TARGET_AVX2
-AVX_BITSET_CONTAINER_FN3(CROARING_TARGET_AVX2, andnot, &~, _mm256_andnot_si256, vbicq_u64, CROARING_UNTARGET_REGION)
-CROARING_UNTARGET_REGION
+AVX_BITSET_CONTAINER_FN3(CROARING_TARGET_AVX2, andnot, &~, _mm256_andnot_si256, vbicq_u64, CROARING_UNTARGET_AVX2)
+CROARING_UNTARGET_AVX2
+
+#if CROARING_COMPILER_SUPPORTS_AVX512
+/* Same as the AVX2 kernels above, over 512-bit registers. The cardinality
+   comes from the native VPOPCNTQ instruction, accumulated alongside. */
+#define AVX512_BITSET_CONTAINER_FN(opname, avx512_intrinsic)                   \
+  static inline int _avx512_bitset_container_##opname(                         \
+      const bitset_container_t *src_1, const bitset_container_t *src_2,        \
+      bitset_container_t *dst) {                                               \
+    const __m512i *__restrict__ words_1 = (const __m512i *)src_1->words;       \
+    const __m512i *__restrict__ words_2 = (const __m512i *)src_2->words;       \
+    __m512i *out = (__m512i *)dst->words;                                      \
+    __m512i total1 = _mm512_setzero_si512();                                   \
+    __m512i total2 = _mm512_setzero_si512();                                   \
+    for (size_t i = 0;                                                         \
+         i < BITSET_CONTAINER_SIZE_IN_WORDS / (WORDS_IN_AVX512_REG);           \
+         i += 2) {                                                             \
+      __m512i A1 = avx512_intrinsic(_mm512_loadu_si512(words_2 + i),           \
+                                    _mm512_loadu_si512(words_1 + i));          \
+      __m512i A2 = avx512_intrinsic(_mm512_loadu_si512(words_2 + i + 1),       \
+                                    _mm512_loadu_si512(words_1 + i + 1));      \
+      _mm512_storeu_si512(out + i, A1);                                        \
+      _mm512_storeu_si512(out + i + 1, A2);                                    \
+      total1 = _mm512_add_epi64(total1, _mm512_popcnt_epi64(A1));              \
+      total2 = _mm512_add_epi64(total2, _mm512_popcnt_epi64(A2));              \
+    }                                                                          \
+    dst->cardinality =                                                         \
+        (int32_t)_mm512_reduce_add_epi64(_mm512_add_epi64(total1, total2));    \
+    return dst->cardinality;                                                   \
+  }                                                                            \
+  static inline int _avx512_bitset_container_##opname##_nocard(                \
+      const bitset_container_t *src_1, const bitset_container_t *src_2,        \
+      bitset_container_t *dst) {                                               \
+    const __m512i *__restrict__ words_1 = (const __m512i *)src_1->words;       \
+    const __m512i *__restrict__ words_2 = (const __m512i *)src_2->words;       \
+    __m512i *out = (__m512i *)dst->words;                                      \
+    for (size_t i = 0;                                                         \
+         i < BITSET_CONTAINER_SIZE_IN_WORDS / (WORDS_IN_AVX512_REG); i++) {    \
+      _mm512_storeu_si512(                                                     \
+          out + i, avx512_intrinsic(_mm512_loadu_si512(words_2 + i),           \
+                                    _mm512_loadu_si512(words_1 + i)));         \
+    }                                                                          \
+    dst->cardinality = BITSET_UNKNOWN_CARDINALITY;                             \
+    return dst->cardinality;                                                   \
+  }                                                                            \
+  static inline int _avx512_bitset_container_##opname##_justcard(              \
+      const bitset_container_t *src_1, const bitset_container_t *src_2) {      \
+    const __m512i *__restrict__ words_1 = (const __m512i *)src_1->words;       \
+    const __m512i *__restrict__ words_2 = (const __m512i *)src_2->words;       \
+    __m512i total1 = _mm512_setzero_si512();                                   \
+    __m512i total2 = _mm512_setzero_si512();                                   \
+    for (size_t i = 0;                                                         \
+         i < BITSET_CONTAINER_SIZE_IN_WORDS / (WORDS_IN_AVX512_REG);           \
+         i += 2) {                                                             \
+      __m512i A1 = avx512_intrinsic(_mm512_loadu_si512(words_2 + i),           \
+                                    _mm512_loadu_si512(words_1 + i));          \
+      __m512i A2 = avx512_intrinsic(_mm512_loadu_si512(words_2 + i + 1),       \
+                                    _mm512_loadu_si512(words_1 + i + 1));      \
+      total1 = _mm512_add_epi64(total1, _mm512_popcnt_epi64(A1));              \
+      total2 = _mm512_add_epi64(total2, _mm512_popcnt_epi64(A2));              \
+    }                                                                          \
+    return (int)_mm512_reduce_add_epi64(_mm512_add_epi64(total1, total2));     \
+  }
+
+// we duplicate the function because other containers use the "or" term, makes API more consistent
+CROARING_AVX512_IGNORE_UNINITIALIZED
+CROARING_TARGET_AVX512
+AVX512_BITSET_CONTAINER_FN(or,    _mm512_or_si512)
+AVX512_BITSET_CONTAINER_FN(union, _mm512_or_si512)
+
+// we duplicate the function because other containers use the "intersection" term, makes API more consistent
+AVX512_BITSET_CONTAINER_FN(and,          _mm512_and_si512)
+AVX512_BITSET_CONTAINER_FN(intersection, _mm512_and_si512)
 
+AVX512_BITSET_CONTAINER_FN(xor,    _mm512_xor_si512)
+AVX512_BITSET_CONTAINER_FN(andnot, _mm512_andnot_si512)
+CROARING_UNTARGET_AVX512
+CROARING_AVX512_RESTORE_UNINITIALIZED
+#endif // CROARING_COMPILER_SUPPORTS_AVX512
 
 #define SCALAR_BITSET_CONTAINER_FN(opname, opsymbol, avx_intrinsic,            \
                                    neon_intrinsic)                             \
@@ -440,6 +546,43 @@ SCALAR_BITSET_CONTAINER_FN(xor,    ^,  _mm256_xor_si256,    veorq_u64)
 SCALAR_BITSET_CONTAINER_FN(andnot, &~, _mm256_andnot_si256, vbicq_u64)
 
 
+#if CROARING_COMPILER_SUPPORTS_AVX512
+#define BITSET_CONTAINER_FN(opname, opsymbol, avx_intrinsic, neon_intrinsic)   \
+  int bitset_container_##opname(const bitset_container_t *src_1,               \
+                                const bitset_container_t *src_2,               \
+                                bitset_container_t *dst) {                     \
+    if ( croaring_avx512() ) {                                                 \
+      return _avx512_bitset_container_##opname(src_1, src_2, dst);             \
+    } else if ( croaring_avx2() ) {                                            \
+      return _avx2_bitset_container_##opname(src_1, src_2, dst);               \
+    } else {                                                                   \
+      return _scalar_bitset_container_##opname(src_1, src_2, dst);             \
+    }                                                                          \
+  }                                                                            \
+  int bitset_container_##opname##_nocard(const bitset_container_t *src_1,      \
+                                         const bitset_container_t *src_2,      \
+                                         bitset_container_t *dst) {            \
+    if ( croaring_avx512() ) {                                                 \
+      return _avx512_bitset_container_##opname##_nocard(src_1, src_2, dst);    \
+    } else if ( croaring_avx2() ) {                                            \
+      return _avx2_bitset_container_##opname##_nocard(src_1, src_2, dst);      \
+    } else {                                                                   \
+      return _scalar_bitset_container_##opname##_nocard(src_1, src_2, dst);    \
+    }                                                                          \
+  }                                                                            \
+  int bitset_container_##opname##_justcard(const bitset_container_t *src_1,    \
+                                           const bitset_container_t *src_2) {  \
+    if ( croaring_avx512() ) {                                                 \
+      return _avx512_bitset_container_##opname##_justcard(src_1, src_2);       \
+    } else if ( croaring_avx2() ) {                                            \
+      return _avx2_bitset_container_##opname##_justcard(src_1, src_2);         \
+    } else {                                                                   \
+      return _scalar_bitset_container_##opname##_justcard(src_1, src_2);       \
+    }                                                                          \
+  }
+
+#else // CROARING_COMPILER_SUPPORTS_AVX512
+
 #define BITSET_CONTAINER_FN(opname, opsymbol, avx_intrinsic, neon_intrinsic)   \
   int bitset_container_##opname(const bitset_container_t *src_1,               \
                                 const bitset_container_t *src_2,               \
@@ -469,7 +612,7 @@ SCALAR_BITSET_CONTAINER_FN(andnot, &~, _mm256_andnot_si256, vbicq_u64)
     }                                                                          \
   }
 
-
+#endif // CROARING_COMPILER_SUPPORTS_AVX512
 
 #elif defined(USENEON)
 
@@ -627,6 +770,11 @@ int bitset_container_to_uint32_array(
     uint32_t base
 ){
 #ifdef CROARING_IS_X64
+#if CROARING_COMPILER_SUPPORTS_AVX512
+    if( croaring_avx512() && (bc->cardinality >= 8192) )  // heuristic
+		return (int) bitset_extract_setbits_avx512(bc->words,
+                BITSET_CONTAINER_SIZE_IN_WORDS, out, bc->cardinality, base);
+#endif
     if(( croaring_avx2() ) &&  (bc->cardinality >= 8192))  // heuristic
 		return (int) bitset_extract_setbits_avx2(bc->words,
                 BITSET_CONTAINER_SIZE_IN_WORDS, out, bc->cardinality, base);
@@ -764,7 +912,7 @@ static inline bool _avx2_bitset_container_equals(const bitset_container_t *conta
   }
 	return true;
 }
-CROARING_UNTARGET_REGION
+CROARING_UNTARGET_AVX2
 #endif // CROARING_IS_X64
 
 bool bitset_container_equals(const bitset_container_t *container1, const bitset_container_t *container2) {
@@ -874,6 +1022,56 @@ int bitset_container_rank(const bitset_container_t *container, uint16_t x) {
   return sum;
 }
 
+uint32_t bitset_container_rank_many(const bitset_container_t *container,
+                                    uint64_t start_rank,
+                                    const uint32_t *begin,
+                                    const uint32_t *end, uint64_t *ans) {
+  const uint16_t high = (uint16_t)((*begin) >> 16);
+  // the values are sorted, so the words are counted only once
+  int i = 0;
+  uint64_t sum = start_rank;
+  const uint32_t *iter = begin;
+  for (; iter != end; iter++) {
+    uint32_t x = *iter;
+    if ((uint16_t)(x >> 16) != high) break;
+    uint16_t xlow = (uint16_t)x;
+    for (int end_word = xlow / 64; i < end_word; i++) {
+      sum += hamming(container->words[i]);
+    }
+    uint64_t lastpos = UINT64_C(1) << (xlow % 64);
+    uint64_t mask = lastpos + lastpos - 1; // smear right
+    *(ans++) = sum + hamming(container->words[i] & mask);
+  }
+  return (uint32_t)(iter - begin);
+}
+
+uint32_t bitset_container_select_many(const bitset_container_t *container,
+                                      uint32_t start_rank,
+                                      const uint32_t *begin,
+                                      const uint32_t *end, uint32_t *element) {
+  // rank of the first value of word i, carried over from one rank to the next
+  int i = 0;
+  uint64_t word_rank = start_rank;
+  int size = hamming(container->words[0]);
+  const uint32_t *iter = begin;
+  for (; iter != end; iter++) {
+    uint32_t rank = *iter;
+    while (rank >= word_rank + size) {
+      word_rank += size;
+      if (++i == BITSET_CONTAINER_SIZE_IN_WORDS) {
+        return (uint32_t)(iter - begin);
+      }
+      size = hamming(container->words[i]);
+    }
+    uint64_t w = container->words[i];
+    for (uint32_t skip = (uint32_t)(rank - word_rank); skip > 0; skip--) {
+      w &= w - 1;  // clears the lowest set bit
+    }
+    *(element++) = i * 64 + __builtin_ctzll(w);
+  }
+  return (uint32_t)(iter - begin);
+}
+
 /* Returns the index of the first value equal or larger than x, or -1 */
 int bitset_container_index_equalorlarger(const bitset_container_t *container, uint16_t x) {
   uint32_t x32 = x;
@@ -889,6 +1087,62 @@ int bitset_container_index_equalorlarger(const bitset_container_t *container, ui
   return k * 64 + __builtin_ctzll(word);
 }
 
+bool bitset_container_offset(const bitset_container_t *c,
+                             bitset_container_t **lo, bitset_container_t **hi,
+                             uint16_t offset) {
+    // output word j takes the bits of words j - b and j - b - 1 of c, where
+    // the words of hi are numbered from BITSET_CONTAINER_SIZE_IN_WORDS
+    const int b = offset / 64;
+    const int i = offset % 64;
+    const uint64_t *words = c->words;
+    bitset_container_t *lo_part = NULL, *hi_part = NULL;
+    if (lo != NULL) {
+        lo_part = bitset_container_create();
+        if (lo_part == NULL) return false;
+        uint64_t *out = lo_part->words;  // zeroed by bitset_container_create
+        if (i == 0) {
+            memcpy(out + b, words,
+                   (BITSET_CONTAINER_SIZE_IN_WORDS - b) * sizeof(uint64_t));
+        } else {
+            out[b] = words[0] << i;
+            for (int k = 1; k < BITSET_CONTAINER_SIZE_IN_WORDS - b; k++) {
+                out[b + k] = (words[k] << i) | (words[k - 1] >> (64 - i));
+            }
+        }
+        lo_part->cardinality = bitset_container_compute_cardinality(lo_part);
+        if (lo_part->cardinality == 0) {
+            bitset_container_free(lo_part);
+            lo_part = NULL;
+        }
+    }
+    if (hi != NULL) {
+        hi_part = bitset_container_create();
+        if (hi_part == NULL) {
+            if (lo_part != NULL) bitset_container_free(lo_part);
+            return false;
+        }
+        uint64_t *out = hi_part->words;
+        const int start = BITSET_CONTAINER_SIZE_IN_WORDS - b;
+        if (i == 0) {
+            memcpy(out, words + start, b * sizeof(uint64_t));
+        } else {
+            for (int k = 0; k < b; k++) {
+                out[k] = (words[start + k] << i) |
+                         (words[start + k - 1] >> (64 - i));
+            }
+            out[b] = words[BITSET_CONTAINER_SIZE_IN_WORDS - 1] >> (64 - i);
+        }
+        hi_part->cardinality = bitset_container_compute_cardinality(hi_part);
+        if (hi_part->cardinality == 0) {
+            bitset_container_free(hi_part);
+            hi_part = NULL;
+        }
+    }
+    if (lo != NULL) *lo = lo_part;
+    if (hi != NULL) *hi = hi_part;
+    return true;
+}
+
 #ifdef __cplusplus
 } } }  // extern "C" { namespace roaring { namespace internal {
 #endif
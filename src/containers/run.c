@@ -77,13 +77,13 @@ bool run_container_add(run_container_t *run, uint16_t pos) {
 run_container_t *run_container_create_given_capacity(int32_t size) {
     run_container_t *run;
     /* Allocate the run container itself. */
-    if ((run = (run_container_t *)malloc(sizeof(run_container_t))) == NULL) {
+    if ((run = (run_container_t *)roaring_malloc(sizeof(run_container_t))) == NULL) {
         return NULL;
     }
     if (size <= 0 ) { // we don't want to rely on malloc(0)
         run->runs = NULL;
-    } else if ((run->runs = (rle16_t *)malloc(sizeof(rle16_t) * size)) == NULL) {
-        free(run);
+    } else if ((run->runs = (rle16_t *)roaring_malloc(sizeof(rle16_t) * size)) == NULL) {
+        roaring_free(run);
         return NULL;
     }
     run->capacity = size;
@@ -96,8 +96,8 @@ int run_container_shrink_to_fit(run_container_t *src) {
     int savings = src->capacity - src->n_runs;
     src->capacity = src->n_runs;
     rle16_t *oldruns = src->runs;
-    src->runs = (rle16_t *)realloc(oldruns, src->capacity * sizeof(rle16_t));
-    if (src->runs == NULL) free(oldruns);  // should never happen?
+    src->runs = (rle16_t *)roaring_realloc(oldruns, src->capacity * sizeof(rle16_t));
+    if (src->runs == NULL) roaring_free(oldruns);  // should never happen?
     return savings;
 }
 /* Create a new run container. Return NULL in case of failure. */
@@ -117,10 +117,10 @@ run_container_t *run_container_clone(const run_container_t *src) {
 /* Free memory. */
 void run_container_free(run_container_t *run) {
     if(run->runs != NULL) {// Jon Strabala reports that some tools complain otherwise
-      free(run->runs);
+      roaring_free(run->runs);
       run->runs = NULL;  // pedantic
     }
-    free(run);
+    roaring_free(run);
 }
 
 void run_container_grow(run_container_t *run, int32_t min, bool copy) {
@@ -136,14 +136,14 @@ void run_container_grow(run_container_t *run, int32_t min, bool copy) {
     if (copy) {
         rle16_t *oldruns = run->runs;
         run->runs =
-            (rle16_t *)realloc(oldruns, run->capacity * sizeof(rle16_t));
-        if (run->runs == NULL) free(oldruns);
+            (rle16_t *)roaring_realloc(oldruns, run->capacity * sizeof(rle16_t));
+        if (run->runs == NULL) roaring_free(oldruns);
     } else {
         // Jon Strabala reports that some tools complain otherwise
         if (run->runs != NULL) {
-          free(run->runs);
+          roaring_free(run->runs);
         }
-        run->runs = (rle16_t *)malloc(run->capacity * sizeof(rle16_t));
+        run->runs = (rle16_t *)roaring_malloc(run->capacity * sizeof(rle16_t));
     }
     // handle the case where realloc fails
     if (run->runs == NULL) {
@@ -770,6 +770,73 @@ int run_container_rank(const run_container_t *container, uint16_t x) {
     return sum;
 }
 
+uint32_t run_container_rank_many(const run_container_t *container,
+                                 uint64_t start_rank, const uint32_t *begin,
+                                 const uint32_t *end, uint64_t *ans) {
+    const uint16_t high = (uint16_t)((*begin) >> 16);
+    // the values are sorted, so each run is passed only once
+    int i = 0;
+    uint64_t sum = start_rank;
+    const uint32_t *iter = begin;
+    for (; iter != end; iter++) {
+        uint32_t x = *iter;
+        if ((uint16_t)(x >> 16) != high) break;
+        uint32_t x32 = x & 0xFFFF;
+        while (i < container->n_runs &&
+               (uint32_t)container->runs[i].value +
+                       container->runs[i].length < x32) {
+            sum += container->runs[i].length + 1;
+            i++;
+        }
+        if (i < container->n_runs && x32 >= container->runs[i].value) {
+            *(ans++) = sum + (x32 - container->runs[i].value) + 1;
+        } else {
+            *(ans++) = sum;
+        }
+    }
+    return (uint32_t)(iter - begin);
+}
+
+uint32_t run_container_select_many(const run_container_t *container,
+                                   uint32_t start_rank, const uint32_t *begin,
+                                   const uint32_t *end, uint32_t *element) {
+    // rank of the first value of run i, carried over from one rank to the next
+    int i = 0;
+    uint32_t run_rank = start_rank;
+    const uint32_t *iter = begin;
+    for (; iter != end; iter++) {
+        uint32_t rank = *iter;
+        while (i < container->n_runs &&
+               rank > run_rank + container->runs[i].length) {
+            run_rank += container->runs[i].length + 1;
+            i++;
+        }
+        if (i == container->n_runs) break;
+        *(element++) = container->runs[i].value + (rank - run_rank);
+    }
+    return (uint32_t)(iter - begin);
+}
+
+void run_container_contains_many(const run_container_t *run,
+                                 const uint32_t *vals, size_t n,
+                                 bool *results) {
+    int32_t i = 0;
+    uint16_t prev = 0;
+    for (size_t k = 0; k < n; k++) {
+        uint16_t low = (uint16_t)vals[k];
+        if (low < prev) {  // out of order, search from scratch
+            i = run_container_index_equalorlarger(run, low);
+            if (i < 0) i = run->n_runs;
+        }
+        prev = low;
+        while (i < run->n_runs &&
+               (uint32_t)run->runs[i].value + run->runs[i].length < low) {
+            i++;
+        }
+        results[k] = i < run->n_runs && run->runs[i].value <= low;
+    }
+}
+
 #ifdef CROARING_IS_X64
 
 CROARING_TARGET_AVX2
@@ -802,7 +869,7 @@ static inline int _avx2_run_container_cardinality(const run_container_t *run) {
     return sum;
 }
 
-CROARING_UNTARGET_REGION
+CROARING_UNTARGET_AVX2
 
 /* Get the cardinality of `run'. Requires an actual computation. */
 static inline int _scalar_run_container_cardinality(const run_container_t *run) {
@@ -818,12 +885,23 @@ static inline int _scalar_run_container_cardinality(const run_container_t *run)
     return sum;
 }
 
-int run_container_cardinality(const run_container_t *run) {
+typedef int (*run_cardinality_fn)(const run_container_t *run);
+static int _resolve_run_container_cardinality(const run_container_t *run);
+CROARING_DISPATCH_POINTER(run_cardinality_fn, run_cardinality_kernel,
+                          _resolve_run_container_cardinality);
+
+static int _resolve_run_container_cardinality(const run_container_t *run) {
+  run_cardinality_fn kernel = _scalar_run_container_cardinality;
   if( croaring_avx2() ) {
-    return _avx2_run_container_cardinality(run);
-  } else {
-    return _scalar_run_container_cardinality(run);
+    kernel = _avx2_run_container_cardinality;
   }
+  run_cardinality_kernel = kernel;
+  return kernel(run);
+}
+
+int run_container_cardinality(const run_container_t *run) {
+  run_cardinality_fn kernel = run_cardinality_kernel;
+  return kernel(run);
 }
 #else
 
@@ -843,6 +921,55 @@ int run_container_cardinality(const run_container_t *run) {
 #endif
 
 
+bool run_container_offset(const run_container_t *c,
+                          run_container_t **lo, run_container_t **hi,
+                          uint16_t offset) {
+    // runs from split onwards end past 1 << 16, the one at split may start
+    // below
+    int32_t split = 0;
+    while (split < c->n_runs && (uint32_t)c->runs[split].value +
+                                        c->runs[split].length + offset <
+                                    (1 << 16)) {
+        split++;
+    }
+    bool straddles = split < c->n_runs &&
+                     (uint32_t)c->runs[split].value + offset < (1 << 16);
+    run_container_t *lo_part = NULL, *hi_part = NULL;
+    if (lo != NULL && split + straddles > 0) {
+        lo_part = run_container_create_given_capacity(split + straddles);
+        if (lo_part == NULL) return false;
+        for (int32_t i = 0; i < split; i++) {
+            lo_part->runs[i].value = c->runs[i].value + offset;
+            lo_part->runs[i].length = c->runs[i].length;
+        }
+        if (straddles) {
+            uint16_t value = c->runs[split].value + offset;
+            lo_part->runs[split].value = value;
+            lo_part->runs[split].length = 0xFFFF - value;
+        }
+        lo_part->n_runs = split + straddles;
+    }
+    if (hi != NULL && c->n_runs > split) {
+        int32_t n_runs = c->n_runs - split;
+        hi_part = run_container_create_given_capacity(n_runs);
+        if (hi_part == NULL) {
+            if (lo_part != NULL) run_container_free(lo_part);
+            return false;
+        }
+        for (int32_t i = 0; i < n_runs; i++) {
+            uint32_t value = (uint32_t)c->runs[split + i].value + offset;
+            uint32_t last = value + c->runs[split + i].length;
+            if (value < (1 << 16)) value = 1 << 16;  // straddling run
+            hi_part->runs[i].value = (uint16_t)(value - (1 << 16));
+            hi_part->runs[i].length = (uint16_t)(last - value);
+        }
+        hi_part->n_runs = n_runs;
+    }
+    if (lo != NULL) *lo = lo_part;
+    if (hi != NULL) *hi = hi_part;
+    return true;
+}
+
 #ifdef __cplusplus
 } } }  // extern "C" { namespace roaring { namespace internal {
 #endif
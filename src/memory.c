@@ -0,0 +1,262 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <roaring/memory.h>
+#include <roaring/portability.h>
+
+// the standard C functions, in the order of roaring_memory_t
+#define ROARING_DEFAULT_MEMORY_HOOK                                     \
+    { malloc, realloc, calloc, free, roaring_bitmap_aligned_malloc,     \
+      roaring_bitmap_aligned_free }
+
+static roaring_memory_t global_memory_hook = ROARING_DEFAULT_MEMORY_HOOK;
+
+#if defined(__cplusplus)
+#define ROARING_THREAD_LOCAL thread_local
+#elif defined(_MSC_VER)
+#define ROARING_THREAD_LOCAL __declspec(thread)
+#else
+#define ROARING_THREAD_LOCAL _Thread_local
+#endif
+
+// the arena of the calling thread, if any
+static ROARING_THREAD_LOCAL roaring_arena_t *current_arena = NULL;
+
+void roaring_init_memory_hook(roaring_memory_t memory_hook) {
+    global_memory_hook = memory_hook;
+}
+
+void roaring_reset_memory_hook(void) {
+    const roaring_memory_t default_hook = ROARING_DEFAULT_MEMORY_HOOK;
+    global_memory_hook = default_hook;
+}
+
+/*
+ * Every block of an arena is preceded by its size, so that it can be
+ * reallocated, and is aligned on at least ARENA_MIN_ALIGNMENT bytes like
+ * what malloc returns.
+ */
+#define ARENA_MIN_ALIGNMENT 16
+#define ARENA_MAX_CHUNK_SIZE ((size_t)1 << 26)
+
+typedef struct roaring_arena_chunk_s {
+    struct roaring_arena_chunk_s *next;  // older chunk
+    size_t capacity;
+    size_t used;
+} roaring_arena_chunk_t;
+
+struct roaring_arena_s {
+    roaring_arena_chunk_t *head;  // the chunk we allocate from
+    size_t chunk_size;            // capacity of the next chunk
+    char *last;                   // most recent block, if still the last one
+    size_t used_before_last;      // head->used before it was allocated
+};
+
+static inline char *arena_chunk_data(roaring_arena_chunk_t *chunk) {
+    return (char *)(chunk + 1);
+}
+
+static inline size_t arena_block_size(const char *block) {
+    size_t size;
+    memcpy(&size, block - sizeof(size_t), sizeof(size_t));
+    return size;
+}
+
+static inline void arena_set_block_size(char *block, size_t size) {
+    memcpy(block - sizeof(size_t), &size, sizeof(size_t));
+}
+
+/* Returns the start of a block of "size" bytes fitting in the chunk, or
+ * NULL. */
+static inline char *arena_chunk_fit(roaring_arena_chunk_t *chunk,
+                                    size_t alignment, size_t size) {
+    uintptr_t data = (uintptr_t)arena_chunk_data(chunk);
+    uintptr_t start = data + chunk->used + sizeof(size_t);
+    start = (start + alignment - 1) & ~(uintptr_t)(alignment - 1);
+    if (start - data > chunk->capacity ||
+        size > chunk->capacity - (start - data)) {
+        return NULL;
+    }
+    return (char *)start;
+}
+
+static void *arena_allocate(roaring_arena_t *arena, size_t alignment,
+                            size_t size) {
+    if (alignment < ARENA_MIN_ALIGNMENT) alignment = ARENA_MIN_ALIGNMENT;
+    char *block = NULL;
+    if (arena->head != NULL) {
+        block = arena_chunk_fit(arena->head, alignment, size);
+    }
+    if (block == NULL) {
+        const size_t overhead = sizeof(size_t) + alignment;
+        if (size > SIZE_MAX - overhead - sizeof(roaring_arena_chunk_t)) {
+            return NULL;
+        }
+        size_t capacity = arena->chunk_size;
+        if (capacity < size + overhead) capacity = size + overhead;
+        roaring_arena_chunk_t *chunk = (roaring_arena_chunk_t *)
+            global_memory_hook.malloc(sizeof(roaring_arena_chunk_t) + capacity);
+        if (chunk == NULL) return NULL;
+        chunk->next = arena->head;
+        chunk->capacity = capacity;
+        chunk->used = 0;
+        arena->head = chunk;
+        if (arena->chunk_size < ARENA_MAX_CHUNK_SIZE) arena->chunk_size *= 2;
+        block = arena_chunk_fit(chunk, alignment, size);
+    }
+    arena->used_before_last = arena->head->used;
+    arena->head->used = (size_t)(block - arena_chunk_data(arena->head)) + size;
+    arena->last = block;
+    arena_set_block_size(block, size);
+    return block;
+}
+
+static bool arena_owns(const roaring_arena_t *arena, const void *p) {
+    for (roaring_arena_chunk_t *chunk = arena->head; chunk != NULL;
+         chunk = chunk->next) {
+        const char *data = arena_chunk_data(chunk);
+        if ((const char *)p > data && (const char *)p <= data + chunk->capacity) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void arena_release(roaring_arena_t *arena, void *p) {
+    if (p == arena->last) {  // we can give the space back
+        arena->head->used = arena->used_before_last;
+        arena->last = NULL;
+    }
+}
+
+static void *arena_reallocate(roaring_arena_t *arena, void *p, size_t size) {
+    char *block = (char *)p;
+    if (block == arena->last &&
+        size <= arena->head->capacity -
+                    (size_t)(block - arena_chunk_data(arena->head))) {
+        // grow or shrink in place
+        arena->head->used =
+            (size_t)(block - arena_chunk_data(arena->head)) + size;
+        arena_set_block_size(block, size);
+        return block;
+    }
+    size_t old_size = arena_block_size(block);
+    void *answer = arena_allocate(arena, ARENA_MIN_ALIGNMENT, size);
+    if (answer == NULL) return NULL;
+    memcpy(answer, block, old_size < size ? old_size : size);
+    return answer;
+}
+
+roaring_arena_t *roaring_arena_create(size_t chunk_size) {
+    roaring_arena_t *arena =
+        (roaring_arena_t *)global_memory_hook.malloc(sizeof(roaring_arena_t));
+    if (arena == NULL) return NULL;
+    arena->head = NULL;
+    arena->chunk_size = chunk_size < 4096 ? 4096 : chunk_size;
+    arena->last = NULL;
+    arena->used_before_last = 0;
+    // allocate the first chunk right away, so that the size is honored
+    void *first = arena_allocate(arena, ARENA_MIN_ALIGNMENT, 0);
+    if (first == NULL) {
+        global_memory_hook.free(arena);
+        return NULL;
+    }
+    roaring_arena_reset(arena);
+    return arena;
+}
+
+void roaring_arena_reset(roaring_arena_t *arena) {
+    if (arena->head == NULL) return;
+    // keep the largest chunk: an oversized block may have made a chunk larger
+    // than the regular ones that came after it
+    roaring_arena_chunk_t *largest = arena->head;
+    for (roaring_arena_chunk_t *chunk = largest->next; chunk != NULL;
+         chunk = chunk->next) {
+        if (chunk->capacity > largest->capacity) largest = chunk;
+    }
+    roaring_arena_chunk_t *chunk = arena->head;
+    while (chunk != NULL) {
+        roaring_arena_chunk_t *next = chunk->next;
+        if (chunk != largest) global_memory_hook.free(chunk);
+        chunk = next;
+    }
+    largest->next = NULL;
+    largest->used = 0;
+    arena->head = largest;
+    arena->last = NULL;
+    arena->used_before_last = 0;
+}
+
+void roaring_arena_free(roaring_arena_t *arena) {
+    if (arena == NULL) return;
+    roaring_arena_chunk_t *chunk = arena->head;
+    while (chunk != NULL) {
+        roaring_arena_chunk_t *next = chunk->next;
+        global_memory_hook.free(chunk);
+        chunk = next;
+    }
+    if (current_arena == arena) current_arena = NULL;
+    global_memory_hook.free(arena);
+}
+
+roaring_arena_t *roaring_arena_set_current(roaring_arena_t *arena) {
+    roaring_arena_t *previous = current_arena;
+    current_arena = arena;
+    return previous;
+}
+
+void* roaring_malloc(size_t n) {
+    roaring_arena_t *arena = current_arena;
+    if (arena != NULL) return arena_allocate(arena, ARENA_MIN_ALIGNMENT, n);
+    return global_memory_hook.malloc(n);
+}
+
+void* roaring_realloc(void* p, size_t new_sz) {
+    roaring_arena_t *arena = current_arena;
+    if (arena != NULL) {
+        if (p == NULL) return arena_allocate(arena, ARENA_MIN_ALIGNMENT, new_sz);
+        if (arena_owns(arena, p)) return arena_reallocate(arena, p, new_sz);
+    }
+    return global_memory_hook.realloc(p, new_sz);
+}
+
+void* roaring_calloc(size_t n_elements, size_t element_size) {
+    roaring_arena_t *arena = current_arena;
+    if (arena != NULL) {
+        if (element_size != 0 && n_elements > SIZE_MAX / element_size) {
+            return NULL;
+        }
+        size_t size = n_elements * element_size;
+        void *answer = arena_allocate(arena, ARENA_MIN_ALIGNMENT, size);
+        if (answer != NULL) memset(answer, 0, size);
+        return answer;
+    }
+    return global_memory_hook.calloc(n_elements, element_size);
+}
+
+void roaring_free(void* p) {
+    roaring_arena_t *arena = current_arena;
+    if (p == NULL) return;
+    if (arena != NULL && arena_owns(arena, p)) {
+        arena_release(arena, p);
+        return;
+    }
+    global_memory_hook.free(p);
+}
+
+void* roaring_aligned_malloc(size_t alignment, size_t size) {
+    roaring_arena_t *arena = current_arena;
+    if (arena != NULL) return arena_allocate(arena, alignment, size);
+    return global_memory_hook.aligned_malloc(alignment, size);
+}
+
+void roaring_aligned_free(void* p) {
+    roaring_arena_t *arena = current_arena;
+    if (p == NULL) return;
+    if (arena != NULL && arena_owns(arena, p)) {
+        arena_release(arena, p);
+        return;
+    }
+    global_memory_hook.aligned_free(p);
+}
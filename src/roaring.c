@@ -70,13 +70,13 @@ static inline container_t *containerptr_roaring_bitmap_add(
 
 roaring_bitmap_t *roaring_bitmap_create_with_capacity(uint32_t cap) {
     roaring_bitmap_t *ans =
-        (roaring_bitmap_t *)malloc(sizeof(roaring_bitmap_t));
+        (roaring_bitmap_t *)roaring_malloc(sizeof(roaring_bitmap_t));
     if (!ans) {
         return NULL;
     }
     bool is_ok = ra_init_with_capacity(&ans->high_low_container, cap);
     if (!is_ok) {
-        free(ans);
+        roaring_free(ans);
         return NULL;
     }
     return ans;
@@ -89,42 +89,40 @@ bool roaring_bitmap_init_with_capacity(roaring_bitmap_t *r, uint32_t cap) {
 
 void roaring_bitmap_add_many(roaring_bitmap_t *r, size_t n_args,
                              const uint32_t *vals) {
-    container_t *container = NULL;  // hold value of last container touched
-    uint8_t typecode = 0;    // typecode of last container touched
-    uint32_t prev = 0;       // previous valued inserted
-    size_t i = 0;            // index of value
-    int containerindex = 0;
-    if (n_args == 0) return;
-    uint32_t val;
-    memcpy(&val, vals + i, sizeof(val));
-    container =
-        containerptr_roaring_bitmap_add(r, val, &typecode, &containerindex);
-    prev = val;
-    i++;
-    for (; i < n_args; i++) {
+    roaring_bulk_context_t context;
+    memset(&context, 0, sizeof(context));
+    for (size_t i = 0; i < n_args; i++) {
+        uint32_t val;
         memcpy(&val, vals + i, sizeof(val));
-        if (((prev ^ val) >> 16) ==
-            0) {  // no need to seek the container, it is at hand
-            // because we already have the container at hand, we can do the
-            // insertion
-            // automatically, bypassing the roaring_bitmap_add call
-            uint8_t newtypecode = typecode;
-            container_t *container2 =
-                container_add(container, val & 0xFFFF, typecode, &newtypecode);
-            if (container2 != container) {  // rare instance when we need to
-                                            // change the container type
-                container_free(container, typecode);
-                ra_set_container_at_index(&r->high_low_container,
-                                          containerindex, container2,
-                                          newtypecode);
-                typecode = newtypecode;
-                container = container2;
-            }
-        } else {
-            container = containerptr_roaring_bitmap_add(r, val, &typecode,
-                                                        &containerindex);
+        roaring_bitmap_add_bulk(r, &context, val);
+    }
+}
+
+void roaring_bitmap_add_bulk(roaring_bitmap_t *r,
+                             roaring_bulk_context_t *context, uint32_t val) {
+    const uint16_t key = val >> 16;
+    if (context->container == NULL || context->key != key ||
+        context->typecode == SHARED_CONTAINER_TYPE) {
+        uint8_t typecode;
+        int idx;
+        context->container =
+            containerptr_roaring_bitmap_add(r, val, &typecode, &idx);
+        context->typecode = typecode;
+        context->idx = idx;
+        context->key = key;
+    } else {
+        // no need to seek the container, it is at hand
+        uint8_t new_typecode = context->typecode;
+        container_t *container2 = container_add(
+            context->container, val & 0xFFFF, context->typecode, &new_typecode);
+        if (container2 != context->container) {
+            // rare instance when we need to change the container type
+            container_free(context->container, context->typecode);
+            ra_set_container_at_index(&r->high_low_container, context->idx,
+                                      container2, new_typecode);
+            context->typecode = new_typecode;
+            context->container = container2;
         }
-        prev = val;
     }
 }
 
@@ -134,6 +132,155 @@ roaring_bitmap_t *roaring_bitmap_of_ptr(size_t n_args, const uint32_t *vals) {
     return answer;
 }
 
+// the smallest container type for card values forming n_runs runs
+static uint8_t sorted_container_type(int32_t card, int32_t n_runs) {
+    int32_t size_as_run = run_container_serialized_size_in_bytes(n_runs);
+    if (card <= DEFAULT_MAX_SIZE) {
+        return size_as_run < array_container_serialized_size_in_bytes(card)
+                   ? RUN_CONTAINER_TYPE
+                   : ARRAY_CONTAINER_TYPE;
+    }
+    return size_as_run < bitset_container_serialized_size_in_bytes()
+               ? RUN_CONTAINER_TYPE
+               : BITSET_CONTAINER_TYPE;
+}
+
+// the low 16 bits of value i of an array of uint32_t (wide) or uint16_t
+static inline uint16_t sorted_low(const void *vals, bool wide, int32_t i) {
+    return wide ? (uint16_t)((const uint32_t *)vals)[i]
+                : ((const uint16_t *)vals)[i];
+}
+
+// builds the smallest container holding the low 16 bits of card sorted
+// values, given how many runs they form: the values are either 16-bit or
+// 32-bit (wide) sharing their high 16 bits, and are read in place
+static container_t *container_from_sorted(const void *vals, bool wide,
+                                          int32_t card, int32_t n_runs,
+                                          uint8_t *typecode) {
+    *typecode = sorted_container_type(card, n_runs);
+    if (*typecode == RUN_CONTAINER_TYPE) {
+        run_container_t *run = run_container_create_given_capacity(n_runs);
+        if (run == NULL) return NULL;
+        int32_t start = 0;
+        for (int32_t i = 1; i <= card; i++) {
+            if (i == card || sorted_low(vals, wide, i) !=
+                                 sorted_low(vals, wide, i - 1) + 1) {
+                rle16_t *rl = &run->runs[run->n_runs++];
+                rl->value = sorted_low(vals, wide, start);
+                rl->length = (uint16_t)(i - 1 - start);
+                start = i;
+            }
+        }
+        return run;
+    }
+    if (*typecode == ARRAY_CONTAINER_TYPE) {
+        array_container_t *array = array_container_create_given_capacity(card);
+        if (array == NULL) return NULL;
+        if (wide) {
+            for (int32_t i = 0; i < card; i++) {
+                array->array[i] = sorted_low(vals, true, i);
+            }
+        } else {
+            memcpy(array->array, vals, card * sizeof(uint16_t));
+        }
+        array->cardinality = card;
+        return array;
+    }
+    bitset_container_t *bitset = bitset_container_create();
+    if (bitset == NULL) return NULL;
+    if (wide) {
+        for (int32_t i = 0; i < card; i++) {
+            const uint16_t low = sorted_low(vals, true, i);
+            bitset->words[low >> 6] |= UINT64_C(1) << (low & 63);
+        }
+    } else {
+        bitset_set_list(bitset->words, (const uint16_t *)vals, card);
+    }
+    bitset->cardinality = card;
+    return bitset;
+}
+
+roaring_bitmap_t *roaring_bitmap_from_sorted(size_t n_args,
+                                             const uint32_t *vals) {
+    uint32_t n_keys = 0;
+    for (size_t i = 0; i < n_args; i++) {
+        if (i == 0 || (vals[i] >> 16) != (vals[i - 1] >> 16)) n_keys++;
+    }
+    roaring_bitmap_t *answer = roaring_bitmap_create_with_capacity(n_keys);
+    if (answer == NULL) return NULL;
+    size_t i = 0;
+    while (i < n_args) {
+        const uint16_t key = vals[i] >> 16;
+        size_t j = i + 1;
+        int32_t n_runs = 1;
+        for (; j < n_args && (vals[j] >> 16) == key; j++) {
+            assert(vals[j] > vals[j - 1]);
+            if (vals[j] != vals[j - 1] + 1) n_runs++;
+        }
+        uint8_t typecode;
+        container_t *c = container_from_sorted(vals + i, true, (int32_t)(j - i),
+                                               n_runs, &typecode);
+        if (c == NULL) {
+            roaring_bitmap_free(answer);
+            return NULL;
+        }
+        ra_append(&answer->high_low_container, key, c, typecode);
+        i = j;
+    }
+    return answer;
+}
+
+bool roaring_bulk_builder_init(roaring_bulk_builder_t *builder,
+                               roaring_bitmap_t *r) {
+    builder->r = r;
+    builder->key = 0;
+    builder->count = 0;
+    builder->values = (uint16_t *)roaring_malloc((1 << 16) * sizeof(uint16_t));
+    return builder->values != NULL;
+}
+
+bool roaring_bulk_builder_flush(roaring_bulk_builder_t *builder) {
+    if (builder->count == 0) return true;
+    const uint16_t *vals = builder->values;
+    int32_t n_runs = 1;
+    for (int32_t i = 1; i < builder->count; i++) {
+        n_runs += vals[i] != vals[i - 1] + 1;
+    }
+    uint8_t typecode;
+    container_t *c =
+        container_from_sorted(vals, false, builder->count, n_runs, &typecode);
+    builder->count = 0;
+    if (c == NULL) return false;
+    roaring_array_t *ra = &builder->r->high_low_container;
+    if (ra->size == 0 || ra->keys[ra->size - 1] < builder->key) {
+        ra_append(ra, builder->key, c, typecode);
+        return true;
+    }
+    // the bitmap already ends with this key
+    assert(ra->keys[ra->size - 1] == builder->key);
+    uint8_t last_type;
+    container_t *last =
+        ra_get_container_at_index(ra, (uint16_t)(ra->size - 1), &last_type);
+    uint8_t result_type;
+    container_t *merged =
+        (last_type == SHARED_CONTAINER_TYPE)
+            ? container_or(last, last_type, c, typecode, &result_type)
+            : container_ior(last, last_type, c, typecode, &result_type);
+    if (merged != last) {
+        container_free(last, last_type);
+    }
+    ra_set_container_at_index(ra, ra->size - 1, merged, result_type);
+    container_free(c, typecode);
+    return true;
+}
+
+bool roaring_bulk_builder_finish(roaring_bulk_builder_t *builder) {
+    bool is_ok = roaring_bulk_builder_flush(builder);
+    roaring_free(builder->values);
+    builder->values = NULL;
+    return is_ok;
+}
+
 roaring_bitmap_t *roaring_bitmap_of(size_t n_args, ...) {
     // todo: could be greatly optimized but we do not expect this call to ever
     // include long lists
@@ -304,7 +451,8 @@ void roaring_bitmap_printf_describe(const roaring_bitmap_t *r) {
         if (ra->typecodes[i] == SHARED_CONTAINER_TYPE) {
             printf(
                 "(shared count = %" PRIu32 " )",
-                    CAST_shared(ra->containers[i])->counter);
+                croaring_refcount_get(
+                    &CAST_shared(ra->containers[i])->counter));
         }
 
         if (i + 1 < ra->size) {
@@ -380,14 +528,14 @@ void roaring_bitmap_statistics(const roaring_bitmap_t *r,
 
 roaring_bitmap_t *roaring_bitmap_copy(const roaring_bitmap_t *r) {
     roaring_bitmap_t *ans =
-        (roaring_bitmap_t *)malloc(sizeof(roaring_bitmap_t));
+        (roaring_bitmap_t *)roaring_malloc(sizeof(roaring_bitmap_t));
     if (!ans) {
         return NULL;
     }
     if (!ra_init_with_capacity(  // allocation of list of containers can fail
                 &ans->high_low_container, r->high_low_container.size)
     ){
-        free(ans);
+        roaring_free(ans);
         return NULL;
     }
     if (!ra_overwrite(  // memory allocation of individual containers may fail
@@ -400,6 +548,11 @@ roaring_bitmap_t *roaring_bitmap_copy(const roaring_bitmap_t *r) {
     return ans;
 }
 
+roaring_bitmap_t *roaring_bitmap_snapshot(roaring_bitmap_t *r) {
+    roaring_bitmap_set_copy_on_write(r, true);
+    return roaring_bitmap_copy(r);
+}
+
 bool roaring_bitmap_overwrite(roaring_bitmap_t *dest,
                                      const roaring_bitmap_t *src) {
     return ra_overwrite(&src->high_low_container, &dest->high_low_container,
@@ -410,7 +563,7 @@ void roaring_bitmap_free(const roaring_bitmap_t *r) {
     if (!is_frozen(r)) {
       ra_clear((roaring_array_t*)&r->high_low_container);
     }
-    free((roaring_bitmap_t*)r);
+    roaring_free((roaring_bitmap_t*)r);
 }
 
 void roaring_bitmap_clear(roaring_bitmap_t *r) {
@@ -510,6 +663,36 @@ void roaring_bitmap_remove(roaring_bitmap_t *r, uint32_t val) {
     }
 }
 
+void roaring_bitmap_remove_bulk(roaring_bitmap_t *r,
+                                roaring_bulk_context_t *context,
+                                uint32_t val) {
+    roaring_array_t *ra = &r->high_low_container;
+    const uint16_t key = val >> 16;
+    if (context->container == NULL || context->key != key ||
+        context->typecode == SHARED_CONTAINER_TYPE) {
+        const int idx = ra_get_index(ra, key);
+        if (idx < 0) return;
+        ra_unshare_container_at_index(ra, idx);
+        context->container = ra_get_container_at_index(ra, idx,
+                                                       &context->typecode);
+        context->idx = idx;
+        context->key = key;
+    }
+    uint8_t new_typecode = context->typecode;
+    container_t *container2 = container_remove(
+        context->container, val & 0xFFFF, context->typecode, &new_typecode);
+    if (container2 != context->container) {
+        container_free(context->container, context->typecode);
+        ra_set_container_at_index(ra, context->idx, container2, new_typecode);
+        context->typecode = new_typecode;
+        context->container = container2;
+    }
+    if (!container_nonzero_cardinality(container2, new_typecode)) {
+        ra_remove_at_index_and_free(ra, context->idx);
+        context->container = NULL;
+    }
+}
+
 bool roaring_bitmap_remove_checked(roaring_bitmap_t *r, uint32_t val) {
     const uint16_t hb = val >> 16;
     const int i = ra_get_index(&r->high_low_container, hb);
@@ -621,6 +804,135 @@ roaring_bitmap_t *roaring_bitmap_and(const roaring_bitmap_t *x1,
     return answer;
 }
 
+/**
+ * Compute the intersection of 'number' bitmaps.
+ *
+ * The bitmap having the fewest containers drives the search: its keys are
+ * matched against the keys of the other bitmaps by galloping, and whenever
+ * another bitmap lacks a key we leap directly to the next key it has.  When
+ * all bitmaps share a key, the containers are intersected from the smallest
+ * to the largest cardinality and we stop as soon as the result goes empty.
+ */
+roaring_bitmap_t *roaring_bitmap_and_many(size_t number,
+                                          const roaring_bitmap_t **x) {
+    if (number == 0) {
+        return roaring_bitmap_create();
+    }
+    if (number == 1) {
+        return roaring_bitmap_copy(x[0]);
+    }
+    if (number == 2) {
+        return roaring_bitmap_and(x[0], x[1]);
+    }
+    size_t smallest = 0;
+    bool copy_on_write = true;
+    for (size_t i = 0; i < number; i++) {
+        if (x[i]->high_low_container.size <
+            x[smallest]->high_low_container.size) {
+            smallest = i;
+        }
+        copy_on_write = copy_on_write && is_cow(x[i]);
+    }
+    const roaring_array_t *ra0 = &x[smallest]->high_low_container;
+    roaring_bitmap_t *answer = roaring_bitmap_create_with_capacity(ra0->size);
+    if (answer == NULL) {
+        return NULL;
+    }
+    roaring_bitmap_set_copy_on_write(answer, copy_on_write);
+    if (ra0->size == 0) {
+        return answer;
+    }
+
+    int32_t *positions = (int32_t *)roaring_calloc(number, sizeof(int32_t));
+    container_t **containers =
+        (container_t **)roaring_malloc(number * sizeof(container_t *));
+    uint8_t *types = (uint8_t *)roaring_malloc(number * sizeof(uint8_t));
+    int *cardinalities = (int *)roaring_malloc(number * sizeof(int));
+    if (positions == NULL || containers == NULL || types == NULL ||
+        cardinalities == NULL) {
+        roaring_free(positions);
+        roaring_free(containers);
+        roaring_free(types);
+        roaring_free(cardinalities);
+        roaring_bitmap_free(answer);
+        return NULL;
+    }
+
+    int32_t pos0 = 0;
+    bool exhausted = false;
+    while (!exhausted && pos0 < ra0->size) {
+        const uint16_t key = ra0->keys[pos0];
+        bool all_match = true;
+        for (size_t i = 0; i < number; i++) {
+            if (i == smallest) continue;
+            const roaring_array_t *ra = &x[i]->high_low_container;
+            int32_t pos = positions[i];
+            if (pos < ra->size && ra->keys[pos] < key) {
+                pos = ra_advance_until(ra, key, pos);
+                positions[i] = pos;
+            }
+            if (pos == ra->size) {  // no more keys in common
+                exhausted = true;
+                all_match = false;
+                break;
+            }
+            if (ra->keys[pos] != key) {  // leapfrog to the next candidate
+                pos0 = ra_advance_until(ra0, ra->keys[pos], pos0);
+                all_match = false;
+                break;
+            }
+        }
+        if (!all_match) continue;
+
+        // gather the containers, ordered by increasing cardinality
+        for (size_t i = 0; i < number; i++) {
+            const int32_t pos = (i == smallest) ? pos0 : positions[i];
+            uint8_t type;
+            container_t *c = ra_get_container_at_index(
+                                &x[i]->high_low_container, pos, &type);
+            const int card = container_get_cardinality(c, type);
+            size_t j = i;
+            while (j > 0 && cardinalities[j - 1] > card) {
+                containers[j] = containers[j - 1];
+                types[j] = types[j - 1];
+                cardinalities[j] = cardinalities[j - 1];
+                j--;
+            }
+            containers[j] = c;
+            types[j] = type;
+            cardinalities[j] = card;
+        }
+
+        uint8_t result_type;
+        container_t *c = container_and(containers[0], types[0],
+                                       containers[1], types[1], &result_type);
+        for (size_t i = 2;
+             i < number && container_nonzero_cardinality(c, result_type);
+             i++) {
+            uint8_t new_type;
+            container_t *c2 = container_iand(c, result_type, containers[i],
+                                             types[i], &new_type);
+            if (c2 != c) {  // a new container was created, free the old one
+                container_free(c, result_type);
+            }
+            c = c2;
+            result_type = new_type;
+        }
+        if (container_nonzero_cardinality(c, result_type)) {
+            ra_append(&answer->high_low_container, key, c, result_type);
+        } else {
+            container_free(c, result_type);
+        }
+        pos0++;
+    }
+
+    roaring_free(positions);
+    roaring_free(containers);
+    roaring_free(types);
+    roaring_free(cardinalities);
+    return answer;
+}
+
 /**
  * Compute the union of 'number' bitmaps.
  */
@@ -641,6 +953,144 @@ roaring_bitmap_t *roaring_bitmap_or_many(size_t number,
     return answer;
 }
 
+/*
+ * State shared by the tasks of roaring_bitmap_or_many_parallel(): the task
+ * of index s unions the containers having their key in
+ * [boundaries[s], boundaries[s + 1]) and stores the result in results[s].
+ */
+typedef struct or_many_shards_s {
+    size_t number;
+    const roaring_bitmap_t **x;
+    const uint32_t *boundaries;
+    roaring_bitmap_t **results;
+} or_many_shards_t;
+
+// index of the first container having a key greater or equal to key
+static inline int32_t ra_lower_bound(const roaring_array_t *ra,
+                                     uint32_t key) {
+    if (key > UINT16_MAX) return ra->size;
+    return count_less(ra->keys, ra->size, (uint16_t)key);
+}
+
+static void or_many_shard(void *task_data, size_t shard) {
+    or_many_shards_t *shards = (or_many_shards_t *)task_data;
+    const uint32_t start = shards->boundaries[shard];
+    const uint32_t end = shards->boundaries[shard + 1];
+    roaring_bitmap_t *answer = roaring_bitmap_create();
+    if (answer == NULL) {
+        return;  // results[shard] stays NULL, reporting the failure
+    }
+    for (size_t i = 0; i < shards->number; i++) {
+        const roaring_array_t *ra = &shards->x[i]->high_low_container;
+        const int32_t begin = ra_lower_bound(ra, start);
+        const int32_t stop = ra_lower_bound(ra, end);
+        if (begin == stop) continue;
+        // a view over the containers of x[i] that belong to this shard; the
+        // shards own disjoint keys so they never touch the same containers
+        roaring_bitmap_t view;
+        view.high_low_container.size = stop - begin;
+        view.high_low_container.allocation_size = stop - begin;
+        view.high_low_container.keys = ra->keys + begin;
+        view.high_low_container.containers = ra->containers + begin;
+        view.high_low_container.typecodes = ra->typecodes + begin;
+        view.high_low_container.flags = ra->flags;
+        roaring_bitmap_lazy_or_inplace(answer, &view,
+                                       LAZY_OR_BITSET_CONVERSION);
+    }
+    roaring_bitmap_repair_after_lazy(answer);
+    shards->results[shard] = answer;
+}
+
+/**
+ * Compute the union of 'number' bitmaps, split in shards over disjoint key
+ * ranges which can be processed concurrently by the executor.
+ */
+roaring_bitmap_t *roaring_bitmap_or_many_parallel(
+        size_t number, const roaring_bitmap_t **x, size_t num_shards,
+        roaring_executor executor, void *executor_data) {
+    if (number == 0) {
+        return roaring_bitmap_create();
+    }
+    if (number == 1) {
+        return roaring_bitmap_copy(x[0]);
+    }
+
+    // We balance the shards according to the number of containers falling
+    // in each of the 256 blocks of 256 keys.
+    uint32_t histogram[256] = {0};
+    uint64_t total = 0;
+    bool copy_on_write = true;
+    for (size_t i = 0; i < number; i++) {
+        const roaring_array_t *ra = &x[i]->high_low_container;
+        for (int32_t j = 0; j < ra->size; j++) {
+            histogram[ra->keys[j] >> 8]++;
+        }
+        total += ra->size;
+        copy_on_write = copy_on_write && is_cow(x[i]);
+    }
+    if (num_shards == 0) num_shards = 1;
+    if (num_shards > 256) num_shards = 256;
+
+    uint32_t boundaries[256 + 1];
+    size_t count = 1;
+    boundaries[0] = 0;
+    uint64_t seen = 0;
+    for (uint32_t block = 0; block < 255 && count < num_shards; block++) {
+        seen += histogram[block];
+        if (seen * num_shards >= total * count && seen > 0) {
+            boundaries[count++] = (block + 1) << 8;
+        }
+    }
+    boundaries[count] = UINT32_C(1) << 16;
+
+    roaring_bitmap_t **results =
+        (roaring_bitmap_t **)roaring_calloc(count, sizeof(roaring_bitmap_t *));
+    if (results == NULL) {
+        return NULL;
+    }
+    or_many_shards_t shards;
+    shards.number = number;
+    shards.x = x;
+    shards.boundaries = boundaries;
+    shards.results = results;
+    if (executor == NULL) {
+        for (size_t s = 0; s < count; s++) {
+            or_many_shard(&shards, s);
+        }
+    } else {
+        executor(&or_many_shard, &shards, count, executor_data);
+    }
+
+    // the shards own disjoint and increasing key ranges: no merge is needed
+    int32_t total_size = 0;
+    bool is_ok = true;
+    for (size_t s = 0; s < count; s++) {
+        if (results[s] == NULL) {
+            is_ok = false;
+        } else {
+            total_size += results[s]->high_low_container.size;
+        }
+    }
+    roaring_bitmap_t *answer =
+        is_ok ? roaring_bitmap_create_with_capacity(total_size) : NULL;
+    if (answer != NULL) {
+        roaring_bitmap_set_copy_on_write(answer, copy_on_write);
+        for (size_t s = 0; s < count; s++) {
+            roaring_array_t *ra = &results[s]->high_low_container;
+            ra_append_move_range(&answer->high_low_container, ra, 0,
+                                 ra->size);
+            ra_clear_without_containers(ra);
+        }
+    }
+    for (size_t s = 0; s < count; s++) {
+        if (results[s] != NULL) {
+            roaring_bitmap_free(results[s]);
+        }
+    }
+    roaring_free(results);
+    return answer;
+}
+
 /**
  * Compute the xor of 'number' bitmaps.
  */
@@ -1380,7 +1830,7 @@ size_t roaring_bitmap_portable_size_in_bytes(const roaring_bitmap_t *r) {
 
 roaring_bitmap_t *roaring_bitmap_portable_deserialize_safe(const char *buf, size_t maxbytes) {
     roaring_bitmap_t *ans =
-        (roaring_bitmap_t *)malloc(sizeof(roaring_bitmap_t));
+        (roaring_bitmap_t *)roaring_malloc(sizeof(roaring_bitmap_t));
     if (ans == NULL) {
         return NULL;
     }
@@ -1389,7 +1839,7 @@ roaring_bitmap_t *roaring_bitmap_portable_deserialize_safe(const char *buf, size
     if(is_ok) assert(bytesread <= maxbytes);
     roaring_bitmap_set_copy_on_write(ans, false);
     if (!is_ok) {
-        free(ans);
+        roaring_free(ans);
         return NULL;
     }
     return ans;
@@ -1410,6 +1860,28 @@ size_t roaring_bitmap_portable_serialize(const roaring_bitmap_t *r,
     return ra_portable_serialize(&r->high_low_container, buf);
 }
 
+size_t roaring_bitmap_portable_serialize_stream(const roaring_bitmap_t *r,
+                                                roaring_write_function write,
+                                                void *param) {
+    return ra_portable_serialize_stream(&r->high_low_container, write, param);
+}
+
+roaring_bitmap_t *roaring_bitmap_portable_deserialize_stream(
+    roaring_read_function read, void *param) {
+    roaring_bitmap_t *ans =
+        (roaring_bitmap_t *)roaring_malloc(sizeof(roaring_bitmap_t));
+    if (ans == NULL) {
+        return NULL;
+    }
+    if (!ra_portable_deserialize_stream(&ans->high_low_container, read,
+                                        param)) {
+        roaring_free(ans);
+        return NULL;
+    }
+    roaring_bitmap_set_copy_on_write(ans, false);
+    return ans;
+}
+
 roaring_bitmap_t *roaring_bitmap_deserialize(const void *buf) {
     const char *bufaschar = (const char *)buf;
     if (*(const unsigned char *)buf == SERIALIZATION_ARRAY_UINT32) {
@@ -1615,7 +2087,7 @@ void roaring_init_iterator_last(const roaring_bitmap_t *r,
 
 roaring_uint32_iterator_t *roaring_create_iterator(const roaring_bitmap_t *r) {
     roaring_uint32_iterator_t *newit =
-        (roaring_uint32_iterator_t *)malloc(sizeof(roaring_uint32_iterator_t));
+        (roaring_uint32_iterator_t *)roaring_malloc(sizeof(roaring_uint32_iterator_t));
     if (newit == NULL) return NULL;
     roaring_init_iterator(r, newit);
     return newit;
@@ -1624,14 +2096,40 @@ roaring_uint32_iterator_t *roaring_create_iterator(const roaring_bitmap_t *r) {
 roaring_uint32_iterator_t *roaring_copy_uint32_iterator(
     const roaring_uint32_iterator_t *it) {
     roaring_uint32_iterator_t *newit =
-        (roaring_uint32_iterator_t *)malloc(sizeof(roaring_uint32_iterator_t));
+        (roaring_uint32_iterator_t *)roaring_malloc(sizeof(roaring_uint32_iterator_t));
     memcpy(newit, it, sizeof(roaring_uint32_iterator_t));
     return newit;
 }
 
 bool roaring_move_uint32_iterator_equalorlarger(roaring_uint32_iterator_t *it, uint32_t val) {
     uint16_t hb = val >> 16;
-    const int i = ra_get_index(& it->parent->high_low_container, hb);
+    const roaring_array_t *ra = &it->parent->high_low_container;
+    int i;
+    if (it->has_value && val > it->current_value) {
+        // Moving forward, as when intersecting bitmaps: the target is
+        // usually close, so we gallop from the current position instead of
+        // searching the whole bitmap.
+        if (hb == (it->highbits >> 16) &&
+            it->typecode == ARRAY_CONTAINER_TYPE) {
+            const array_container_t *ac = const_CAST_array(it->container);
+            const int32_t pos = advanceUntil(ac->array, it->in_container_index,
+                                             ac->cardinality, val & 0xFFFF);
+            if (pos < ac->cardinality) {
+                it->in_container_index = pos;
+                it->current_value = it->highbits | ac->array[pos];
+                return true;
+            }
+            it->container_index++;
+            it->has_value = loadfirstvalue(it);
+            return it->has_value;
+        }
+        i = ra_advance_until(ra, hb, it->container_index - 1);
+        if (i == ra->size || ra->keys[i] != hb) {
+            i = -i - 1;
+        }
+    } else {
+        i = ra_get_index(ra, hb);
+    }
     if (i >= 0) {
       uint32_t lowvalue = container_maximum(it->parent->high_low_container.containers[i], it->parent->high_low_container.typecodes[i]);
       uint16_t lb = val & 0xFFFF;
@@ -1869,8 +2367,120 @@ uint32_t roaring_read_uint32_iterator(roaring_uint32_iterator_t *it, uint32_t* b
 }
 
 
+// Returns the end (excluded, up to 1 << 16) of the span of consecutive values
+// of the container that starts at it->current_value, and moves the iterator
+// to the next value of the container, if any.
+static uint32_t iter_read_span(roaring_uint32_iterator_t *it) {
+    uint32_t end;
+    switch (it->typecode) {
+        case BITSET_CONTAINER_TYPE: {
+            // 64 values at a time: first clear bit, then next set bit
+            const bitset_container_t *bc = const_CAST_bitset(it->container);
+            uint32_t wordindex = it->in_container_index / 64;
+            uint64_t word = ~bc->words[wordindex] &
+                            (UINT64_MAX << (it->in_container_index % 64));
+            while (word == 0 &&
+                   ++wordindex < BITSET_CONTAINER_SIZE_IN_WORDS) {
+                word = ~bc->words[wordindex];
+            }
+            if (word == 0) {
+                it->has_value = false;
+                return 1 << 16;
+            }
+            end = wordindex * 64 + __builtin_ctzll(word);
+            word = bc->words[wordindex] & (UINT64_MAX << (end % 64));
+            while (word == 0 &&
+                   ++wordindex < BITSET_CONTAINER_SIZE_IN_WORDS) {
+                word = bc->words[wordindex];
+            }
+            it->has_value = (word != 0);
+            if (it->has_value) {
+                it->in_container_index = wordindex * 64 + __builtin_ctzll(word);
+                it->current_value = it->highbits | it->in_container_index;
+            }
+            return end;
+        }
+        case ARRAY_CONTAINER_TYPE: {
+            // values are distinct and sorted, so array[i..j] is a span exactly
+            // when array[j] - array[i] == j - i: gallop for the last such j
+            const array_container_t *ac = const_CAST_array(it->container);
+            const int32_t i = it->in_container_index;
+            const uint16_t first = ac->array[i];
+            int32_t lower = i;  // in the span
+            int32_t upper = ac->cardinality;  // past the span
+            int32_t spansize = 1;
+            while (lower + spansize < upper) {
+                int32_t j = lower + spansize;
+                if (ac->array[j] - first != j - i) {
+                    upper = j;
+                    break;
+                }
+                lower = j;
+                spansize <<= 1;
+            }
+            while (lower + 1 < upper) {
+                int32_t middle = (lower + upper) >> 1;
+                if (ac->array[middle] - first == middle - i) {
+                    lower = middle;
+                } else {
+                    upper = middle;
+                }
+            }
+            end = ac->array[lower] + 1;
+            it->in_container_index = lower + 1;
+            it->has_value = (it->in_container_index < ac->cardinality);
+            if (it->has_value) {
+                it->current_value =
+                    it->highbits | ac->array[it->in_container_index];
+            }
+            return end;
+        }
+        case RUN_CONTAINER_TYPE: {
+            const run_container_t *rc = const_CAST_run(it->container);
+            int32_t r = it->run_index;
+            end = rc->runs[r].value + rc->runs[r].length + 1;
+            // runs are not supposed to touch, but we do not rely on it
+            while (++r < rc->n_runs && rc->runs[r].value == end) {
+                end = rc->runs[r].value + rc->runs[r].length + 1;
+            }
+            it->run_index = r;
+            it->has_value = (r < rc->n_runs);
+            if (it->has_value) {
+                it->current_value = it->highbits | rc->runs[r].value;
+            }
+            return end;
+        }
+        default:
+            assert(false);
+            __builtin_unreachable();
+    }
+    return 0;
+}
+
+uint32_t roaring_read_uint32_iterator_ranges(roaring_uint32_iterator_t *it,
+                                             uint64_t *ranges,
+                                             uint32_t count) {
+    uint32_t ret = 0;
+    while (it->has_value && ret < count) {
+        uint64_t start = it->current_value;
+        uint64_t end;
+        do {
+            end = (uint64_t)it->highbits + iter_read_span(it);
+            if (!it->has_value) {
+                it->container_index++;
+                it->has_value = loadfirstvalue(it);
+            }
+            // a span may go on in the next container
+        } while (it->has_value && it->current_value == end);
+        ranges[2 * ret] = start;
+        ranges[2 * ret + 1] = end;
+        ret++;
+    }
+    return ret;
+}
+
 
-void roaring_free_uint32_iterator(roaring_uint32_iterator_t *it) { free(it); }
+void roaring_free_uint32_iterator(roaring_uint32_iterator_t *it) { roaring_free(it); }
 
 /****
 * end of roaring_uint32_iterator_t
@@ -2133,6 +2743,69 @@ void roaring_bitmap_flip_inplace(roaring_bitmap_t *x1, uint64_t range_start,
     }
 }
 
+roaring_bitmap_t *roaring_bitmap_add_offset(const roaring_bitmap_t *bm,
+                                            int64_t offset) {
+    const roaring_array_t *ra = &bm->high_low_container;
+    const bool cow = is_cow(bm);
+    // offset == key_offset * (1 << 16) + in_offset, 0 <= in_offset < 1 << 16
+    // (the shift rounds towards minus infinity, even for INT64_MIN)
+    const int64_t key_offset = offset >> 16;
+    const uint16_t in_offset = (uint16_t)(offset & 0xFFFF);
+
+    roaring_bitmap_t *answer = roaring_bitmap_create_with_capacity(ra->size);
+    if (answer == NULL) return NULL;
+    roaring_array_t *ans_ra = &answer->high_low_container;
+    roaring_bitmap_set_copy_on_write(answer, cow);
+    if (in_offset == 0) {
+        // whole containers move: only the keys change
+        for (int32_t i = 0; i < ra->size; i++) {
+            int64_t key = ra->keys[i] + key_offset;
+            if (key < 0 || key > 0xFFFF) continue;
+            ra_append_copy(ans_ra, ra, (uint16_t)i, cow);
+            ans_ra->keys[ans_ra->size - 1] = (uint16_t)key;
+        }
+        return answer;
+    }
+
+    for (int32_t i = 0; i < ra->size; i++) {
+        // the container lands on key and key + 1
+        int64_t key = ra->keys[i] + key_offset;
+        if (key + 1 < 0 || key > 0xFFFF) continue;
+        container_t *lo = NULL, *hi = NULL;
+        uint8_t lo_type = 0, hi_type = 0;
+        if (!container_add_offset(ra->containers[i], ra->typecodes[i],
+                                  key >= 0 ? &lo : NULL, &lo_type,
+                                  key < 0xFFFF ? &hi : NULL, &hi_type,
+                                  in_offset)) {
+            roaring_bitmap_free(answer);
+            return NULL;
+        }
+        if (lo != NULL) {
+            if (ans_ra->size > 0 && ans_ra->keys[ans_ra->size - 1] == key) {
+                // merge with the high part of the previous container
+                uint8_t last_type;
+                container_t *last = ra_get_container_at_index(
+                    ans_ra, (uint16_t)(ans_ra->size - 1), &last_type);
+                uint8_t merged_type;
+                container_t *merged =
+                    container_ior(last, last_type, lo, lo_type, &merged_type);
+                if (merged != last) {
+                    container_free(last, last_type);
+                }
+                ra_set_container_at_index(ans_ra, ans_ra->size - 1, merged,
+                                          merged_type);
+                container_free(lo, lo_type);
+            } else {
+                ra_append(ans_ra, (uint16_t)key, lo, lo_type);
+            }
+        }
+        if (hi != NULL) {
+            ra_append(ans_ra, (uint16_t)(key + 1), hi, hi_type);
+        }
+    }
+    return answer;
+}
+
 roaring_bitmap_t *roaring_bitmap_lazy_or(const roaring_bitmap_t *x1,
                                          const roaring_bitmap_t *x2,
                                          const bool bitsetconversion) {
@@ -2512,6 +3185,35 @@ uint64_t roaring_bitmap_rank(const roaring_bitmap_t *bm, uint32_t x) {
     return size;
 }
 
+void roaring_bitmap_rank_many(const roaring_bitmap_t *bm, const uint32_t *begin,
+                              const uint32_t *end, uint64_t *ans) {
+    uint64_t size = 0;
+    int i = 0;
+    const uint32_t *iter = begin;
+    while (i < bm->high_low_container.size && iter != end) {
+        uint32_t xhigh = *iter >> 16;
+        uint32_t key = bm->high_low_container.keys[i];
+        if (xhigh > key) {
+            size +=
+                container_get_cardinality(bm->high_low_container.containers[i],
+                                          bm->high_low_container.typecodes[i]);
+            i++;
+        } else if (xhigh == key) {
+            uint32_t consumed = container_rank_many(
+                bm->high_low_container.containers[i],
+                bm->high_low_container.typecodes[i], size, iter, end, ans);
+            iter += consumed;
+            ans += consumed;
+        } else {
+            *(ans++) = size;
+            iter++;
+        }
+    }
+    for (; iter != end; iter++) {
+        *(ans++) = size;
+    }
+}
+
 /**
 * roaring_bitmap_smallest returns the smallest value in the set.
 * Returns UINT32_MAX if the set is empty.
@@ -2569,6 +3271,118 @@ bool roaring_bitmap_select(const roaring_bitmap_t *bm, uint32_t rank,
         return false;
 }
 
+size_t roaring_bitmap_select_many(const roaring_bitmap_t *bm,
+                                  const uint32_t *begin, const uint32_t *end,
+                                  uint32_t *element) {
+    uint64_t start_rank = 0;
+    int i = 0;
+    const uint32_t *iter = begin;
+    while (i < bm->high_low_container.size && iter != end) {
+        container_t *c = bm->high_low_container.containers[i];
+        uint8_t typecode = bm->high_low_container.typecodes[i];
+        uint64_t card = container_get_cardinality(c, typecode);
+        if (*iter >= start_rank + card) {
+            start_rank += card;
+            i++;
+            continue;
+        }
+        uint32_t consumed = container_select_many(
+            c, typecode, (uint32_t)start_rank, iter, end, element);
+        uint32_t high = ((uint32_t)bm->high_low_container.keys[i]) << 16;
+        for (uint32_t j = 0; j < consumed; j++) {
+            element[j] |= high;
+        }
+        iter += consumed;
+        element += consumed;
+        start_rank += card;
+        i++;
+    }
+    return iter - begin;
+}
+
+bool roaring_rank_index_rebuild(const roaring_bitmap_t *bm,
+                                roaring_rank_index_t *index) {
+    const roaring_array_t *ra = &bm->high_low_container;
+    if (index->cardinalities == NULL || index->size < ra->size) {
+        uint64_t *cardinalities = (uint64_t *)roaring_realloc(
+            index->cardinalities, (ra->size + 1) * sizeof(uint64_t));
+        if (cardinalities == NULL) {
+            return false;
+        }
+        index->cardinalities = cardinalities;
+    }
+    index->size = ra->size;
+    uint64_t card = 0;
+    for (int32_t i = 0; i < ra->size; i++) {
+        index->cardinalities[i] = card;
+        card += container_get_cardinality(ra->containers[i], ra->typecodes[i]);
+    }
+    index->cardinalities[ra->size] = card;
+    return true;
+}
+
+roaring_rank_index_t *roaring_rank_index_create(const roaring_bitmap_t *bm) {
+    roaring_rank_index_t *index =
+        (roaring_rank_index_t *)roaring_malloc(sizeof(roaring_rank_index_t));
+    if (index == NULL) {
+        return NULL;
+    }
+    index->size = 0;
+    index->cardinalities = NULL;
+    if (!roaring_rank_index_rebuild(bm, index)) {
+        roaring_free(index);
+        return NULL;
+    }
+    return index;
+}
+
+void roaring_rank_index_free(roaring_rank_index_t *index) {
+    if (index == NULL) {
+        return;
+    }
+    roaring_free(index->cardinalities);
+    roaring_free(index);
+}
+
+bool roaring_bitmap_select_indexed(const roaring_bitmap_t *bm,
+                                   const roaring_rank_index_t *index,
+                                   uint32_t rank, uint32_t *element) {
+    assert(index->size == bm->high_low_container.size);
+    if (rank >= index->cardinalities[index->size]) {
+        return false;
+    }
+    // last container starting at or before rank (there are no empty ones)
+    int32_t low = 0, high = index->size - 1;
+    while (low < high) {
+        int32_t middle = (low + high + 1) >> 1;
+        if (index->cardinalities[middle] <= rank) {
+            low = middle;
+        } else {
+            high = middle - 1;
+        }
+    }
+    uint32_t start_rank = (uint32_t)index->cardinalities[low];
+    bool valid = container_select(bm->high_low_container.containers[low],
+                                  bm->high_low_container.typecodes[low],
+                                  &start_rank, rank, element);
+    assert(valid);
+    *element |= ((uint32_t)bm->high_low_container.keys[low]) << 16;
+    return valid;
+}
+
+uint64_t roaring_bitmap_rank_indexed(const roaring_bitmap_t *bm,
+                                     const roaring_rank_index_t *index,
+                                     uint32_t x) {
+    assert(index->size == bm->high_low_container.size);
+    int32_t i = ra_get_index(&bm->high_low_container, x >> 16);
+    if (i < 0) {
+        return index->cardinalities[-i - 1];
+    }
+    return index->cardinalities[i] +
+           container_rank(bm->high_low_container.containers[i],
+                          bm->high_low_container.typecodes[i], x & 0xFFFF);
+}
+
 bool roaring_bitmap_intersect(const roaring_bitmap_t *x1,
                                      const roaring_bitmap_t *x2) {
     const int length1 = x1->high_low_container.size,
@@ -2696,6 +3510,59 @@ bool roaring_bitmap_contains(const roaring_bitmap_t *r, uint32_t val) {
     return container_contains(container, val & 0xFFFF, typecode);
 }
 
+bool roaring_bitmap_contains_bulk(const roaring_bitmap_t *r,
+                                  roaring_bulk_context_t *context,
+                                  uint32_t val) {
+    const roaring_array_t *ra = &r->high_low_container;
+    const uint16_t key = val >> 16;
+    if (context->container == NULL || context->key != key) {
+        // keys past the cached one are sought from there
+        int32_t start_idx = -1;
+        if (context->container != NULL && context->key < key) {
+            start_idx = context->idx;
+        }
+        int32_t idx = ra_advance_until(ra, key, start_idx);
+        if (idx == ra->size || ra->keys[idx] != key) {
+            return false;
+        }
+        context->container = ra->containers[idx];
+        context->typecode = ra->typecodes[idx];
+        context->idx = idx;
+        context->key = key;
+    }
+    return container_contains(context->container, val & 0xFFFF,
+                              context->typecode);
+}
+
+void roaring_bitmap_contains_many(const roaring_bitmap_t *r, size_t n_args,
+                                  const uint32_t *vals, bool *results) {
+    const roaring_array_t *ra = &r->high_low_container;
+    int32_t pos = 0;  // index of the last key sought, or of where it would be
+    uint16_t prevhb = 0;
+    size_t i = 0;
+    while (i < n_args) {
+        const uint16_t hb = vals[i] >> 16;
+        size_t j = i + 1;
+        while (j < n_args && (vals[j] >> 16) == hb) {
+            j++;
+        }
+        if (hb >= prevhb) {
+            pos = ra_advance_until(ra, hb, pos - 1);
+        } else {  // out of order, search from scratch
+            pos = ra_get_index(ra, hb);
+            if (pos < 0) pos = -pos - 1;
+        }
+        prevhb = hb;
+        if (pos < ra->size && ra->keys[pos] == hb) {
+            container_contains_many(ra->containers[pos], ra->typecodes[pos],
+                                    vals + i, j - i, results + i);
+        } else {
+            memset(results + i, 0, (j - i) * sizeof(bool));
+        }
+        i = j;
+    }
+}
+
 
 /**
  * Check whether a range of values from range_start (included) to range_end (excluded) is present
@@ -2968,7 +3835,7 @@ roaring_bitmap_frozen_view(const char *buf, size_t length) {
     alloc_size += num_run_containers * sizeof(run_container_t);
     alloc_size += num_array_containers * sizeof(array_container_t);
 
-    char *arena = (char *)malloc(alloc_size);
+    char *arena = (char *)roaring_malloc(alloc_size);
     if (arena == NULL) {
         return NULL;
     }
@@ -3015,8 +3882,202 @@ roaring_bitmap_frozen_view(const char *buf, size_t length) {
                 break;
             }
             default:
-                free(arena);
+                roaring_free(arena);
+                return NULL;
+        }
+    }
+
+    return rb;
+}
+
+// the run flag of the i-th container, in the run bitmap of the portable format
+static inline bool portable_is_run(const char *run_flags, int32_t i) {
+    return run_flags != NULL && (run_flags[i / 8] & (1 << (i % 8))) != 0;
+}
+
+const roaring_bitmap_t *
+roaring_bitmap_portable_view(const char *buf, size_t length) {
+    // cookie and num_containers
+    size_t pos = sizeof(uint32_t);
+    if (length < pos) {
+        return NULL;
+    }
+    uint32_t cookie;
+    memcpy(&cookie, buf, sizeof(uint32_t));
+    if ((cookie & 0xFFFF) != SERIAL_COOKIE &&
+        cookie != SERIAL_COOKIE_NO_RUNCONTAINER) {
+        return NULL;
+    }
+    bool hasrun = (cookie & 0xFFFF) == SERIAL_COOKIE;
+    int32_t num_containers;
+    if (hasrun) {
+        num_containers = (cookie >> 16) + 1;
+    } else {
+        if (length < pos + sizeof(int32_t)) {
+            return NULL;
+        }
+        memcpy(&num_containers, buf + pos, sizeof(int32_t));
+        pos += sizeof(int32_t);
+        if (num_containers < 0 || num_containers > (1 << 16)) {
+            return NULL;
+        }
+    }
+
+    // run bitmap, key/cardinality pairs, and the offsets that we skip
+    const char *run_flags = NULL;
+    if (hasrun) {
+        run_flags = buf + pos;
+        pos += (num_containers + 7) / 8;
+    }
+    const char *keyscards = buf + pos;
+    pos += (size_t)num_containers * 2 * sizeof(uint16_t);
+    if (!hasrun || num_containers >= NO_OFFSET_THRESHOLD) {
+        pos += (size_t)num_containers * sizeof(uint32_t);
+    }
+    if (length < pos) {
+        return NULL;
+    }
+
+    // Containers are used in place when their data is aligned: 2 bytes for
+    // arrays and runs, 32 bytes for bitsets, whose AVX code uses aligned
+    // loads. The others are copied to the end of the arena.
+    int32_t num_bitset_containers = 0;
+    int32_t num_run_containers = 0;
+    int32_t num_array_containers = 0;
+    size_t bitset_copy_size = 0;
+    size_t small_copy_size = 0;
+    size_t data_pos = pos;
+    for (int32_t i = 0; i < num_containers; i++) {
+        uint16_t count;
+        memcpy(&count, keyscards + 4 * i + 2, sizeof(uint16_t));
+        if (portable_is_run(run_flags, i)) {
+            if (length - data_pos < sizeof(uint16_t)) {
+                return NULL;
+            }
+            uint16_t n_runs;
+            memcpy(&n_runs, buf + data_pos, sizeof(uint16_t));
+            data_pos += sizeof(uint16_t);
+            size_t num_bytes = n_runs * sizeof(rle16_t);
+            if (length - data_pos < num_bytes) {
+                return NULL;
+            }
+            if ((uintptr_t)(buf + data_pos) % sizeof(uint16_t) != 0) {
+                small_copy_size += num_bytes;
+            }
+            data_pos += num_bytes;
+            num_run_containers++;
+        } else if (count + UINT32_C(1) > DEFAULT_MAX_SIZE) {
+            size_t num_bytes =
+                    BITSET_CONTAINER_SIZE_IN_WORDS * sizeof(uint64_t);
+            if (length - data_pos < num_bytes) {
                 return NULL;
+            }
+            if ((uintptr_t)(buf + data_pos) % 32 != 0) {
+                bitset_copy_size += num_bytes;
+            }
+            data_pos += num_bytes;
+            num_bitset_containers++;
+        } else {
+            size_t num_bytes = (count + UINT32_C(1)) * sizeof(uint16_t);
+            if (length - data_pos < num_bytes) {
+                return NULL;
+            }
+            if ((uintptr_t)(buf + data_pos) % sizeof(uint16_t) != 0) {
+                small_copy_size += num_bytes;
+            }
+            data_pos += num_bytes;
+            num_array_containers++;
+        }
+    }
+
+    size_t alloc_size = 0;
+    alloc_size += sizeof(roaring_bitmap_t);
+    alloc_size += num_containers * sizeof(container_t*);
+    alloc_size += num_bitset_containers * sizeof(bitset_container_t);
+    alloc_size += num_run_containers * sizeof(run_container_t);
+    alloc_size += num_array_containers * sizeof(array_container_t);
+    alloc_size += num_containers * sizeof(uint16_t);
+    alloc_size += num_containers * sizeof(uint8_t);
+    if (bitset_copy_size + small_copy_size > 0) {
+        alloc_size += 31 + bitset_copy_size + small_copy_size;
+    }
+
+    char *arena = (char *)roaring_malloc(alloc_size);
+    if (arena == NULL) {
+        return NULL;
+    }
+
+    roaring_bitmap_t *rb = (roaring_bitmap_t *)
+            arena_alloc(&arena, sizeof(roaring_bitmap_t));
+    roaring_array_t *ra = &rb->high_low_container;
+    ra->flags = ROARING_FLAG_FROZEN;
+    ra->allocation_size = num_containers;
+    ra->size = num_containers;
+    ra->containers = (container_t **)arena_alloc(
+            &arena, sizeof(container_t*) * num_containers);
+    char *struct_zone = (char *)arena_alloc(&arena,
+            num_bitset_containers * sizeof(bitset_container_t) +
+            num_run_containers * sizeof(run_container_t) +
+            num_array_containers * sizeof(array_container_t));
+    ra->keys = (uint16_t *)arena_alloc(&arena,
+                                       num_containers * sizeof(uint16_t));
+    ra->typecodes = (uint8_t *)arena_alloc(&arena,
+                                           num_containers * sizeof(uint8_t));
+    // bitset copies first, so that only their zone needs aligning
+    char *bitset_copy_zone = arena + (32 - (uintptr_t)arena % 32) % 32;
+    char *small_copy_zone = bitset_copy_zone + bitset_copy_size;
+
+    data_pos = pos;
+    for (int32_t i = 0; i < num_containers; i++) {
+        uint16_t count;
+        memcpy(&ra->keys[i], keyscards + 4 * i, sizeof(uint16_t));
+        memcpy(&count, keyscards + 4 * i + 2, sizeof(uint16_t));
+        const char *data = buf + data_pos;
+        if (portable_is_run(run_flags, i)) {
+            uint16_t n_runs;
+            memcpy(&n_runs, data, sizeof(uint16_t));
+            data += sizeof(uint16_t);
+            size_t num_bytes = n_runs * sizeof(rle16_t);
+            data_pos += sizeof(uint16_t) + num_bytes;
+            if ((uintptr_t)data % sizeof(uint16_t) != 0) {
+                data = (const char *)memcpy(small_copy_zone, data, num_bytes);
+                small_copy_zone += num_bytes;
+            }
+            run_container_t *run = (run_container_t *)
+                    arena_alloc(&struct_zone, sizeof(run_container_t));
+            run->capacity = n_runs;
+            run->n_runs = n_runs;
+            run->runs = (rle16_t *)data;
+            ra->containers[i] = run;
+            ra->typecodes[i] = RUN_CONTAINER_TYPE;
+        } else if (count + UINT32_C(1) > DEFAULT_MAX_SIZE) {
+            size_t num_bytes =
+                    BITSET_CONTAINER_SIZE_IN_WORDS * sizeof(uint64_t);
+            data_pos += num_bytes;
+            if ((uintptr_t)data % 32 != 0) {
+                data = (const char *)memcpy(bitset_copy_zone, data, num_bytes);
+                bitset_copy_zone += num_bytes;
+            }
+            bitset_container_t *bitset = (bitset_container_t *)
+                    arena_alloc(&struct_zone, sizeof(bitset_container_t));
+            bitset->words = (uint64_t *)data;
+            bitset->cardinality = count + UINT32_C(1);
+            ra->containers[i] = bitset;
+            ra->typecodes[i] = BITSET_CONTAINER_TYPE;
+        } else {
+            size_t num_bytes = (count + UINT32_C(1)) * sizeof(uint16_t);
+            data_pos += num_bytes;
+            if ((uintptr_t)data % sizeof(uint16_t) != 0) {
+                data = (const char *)memcpy(small_copy_zone, data, num_bytes);
+                small_copy_zone += num_bytes;
+            }
+            array_container_t *array = (array_container_t *)
+                    arena_alloc(&struct_zone, sizeof(array_container_t));
+            array->capacity = count + UINT32_C(1);
+            array->cardinality = count + UINT32_C(1);
+            array->array = (uint16_t *)data;
+            ra->containers[i] = array;
+            ra->typecodes[i] = ARRAY_CONTAINER_TYPE;
         }
     }
 
@@ -0,0 +1,861 @@
+#include <assert.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <roaring/roaring64.h>
+#include <roaring/roaring_array.h>
+#include <roaring/art/art.h>
+
+#include <roaring/containers/containers.h>
+
+#ifdef __cplusplus
+using namespace ::roaring::internal;
+
+extern "C" { namespace roaring { namespace api {
+#endif
+
+/*
+ * The 48 high bits of each value select a container holding its 16 low bits.
+ * The containers are the leaves of an adaptive radix tree keyed by these 48
+ * bits (see art.h): a lookup reads at most six nodes, and adding or removing
+ * a container changes at most two of them, so that sparse or random values
+ * are inserted as cheaply as clustered ones. Unlike roaring_bitmap_t, there
+ * is no copy-on-write, so no container is ever shared.
+ */
+typedef struct r64_leaf_s {
+    art_val_t art_val;  // the 48 high bits, must come first
+    uint8_t typecode;
+    container_t *container;
+} r64_leaf_t;
+
+struct roaring64_bitmap_s {
+    art_t art;
+};
+
+static inline uint64_t high48(uint64_t x) { return x >> 16; }
+static inline uint16_t low16(uint64_t x) { return (uint16_t)x; }
+
+// the key in the tree is the big-endian encoding of the 48 high bits
+static inline void r64_split_key(uint64_t key, art_key_chunk_t *out) {
+    for (int i = ART_KEY_BYTES - 1; i >= 0; i--) {
+        out[i] = (art_key_chunk_t)key;
+        key >>= 8;
+    }
+}
+
+static inline uint64_t r64_leaf_key(const r64_leaf_t *leaf) {
+    uint64_t key = 0;
+    for (int i = 0; i < ART_KEY_BYTES; i++) {
+        key = (key << 8) | leaf->art_val.key[i];
+    }
+    return key;
+}
+
+static inline r64_leaf_t *r64_find(const roaring64_bitmap_t *r,
+                                   uint64_t key) {
+    art_key_chunk_t art_key[ART_KEY_BYTES];
+    r64_split_key(key, art_key);
+    return (r64_leaf_t *)art_find(&r->art, art_key);
+}
+
+// the leaf of r with the same key as leaf, if any
+static inline r64_leaf_t *r64_find_same(const roaring64_bitmap_t *r,
+                                        const r64_leaf_t *leaf) {
+    return (r64_leaf_t *)art_find(&r->art, leaf->art_val.key);
+}
+
+/*
+ * Adds the container c under key, which must be absent, and returns its
+ * leaf. Returns NULL in case of failure (including c == NULL, so that a
+ * failed container allocation can be passed on), after freeing c.
+ */
+static r64_leaf_t *r64_insert(roaring64_bitmap_t *r,
+                              const art_key_chunk_t *key, container_t *c,
+                              uint8_t typecode) {
+    if (c == NULL) return NULL;
+    r64_leaf_t *leaf = (r64_leaf_t *)roaring_malloc(sizeof(r64_leaf_t));
+    if (leaf != NULL) {
+        leaf->typecode = typecode;
+        leaf->container = c;
+        if (art_insert(&r->art, key, &leaf->art_val)) return leaf;
+        roaring_free(leaf);
+    }
+    container_free(c, typecode);
+    return NULL;
+}
+
+// removes the leaf from r and frees it, but not its container
+static void r64_erase(roaring64_bitmap_t *r, r64_leaf_t *leaf) {
+    art_erase(&r->art, leaf->art_val.key);
+    roaring_free(leaf);
+}
+
+// replaces the container of leaf, freeing the previous one if it differs
+static inline void r64_replace_container(r64_leaf_t *leaf, container_t *c,
+                                         uint8_t typecode) {
+    if (c != leaf->container) {
+        container_free(leaf->container, leaf->typecode);
+        leaf->container = c;
+    }
+    leaf->typecode = typecode;
+}
+
+roaring64_bitmap_t *roaring64_bitmap_create(void) {
+    roaring64_bitmap_t *r =
+        (roaring64_bitmap_t *)roaring_malloc(sizeof(roaring64_bitmap_t));
+    if (!r) return NULL;
+    art_init(&r->art);
+    return r;
+}
+
+void roaring64_bitmap_free(roaring64_bitmap_t *r) {
+    if (!r) return;
+    art_iterator_t it = art_init_iterator(&r->art, true);
+    while (it.value != NULL) {
+        r64_leaf_t *leaf = (r64_leaf_t *)it.value;
+        art_iterator_next(&it);  // does not read the leaf it leaves
+        container_free(leaf->container, leaf->typecode);
+        roaring_free(leaf);
+    }
+    art_free(&r->art);
+    roaring_free(r);
+}
+
+roaring64_bitmap_t *roaring64_bitmap_copy(const roaring64_bitmap_t *r) {
+    roaring64_bitmap_t *ans = roaring64_bitmap_create();
+    if (!ans) return NULL;
+    for (art_iterator_t it = art_init_iterator(&r->art, true);
+         it.value != NULL; art_iterator_next(&it)) {
+        const r64_leaf_t *leaf = (const r64_leaf_t *)it.value;
+        if (r64_insert(ans, leaf->art_val.key,
+                       container_clone(leaf->container, leaf->typecode),
+                       leaf->typecode) == NULL) {
+            roaring64_bitmap_free(ans);
+            return NULL;
+        }
+    }
+    return ans;
+}
+
+roaring64_bitmap_t *roaring64_bitmap_of_ptr(size_t n_args,
+                                            const uint64_t *vals) {
+    roaring64_bitmap_t *r = roaring64_bitmap_create();
+    if (!r) return NULL;
+    roaring64_bitmap_add_many(r, n_args, vals);
+    return r;
+}
+
+/*
+ * Adds val to the container of leaf, or to a new container if leaf is
+ * NULL, and returns the leaf of the container, or NULL in case of failure.
+ */
+static r64_leaf_t *r64_add_to_leaf(roaring64_bitmap_t *r, r64_leaf_t *leaf,
+                                   uint64_t val) {
+    uint8_t typecode;
+    if (leaf != NULL) {
+        container_t *c = container_add(leaf->container, low16(val),
+                                       leaf->typecode, &typecode);
+        r64_replace_container(leaf, c, typecode);
+        return leaf;
+    }
+    array_container_t *ac = array_container_create();
+    if (ac == NULL) return NULL;
+    container_t *c = container_add(ac, low16(val), ARRAY_CONTAINER_TYPE,
+                                   &typecode);
+    art_key_chunk_t key[ART_KEY_BYTES];
+    r64_split_key(high48(val), key);
+    return r64_insert(r, key, c, typecode);
+}
+
+void roaring64_bitmap_add(roaring64_bitmap_t *r, uint64_t val) {
+    r64_add_to_leaf(r, r64_find(r, high48(val)), val);
+}
+
+bool roaring64_bitmap_add_checked(roaring64_bitmap_t *r, uint64_t val) {
+    r64_leaf_t *leaf = r64_find(r, high48(val));
+    if (leaf == NULL) {
+        return r64_add_to_leaf(r, NULL, val) != NULL;
+    }
+    const int oldcardinality =
+        container_get_cardinality(leaf->container, leaf->typecode);
+    r64_add_to_leaf(r, leaf, val);
+    return container_get_cardinality(leaf->container, leaf->typecode) !=
+           oldcardinality;
+}
+
+void roaring64_bitmap_add_many(roaring64_bitmap_t *r, size_t n_args,
+                               const uint64_t *vals) {
+    r64_leaf_t *leaf = NULL;
+    uint64_t prev_key = 0;
+    for (size_t k = 0; k < n_args; k++) {
+        const uint64_t key = high48(vals[k]);
+        if (leaf == NULL || key != prev_key) {
+            leaf = r64_find(r, key);
+            prev_key = key;
+        }
+        // otherwise, the container is already known
+        leaf = r64_add_to_leaf(r, leaf, vals[k]);
+    }
+}
+
+void roaring64_bitmap_add_range_closed(roaring64_bitmap_t *r, uint64_t min,
+                                       uint64_t max) {
+    if (min > max) {
+        return;
+    }
+
+    const uint64_t min_key = high48(min);
+    const uint64_t max_key = high48(max);
+    for (uint64_t key = min_key;; key++) {
+        uint32_t container_min = (min_key == key) ? low16(min) : 0;
+        uint32_t container_max = (max_key == key) ? low16(max) : 0xffff;
+        uint8_t new_type;
+        r64_leaf_t *leaf = r64_find(r, key);
+        if (leaf != NULL) {
+            container_t *c = container_add_range(leaf->container,
+                                                 leaf->typecode,
+                                                 container_min, container_max,
+                                                 &new_type);
+            r64_replace_container(leaf, c, new_type);
+        } else {
+            container_t *c = container_from_range(&new_type, container_min,
+                                                  container_max + 1, 1);
+            art_key_chunk_t art_key[ART_KEY_BYTES];
+            r64_split_key(key, art_key);
+            if (r64_insert(r, art_key, c, new_type) == NULL) {
+                return;  // out of memory: the range is only partly added
+            }
+        }
+        if (key == max_key) break;
+    }
+}
+
+static inline void r64_remove_from_leaf(roaring64_bitmap_t *r,
+                                        r64_leaf_t *leaf, uint64_t val) {
+    uint8_t typecode;
+    container_t *c = container_remove(leaf->container, low16(val),
+                                      leaf->typecode, &typecode);
+    r64_replace_container(leaf, c, typecode);
+    if (!container_nonzero_cardinality(c, typecode)) {
+        container_free(c, typecode);
+        r64_erase(r, leaf);
+    }
+}
+
+void roaring64_bitmap_remove(roaring64_bitmap_t *r, uint64_t val) {
+    r64_leaf_t *leaf = r64_find(r, high48(val));
+    if (leaf != NULL) {
+        r64_remove_from_leaf(r, leaf, val);
+    }
+}
+
+bool roaring64_bitmap_remove_checked(roaring64_bitmap_t *r, uint64_t val) {
+    r64_leaf_t *leaf = r64_find(r, high48(val));
+    if (leaf == NULL) return false;
+    if (!container_contains(leaf->container, low16(val), leaf->typecode)) {
+        return false;
+    }
+    r64_remove_from_leaf(r, leaf, val);
+    return true;
+}
+
+void roaring64_bitmap_remove_range_closed(roaring64_bitmap_t *r, uint64_t min,
+                                          uint64_t max) {
+    if (min > max) {
+        return;
+    }
+
+    const uint64_t min_key = high48(min);
+    const uint64_t max_key = high48(max);
+
+    art_key_chunk_t art_key[ART_KEY_BYTES];
+    r64_split_key(min_key, art_key);
+    art_iterator_t it = art_lower_bound(&r->art, art_key);
+    while (it.value != NULL) {
+        r64_leaf_t *leaf = (r64_leaf_t *)it.value;
+        const uint64_t key = r64_leaf_key(leaf);
+        if (key > max_key) break;
+        uint32_t container_min = (min_key == key) ? low16(min) : 0;
+        uint32_t container_max = (max_key == key) ? low16(max) : 0xffff;
+        uint8_t new_type;
+        container_t *new_container = container_remove_range(
+            leaf->container, leaf->typecode, container_min, container_max,
+            &new_type);
+        if (new_container != leaf->container) {
+            container_free(leaf->container, leaf->typecode);
+        }
+        if (new_container) {
+            leaf->container = new_container;
+            leaf->typecode = new_type;
+            art_iterator_next(&it);
+        } else {
+            art_iterator_erase(&r->art, &it);
+            roaring_free(leaf);
+        }
+    }
+}
+
+bool roaring64_bitmap_contains(const roaring64_bitmap_t *r, uint64_t val) {
+    const r64_leaf_t *leaf = r64_find(r, high48(val));
+    return leaf != NULL &&
+           container_contains(leaf->container, low16(val), leaf->typecode);
+}
+
+uint64_t roaring64_bitmap_get_cardinality(const roaring64_bitmap_t *r) {
+    uint64_t card = 0;
+    for (art_iterator_t it = art_init_iterator(&r->art, true);
+         it.value != NULL; art_iterator_next(&it)) {
+        const r64_leaf_t *leaf = (const r64_leaf_t *)it.value;
+        card += container_get_cardinality(leaf->container, leaf->typecode);
+    }
+    return card;
+}
+
+bool roaring64_bitmap_is_empty(const roaring64_bitmap_t *r) {
+    return art_is_empty(&r->art);
+}
+
+uint64_t roaring64_bitmap_minimum(const roaring64_bitmap_t *r) {
+    art_iterator_t it = art_init_iterator(&r->art, true);
+    if (it.value == NULL) return UINT64_MAX;
+    const r64_leaf_t *leaf = (const r64_leaf_t *)it.value;
+    return (r64_leaf_key(leaf) << 16) |
+           container_minimum(leaf->container, leaf->typecode);
+}
+
+uint64_t roaring64_bitmap_maximum(const roaring64_bitmap_t *r) {
+    art_iterator_t it = art_init_iterator(&r->art, false);
+    if (it.value == NULL) return 0;
+    const r64_leaf_t *leaf = (const r64_leaf_t *)it.value;
+    return (r64_leaf_key(leaf) << 16) |
+           container_maximum(leaf->container, leaf->typecode);
+}
+
+uint64_t roaring64_bitmap_rank(const roaring64_bitmap_t *r, uint64_t x) {
+    uint64_t size = 0;
+    const uint64_t xhigh = high48(x);
+    for (art_iterator_t it = art_init_iterator(&r->art, true);
+         it.value != NULL; art_iterator_next(&it)) {
+        const r64_leaf_t *leaf = (const r64_leaf_t *)it.value;
+        const uint64_t key = r64_leaf_key(leaf);
+        if (xhigh > key) {
+            size += container_get_cardinality(leaf->container,
+                                              leaf->typecode);
+        } else if (xhigh == key) {
+            return size + container_rank(leaf->container, leaf->typecode,
+                                         low16(x));
+        } else {
+            return size;
+        }
+    }
+    return size;
+}
+
+bool roaring64_bitmap_select(const roaring64_bitmap_t *r, uint64_t rank,
+                             uint64_t *element) {
+    for (art_iterator_t it = art_init_iterator(&r->art, true);
+         it.value != NULL; art_iterator_next(&it)) {
+        const r64_leaf_t *leaf = (const r64_leaf_t *)it.value;
+        const uint64_t card =
+            container_get_cardinality(leaf->container, leaf->typecode);
+        if (rank < card) {
+            uint32_t start_rank = 0;
+            uint32_t low;
+            bool found = container_select(leaf->container, leaf->typecode,
+                                          &start_rank, (uint32_t)rank, &low);
+            assert(found);
+            (void)found;
+            *element = (r64_leaf_key(leaf) << 16) | low;
+            return true;
+        }
+        rank -= card;
+    }
+    return false;
+}
+
+bool roaring64_bitmap_run_optimize(roaring64_bitmap_t *r) {
+    bool answer = false;
+    for (art_iterator_t it = art_init_iterator(&r->art, true);
+         it.value != NULL; art_iterator_next(&it)) {
+        r64_leaf_t *leaf = (r64_leaf_t *)it.value;
+        uint8_t type_after;
+        container_t *c = convert_run_optimize(leaf->container,
+                                              leaf->typecode, &type_after);
+        if (type_after == RUN_CONTAINER_TYPE) {
+            answer = true;
+        }
+        leaf->container = c;
+        leaf->typecode = type_after;
+    }
+    return answer;
+}
+
+bool roaring64_bitmap_equals(const roaring64_bitmap_t *r1,
+                             const roaring64_bitmap_t *r2) {
+    art_iterator_t it1 = art_init_iterator(&r1->art, true);
+    art_iterator_t it2 = art_init_iterator(&r2->art, true);
+    while (it1.value != NULL && it2.value != NULL) {
+        const r64_leaf_t *leaf1 = (const r64_leaf_t *)it1.value;
+        const r64_leaf_t *leaf2 = (const r64_leaf_t *)it2.value;
+        if (memcmp(leaf1->art_val.key, leaf2->art_val.key, ART_KEY_BYTES) !=
+                0 ||
+            !container_equals(leaf1->container, leaf1->typecode,
+                              leaf2->container, leaf2->typecode)) {
+            return false;
+        }
+        art_iterator_next(&it1);
+        art_iterator_next(&it2);
+    }
+    return it1.value == NULL && it2.value == NULL;
+}
+
+bool roaring64_bitmap_is_subset(const roaring64_bitmap_t *r1,
+                                const roaring64_bitmap_t *r2) {
+    for (art_iterator_t it = art_init_iterator(&r1->art, true);
+         it.value != NULL; art_iterator_next(&it)) {
+        const r64_leaf_t *leaf1 = (const r64_leaf_t *)it.value;
+        const r64_leaf_t *leaf2 = r64_find_same(r2, leaf1);
+        if (leaf2 == NULL ||
+            !container_is_subset(leaf1->container, leaf1->typecode,
+                                 leaf2->container, leaf2->typecode)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool roaring64_bitmap_intersect(const roaring64_bitmap_t *r1,
+                                const roaring64_bitmap_t *r2) {
+    for (art_iterator_t it = art_init_iterator(&r1->art, true);
+         it.value != NULL; art_iterator_next(&it)) {
+        const r64_leaf_t *leaf1 = (const r64_leaf_t *)it.value;
+        const r64_leaf_t *leaf2 = r64_find_same(r2, leaf1);
+        if (leaf2 != NULL &&
+            container_intersect(leaf1->container, leaf1->typecode,
+                                leaf2->container, leaf2->typecode)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/*
+ * The binary operations visit the containers of one bitmap in order, and
+ * look up those of the other by key, which takes a few node reads.
+ */
+
+roaring64_bitmap_t *roaring64_bitmap_and(const roaring64_bitmap_t *r1,
+                                         const roaring64_bitmap_t *r2) {
+    roaring64_bitmap_t *answer = roaring64_bitmap_create();
+    if (!answer) return NULL;
+    for (art_iterator_t it = art_init_iterator(&r1->art, true);
+         it.value != NULL; art_iterator_next(&it)) {
+        const r64_leaf_t *leaf1 = (const r64_leaf_t *)it.value;
+        const r64_leaf_t *leaf2 = r64_find_same(r2, leaf1);
+        if (leaf2 == NULL) continue;
+        uint8_t result_type;
+        container_t *c = container_and(leaf1->container, leaf1->typecode,
+                                       leaf2->container, leaf2->typecode,
+                                       &result_type);
+        if (!container_nonzero_cardinality(c, result_type)) {
+            container_free(c, result_type);
+        } else if (r64_insert(answer, leaf1->art_val.key, c, result_type) ==
+                   NULL) {
+            roaring64_bitmap_free(answer);
+            return NULL;
+        }
+    }
+    return answer;
+}
+
+uint64_t roaring64_bitmap_and_cardinality(const roaring64_bitmap_t *r1,
+                                          const roaring64_bitmap_t *r2) {
+    uint64_t answer = 0;
+    for (art_iterator_t it = art_init_iterator(&r1->art, true);
+         it.value != NULL; art_iterator_next(&it)) {
+        const r64_leaf_t *leaf1 = (const r64_leaf_t *)it.value;
+        const r64_leaf_t *leaf2 = r64_find_same(r2, leaf1);
+        if (leaf2 != NULL) {
+            answer += container_and_cardinality(
+                leaf1->container, leaf1->typecode, leaf2->container,
+                leaf2->typecode);
+        }
+    }
+    return answer;
+}
+
+void roaring64_bitmap_and_inplace(roaring64_bitmap_t *r1,
+                                  const roaring64_bitmap_t *r2) {
+    if (r1 == r2) return;
+    art_iterator_t it = art_init_iterator(&r1->art, true);
+    while (it.value != NULL) {
+        r64_leaf_t *leaf1 = (r64_leaf_t *)it.value;
+        const r64_leaf_t *leaf2 = r64_find_same(r2, leaf1);
+        if (leaf2 != NULL) {
+            uint8_t result_type;
+            container_t *c = container_iand(leaf1->container, leaf1->typecode,
+                                            leaf2->container, leaf2->typecode,
+                                            &result_type);
+            r64_replace_container(leaf1, c, result_type);
+            if (container_nonzero_cardinality(c, result_type)) {
+                art_iterator_next(&it);
+                continue;
+            }
+        }
+        container_free(leaf1->container, leaf1->typecode);
+        art_iterator_erase(&r1->art, &it);
+        roaring_free(leaf1);
+    }
+}
+
+roaring64_bitmap_t *roaring64_bitmap_or(const roaring64_bitmap_t *r1,
+                                        const roaring64_bitmap_t *r2) {
+    roaring64_bitmap_t *answer = roaring64_bitmap_create();
+    if (!answer) return NULL;
+    for (art_iterator_t it = art_init_iterator(&r1->art, true);
+         it.value != NULL; art_iterator_next(&it)) {
+        const r64_leaf_t *leaf1 = (const r64_leaf_t *)it.value;
+        const r64_leaf_t *leaf2 = r64_find_same(r2, leaf1);
+        uint8_t result_type = leaf1->typecode;
+        container_t *c =
+            (leaf2 == NULL)
+                ? container_clone(leaf1->container, leaf1->typecode)
+                : container_or(leaf1->container, leaf1->typecode,
+                               leaf2->container, leaf2->typecode,
+                               &result_type);
+        if (r64_insert(answer, leaf1->art_val.key, c, result_type) == NULL) {
+            roaring64_bitmap_free(answer);
+            return NULL;
+        }
+    }
+    for (art_iterator_t it = art_init_iterator(&r2->art, true);
+         it.value != NULL; art_iterator_next(&it)) {
+        const r64_leaf_t *leaf2 = (const r64_leaf_t *)it.value;
+        if (r64_find_same(r1, leaf2) != NULL) continue;
+        if (r64_insert(answer, leaf2->art_val.key,
+                       container_clone(leaf2->container, leaf2->typecode),
+                       leaf2->typecode) == NULL) {
+            roaring64_bitmap_free(answer);
+            return NULL;
+        }
+    }
+    return answer;
+}
+
+uint64_t roaring64_bitmap_or_cardinality(const roaring64_bitmap_t *r1,
+                                         const roaring64_bitmap_t *r2) {
+    return roaring64_bitmap_get_cardinality(r1) +
+           roaring64_bitmap_get_cardinality(r2) -
+           roaring64_bitmap_and_cardinality(r1, r2);
+}
+
+void roaring64_bitmap_or_inplace(roaring64_bitmap_t *r1,
+                                 const roaring64_bitmap_t *r2) {
+    if (r1 == r2) return;
+    for (art_iterator_t it = art_init_iterator(&r2->art, true);
+         it.value != NULL; art_iterator_next(&it)) {
+        const r64_leaf_t *leaf2 = (const r64_leaf_t *)it.value;
+        r64_leaf_t *leaf1 = r64_find_same(r1, leaf2);
+        if (leaf1 != NULL) {
+            uint8_t result_type;
+            container_t *c = container_ior(leaf1->container, leaf1->typecode,
+                                           leaf2->container, leaf2->typecode,
+                                           &result_type);
+            r64_replace_container(leaf1, c, result_type);
+        } else if (r64_insert(r1, leaf2->art_val.key,
+                              container_clone(leaf2->container,
+                                              leaf2->typecode),
+                              leaf2->typecode) == NULL) {
+            return;  // out of memory: r1 only holds part of the union
+        }
+    }
+}
+
+roaring64_bitmap_t *roaring64_bitmap_xor(const roaring64_bitmap_t *r1,
+                                         const roaring64_bitmap_t *r2) {
+    roaring64_bitmap_t *answer = roaring64_bitmap_create();
+    if (!answer) return NULL;
+    for (art_iterator_t it = art_init_iterator(&r1->art, true);
+         it.value != NULL; art_iterator_next(&it)) {
+        const r64_leaf_t *leaf1 = (const r64_leaf_t *)it.value;
+        const r64_leaf_t *leaf2 = r64_find_same(r2, leaf1);
+        uint8_t result_type = leaf1->typecode;
+        container_t *c =
+            (leaf2 == NULL)
+                ? container_clone(leaf1->container, leaf1->typecode)
+                : container_xor(leaf1->container, leaf1->typecode,
+                                leaf2->container, leaf2->typecode,
+                                &result_type);
+        if (c != NULL && !container_nonzero_cardinality(c, result_type)) {
+            container_free(c, result_type);
+        } else if (r64_insert(answer, leaf1->art_val.key, c, result_type) ==
+                   NULL) {
+            roaring64_bitmap_free(answer);
+            return NULL;
+        }
+    }
+    for (art_iterator_t it = art_init_iterator(&r2->art, true);
+         it.value != NULL; art_iterator_next(&it)) {
+        const r64_leaf_t *leaf2 = (const r64_leaf_t *)it.value;
+        if (r64_find_same(r1, leaf2) != NULL) continue;
+        if (r64_insert(answer, leaf2->art_val.key,
+                       container_clone(leaf2->container, leaf2->typecode),
+                       leaf2->typecode) == NULL) {
+            roaring64_bitmap_free(answer);
+            return NULL;
+        }
+    }
+    return answer;
+}
+
+uint64_t roaring64_bitmap_xor_cardinality(const roaring64_bitmap_t *r1,
+                                          const roaring64_bitmap_t *r2) {
+    return roaring64_bitmap_get_cardinality(r1) +
+           roaring64_bitmap_get_cardinality(r2) -
+           2 * roaring64_bitmap_and_cardinality(r1, r2);
+}
+
+void roaring64_bitmap_xor_inplace(roaring64_bitmap_t *r1,
+                                  const roaring64_bitmap_t *r2) {
+    assert(r1 != r2);
+    for (art_iterator_t it = art_init_iterator(&r2->art, true);
+         it.value != NULL; art_iterator_next(&it)) {
+        const r64_leaf_t *leaf2 = (const r64_leaf_t *)it.value;
+        r64_leaf_t *leaf1 = r64_find_same(r1, leaf2);
+        if (leaf1 != NULL) {
+            uint8_t result_type;
+            // container_ixor frees the first container if it creates another
+            container_t *c = container_ixor(leaf1->container, leaf1->typecode,
+                                            leaf2->container, leaf2->typecode,
+                                            &result_type);
+            if (container_nonzero_cardinality(c, result_type)) {
+                leaf1->container = c;
+                leaf1->typecode = result_type;
+            } else {
+                container_free(c, result_type);
+                r64_erase(r1, leaf1);
+            }
+        } else if (r64_insert(r1, leaf2->art_val.key,
+                              container_clone(leaf2->container,
+                                              leaf2->typecode),
+                              leaf2->typecode) == NULL) {
+            return;  // out of memory: r1 is only partly updated
+        }
+    }
+}
+
+roaring64_bitmap_t *roaring64_bitmap_andnot(const roaring64_bitmap_t *r1,
+                                            const roaring64_bitmap_t *r2) {
+    roaring64_bitmap_t *answer = roaring64_bitmap_create();
+    if (!answer) return NULL;
+    for (art_iterator_t it = art_init_iterator(&r1->art, true);
+         it.value != NULL; art_iterator_next(&it)) {
+        const r64_leaf_t *leaf1 = (const r64_leaf_t *)it.value;
+        const r64_leaf_t *leaf2 = r64_find_same(r2, leaf1);
+        uint8_t result_type = leaf1->typecode;
+        container_t *c =
+            (leaf2 == NULL)
+                ? container_clone(leaf1->container, leaf1->typecode)
+                : container_andnot(leaf1->container, leaf1->typecode,
+                                   leaf2->container, leaf2->typecode,
+                                   &result_type);
+        if (c != NULL && !container_nonzero_cardinality(c, result_type)) {
+            container_free(c, result_type);
+        } else if (r64_insert(answer, leaf1->art_val.key, c, result_type) ==
+                   NULL) {
+            roaring64_bitmap_free(answer);
+            return NULL;
+        }
+    }
+    return answer;
+}
+
+uint64_t roaring64_bitmap_andnot_cardinality(const roaring64_bitmap_t *r1,
+                                             const roaring64_bitmap_t *r2) {
+    return roaring64_bitmap_get_cardinality(r1) -
+           roaring64_bitmap_and_cardinality(r1, r2);
+}
+
+void roaring64_bitmap_andnot_inplace(roaring64_bitmap_t *r1,
+                                     const roaring64_bitmap_t *r2) {
+    assert(r1 != r2);
+    art_iterator_t it = art_init_iterator(&r1->art, true);
+    while (it.value != NULL) {
+        r64_leaf_t *leaf1 = (r64_leaf_t *)it.value;
+        const r64_leaf_t *leaf2 = r64_find_same(r2, leaf1);
+        if (leaf2 == NULL) {
+            art_iterator_next(&it);
+            continue;
+        }
+        uint8_t result_type;
+        // container_iandnot frees the first container if it creates another
+        container_t *c = container_iandnot(leaf1->container, leaf1->typecode,
+                                           leaf2->container, leaf2->typecode,
+                                           &result_type);
+        if (container_nonzero_cardinality(c, result_type)) {
+            leaf1->container = c;
+            leaf1->typecode = result_type;
+            art_iterator_next(&it);
+        } else {
+            container_free(c, result_type);
+            art_iterator_erase(&r1->art, &it);
+            roaring_free(leaf1);
+        }
+    }
+}
+
+bool roaring64_bitmap_iterate(const roaring64_bitmap_t *r,
+                              roaring_iterator64 iterator, void *ptr) {
+    for (art_iterator_t it = art_init_iterator(&r->art, true);
+         it.value != NULL; art_iterator_next(&it)) {
+        const r64_leaf_t *leaf = (const r64_leaf_t *)it.value;
+        const uint64_t key = r64_leaf_key(leaf);
+        if (!container_iterate64(leaf->container, leaf->typecode,
+                                 (uint32_t)(key << 16), iterator,
+                                 (key >> 16) << 32, ptr)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool r64_write_value(uint64_t value, void *param) {
+    uint64_t **out = (uint64_t **)param;
+    **out = value;
+    (*out)++;
+    return true;
+}
+
+void roaring64_bitmap_to_uint64_array(const roaring64_bitmap_t *r,
+                                      uint64_t *out) {
+    roaring64_bitmap_iterate(r, r64_write_value, &out);
+}
+
+/*
+ * The portable format groups the containers by the 32 high bits of their
+ * values. Each group is written as a 32-bit bitmap, through a temporary
+ * roaring_array_t that borrows the containers of r. Fills view with the
+ * group of the iterator, sets *bucket to its 32 high bits and moves the
+ * iterator past it. Returns false in case of allocation failure.
+ */
+static bool r64_next_bucket(art_iterator_t *it, roaring_array_t *view,
+                            uint32_t *bucket) {
+    *bucket = (uint32_t)(r64_leaf_key((const r64_leaf_t *)it->value) >> 16);
+    view->size = 0;
+    do {
+        const r64_leaf_t *leaf = (const r64_leaf_t *)it->value;
+        const uint64_t key = r64_leaf_key(leaf);
+        if ((key >> 16) != *bucket) break;
+        if (!extend_array(view, 1)) return false;
+        ra_append(view, (uint16_t)key, leaf->container, leaf->typecode);
+    } while (art_iterator_next(it));
+    return true;
+}
+
+size_t roaring64_bitmap_portable_size_in_bytes(const roaring64_bitmap_t *r) {
+    size_t answer = sizeof(uint64_t);
+    roaring_array_t view;
+    ra_init(&view);
+    art_iterator_t it = art_init_iterator(&r->art, true);
+    while (it.value != NULL) {
+        uint32_t bucket;
+        if (!r64_next_bucket(&it, &view, &bucket)) {
+            answer = 0;
+            break;
+        }
+        answer += sizeof(uint32_t) + ra_portable_size_in_bytes(&view);
+    }
+    ra_clear_without_containers(&view);
+    return answer;
+}
+
+size_t roaring64_bitmap_portable_serialize(const roaring64_bitmap_t *r,
+                                           char *buf) {
+    char *initbuf = buf;
+    uint64_t bucket_count = 0;
+    uint64_t prev_bucket = UINT64_MAX;
+    for (art_iterator_t it = art_init_iterator(&r->art, true);
+         it.value != NULL; art_iterator_next(&it)) {
+        const uint64_t bucket =
+            r64_leaf_key((const r64_leaf_t *)it.value) >> 16;
+        bucket_count += (bucket != prev_bucket);
+        prev_bucket = bucket;
+    }
+    memcpy(buf, &bucket_count, sizeof(uint64_t));
+    buf += sizeof(uint64_t);
+    roaring_array_t view;
+    ra_init(&view);
+    art_iterator_t it = art_init_iterator(&r->art, true);
+    while (it.value != NULL) {
+        uint32_t bucket;
+        if (!r64_next_bucket(&it, &view, &bucket)) {
+            ra_clear_without_containers(&view);
+            return 0;
+        }
+        memcpy(buf, &bucket, sizeof(uint32_t));
+        buf += sizeof(uint32_t);
+        buf += ra_portable_serialize(&view, buf);
+    }
+    ra_clear_without_containers(&view);
+    return buf - initbuf;
+}
+
+roaring64_bitmap_t *roaring64_bitmap_portable_deserialize_safe(
+    const char *buf, size_t maxbytes) {
+    if (maxbytes < sizeof(uint64_t)) {
+        return NULL;
+    }
+    uint64_t bucket_count;
+    memcpy(&bucket_count, buf, sizeof(uint64_t));
+    size_t read_bytes = sizeof(uint64_t);
+
+    roaring64_bitmap_t *r = roaring64_bitmap_create();
+    if (r == NULL) return NULL;
+    int64_t previous_bucket = -1;
+    for (uint64_t b = 0; b < bucket_count; ++b) {
+        if (maxbytes - read_bytes < sizeof(uint32_t)) {
+            roaring64_bitmap_free(r);
+            return NULL;
+        }
+        uint32_t bucket;
+        memcpy(&bucket, buf + read_bytes, sizeof(uint32_t));
+        read_bytes += sizeof(uint32_t);
+        // the buckets must be in increasing order and without duplicates
+        if ((int64_t)bucket <= previous_bucket) {
+            roaring64_bitmap_free(r);
+            return NULL;
+        }
+        previous_bucket = bucket;
+
+        roaring_array_t ra;
+        size_t bucket_bytes;
+        if (!ra_portable_deserialize(&ra, buf + read_bytes,
+                                     maxbytes - read_bytes, &bucket_bytes)) {
+            roaring64_bitmap_free(r);
+            return NULL;
+        }
+        read_bytes += bucket_bytes;
+
+        // move the containers over
+        for (int32_t i = 0; i < ra.size; ++i) {
+            art_key_chunk_t key[ART_KEY_BYTES];
+            r64_split_key(((uint64_t)bucket << 16) | ra.keys[i], key);
+            if (r64_insert(r, key, ra.containers[i], ra.typecodes[i]) ==
+                NULL) {
+                // r64_insert freed the container that failed
+                for (int32_t j = i + 1; j < ra.size; ++j) {
+                    container_free(ra.containers[j], ra.typecodes[j]);
+                }
+                ra_clear_without_containers(&ra);
+                roaring64_bitmap_free(r);
+                return NULL;
+            }
+        }
+        ra_clear_without_containers(&ra);
+    }
+    return r;
+}
+
+#ifdef __cplusplus
+} } }  // extern "C" { namespace roaring { namespace api {
+#endif
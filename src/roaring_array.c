@@ -36,12 +36,12 @@ extern inline void ra_set_container_at_index(
 
 static bool realloc_array(roaring_array_t *ra, int32_t new_capacity) {
     //
-    // Note: not implemented using C's realloc(), because the memory layout is
+    // Note: not implemented using C's roaring_realloc(), because the memory layout is
     // Struct-of-Arrays vs. Array-of-Structs:
     // https://github.com/RoaringBitmap/CRoaring/issues/256
 
     if ( new_capacity == 0 ) {
-      free(ra->containers);
+      roaring_free(ra->containers);
       ra->containers = NULL;
       ra->keys = NULL;
       ra->typecodes = NULL;
@@ -50,7 +50,7 @@ static bool realloc_array(roaring_array_t *ra, int32_t new_capacity) {
     }
     const size_t memoryneeded = new_capacity * (
                 sizeof(uint16_t) + sizeof(container_t *) + sizeof(uint8_t));
-    void *bigalloc = malloc(memoryneeded);
+    void *bigalloc = roaring_malloc(memoryneeded);
     if (!bigalloc) return false;
     void *oldbigalloc = ra->containers;
     container_t **newcontainers = (container_t **)bigalloc;
@@ -67,7 +67,7 @@ static bool realloc_array(roaring_array_t *ra, int32_t new_capacity) {
     ra->keys = newkeys;
     ra->typecodes = newtypecodes;
     ra->allocation_size = new_capacity;
-    free(oldbigalloc);
+    roaring_free(oldbigalloc);
     return true;
 }
 
@@ -78,7 +78,7 @@ bool ra_init_with_capacity(roaring_array_t *new_ra, uint32_t cap) {
     if (cap > INT32_MAX) { return false; }
 
     if(cap > 0) {
-      void *bigalloc = malloc(cap *
+      void *bigalloc = roaring_malloc(cap *
                 (sizeof(uint16_t) + sizeof(container_t *) + sizeof(uint8_t)));
       if( bigalloc == NULL ) return false;
       new_ra->containers = (container_t **)bigalloc;
@@ -167,7 +167,7 @@ void ra_reset(roaring_array_t *ra) {
 }
 
 void ra_clear_without_containers(roaring_array_t *ra) {
-    free(ra->containers);    // keys and typecodes are allocated with containers
+    roaring_free(ra->containers);    // keys and typecodes are allocated with containers
     ra->size = 0;
     ra->allocation_size = 0;
     ra->containers = NULL;
@@ -480,7 +480,7 @@ bool ra_range_uint32_array(const roaring_array_t *ra, size_t offset, size_t limi
                 //first_skip = t_limit - (ctr + t_limit - offset);
                 first_skip = offset - ctr;
                 first = true;
-                t_ans = (uint32_t *)malloc(sizeof(*t_ans) * (first_skip + limit));
+                t_ans = (uint32_t *)roaring_malloc(sizeof(*t_ans) * (first_skip + limit));
                 if(t_ans == NULL) {
                   return false;
                 }
@@ -488,15 +488,15 @@ bool ra_range_uint32_array(const roaring_array_t *ra, size_t offset, size_t limi
                 cur_len = first_skip + limit;
             }
             if (dtr + t_limit > cur_len){
-                uint32_t * append_ans = (uint32_t *)malloc(sizeof(*append_ans) * (cur_len + t_limit));
+                uint32_t * append_ans = (uint32_t *)roaring_malloc(sizeof(*append_ans) * (cur_len + t_limit));
                 if(append_ans == NULL) {
-                  if(t_ans != NULL) free(t_ans);
+                  if(t_ans != NULL) roaring_free(t_ans);
                   return false;
                 }
                 memset(append_ans, 0, sizeof(*append_ans) * (cur_len + t_limit));
                 cur_len = cur_len + t_limit;
                 memcpy(append_ans, t_ans, dtr * sizeof(uint32_t));
-                free(t_ans);
+                roaring_free(t_ans);
                 t_ans = append_ans;
             }
             switch (ra->typecodes[i]) {
@@ -526,7 +526,7 @@ bool ra_range_uint32_array(const roaring_array_t *ra, size_t offset, size_t limi
     }
     if(t_ans != NULL) {
       memcpy(ans, t_ans+first_skip, limit * sizeof(uint32_t));
-      free(t_ans);
+      roaring_free(t_ans);
     }
     return true;
 }
@@ -562,8 +562,8 @@ size_t ra_portable_size_in_bytes(const roaring_array_t *ra) {
     return count;
 }
 
-size_t ra_portable_serialize(const roaring_array_t *ra, char *buf) {
-    char *initbuf = buf;
+// writes everything that precedes the container data, returns the end of it
+static char *ra_portable_write_header(const roaring_array_t *ra, char *buf) {
     uint32_t startOffset = 0;
     bool hasrun = ra_has_run_container(ra);
     if (hasrun) {
@@ -571,7 +571,7 @@ size_t ra_portable_serialize(const roaring_array_t *ra, char *buf) {
         memcpy(buf, &cookie, sizeof(cookie));
         buf += sizeof(cookie);
         uint32_t s = (ra->size + 7) / 8;
-        uint8_t *bitmapOfRunContainers = (uint8_t *)calloc(s, 1);
+        uint8_t *bitmapOfRunContainers = (uint8_t *)roaring_calloc(s, 1);
         assert(bitmapOfRunContainers != NULL);  // todo: handle
         for (int32_t i = 0; i < ra->size; ++i) {
             if (get_container_type(ra->containers[i], ra->typecodes[i]) ==
@@ -581,7 +581,7 @@ size_t ra_portable_serialize(const roaring_array_t *ra, char *buf) {
         }
         memcpy(buf, bitmapOfRunContainers, s);
         buf += s;
-        free(bitmapOfRunContainers);
+        roaring_free(bitmapOfRunContainers);
         if (ra->size < NO_OFFSET_THRESHOLD) {
             startOffset = 4 + 4 * ra->size + s;
         } else {
@@ -617,12 +617,75 @@ size_t ra_portable_serialize(const roaring_array_t *ra, char *buf) {
                 container_size_in_bytes(ra->containers[k], ra->typecodes[k]);
         }
     }
+    return buf;
+}
+
+size_t ra_portable_serialize(const roaring_array_t *ra, char *buf) {
+    char *initbuf = buf;
+    buf = ra_portable_write_header(ra, buf);
     for (int32_t k = 0; k < ra->size; ++k) {
         buf += container_write(ra->containers[k], ra->typecodes[k], buf);
     }
     return buf - initbuf;
 }
 
+size_t ra_portable_serialize_stream(const roaring_array_t *ra,
+                                    roaring_write_function write,
+                                    void *param) {
+    size_t header_size = ra_portable_header_size(ra);
+    char *header = (char *)roaring_malloc(header_size);
+    if (header == NULL) {
+        return 0;
+    }
+    ra_portable_write_header(ra, header);
+    bool is_ok = write(header, header_size, param);
+    roaring_free(header);
+    if (!is_ok) {
+        return 0;
+    }
+    size_t written = header_size;
+    // the container data is handed over where it lives, without copies
+    for (int32_t k = 0; k < ra->size; ++k) {
+        uint8_t typecode = ra->typecodes[k];
+        const container_t *c =
+            container_unwrap_shared(ra->containers[k], &typecode);
+        switch (typecode) {
+            case BITSET_CONTAINER_TYPE: {
+                size_t num_bytes =
+                    BITSET_CONTAINER_SIZE_IN_WORDS * sizeof(uint64_t);
+                is_ok = write((const char *)const_CAST_bitset(c)->words,
+                              num_bytes, param);
+                written += num_bytes;
+                break;
+            }
+            case ARRAY_CONTAINER_TYPE: {
+                const array_container_t *ac = const_CAST_array(c);
+                size_t num_bytes = ac->cardinality * sizeof(uint16_t);
+                is_ok = write((const char *)ac->array, num_bytes, param);
+                written += num_bytes;
+                break;
+            }
+            case RUN_CONTAINER_TYPE: {
+                const run_container_t *rc = const_CAST_run(c);
+                uint16_t n_runs = (uint16_t)rc->n_runs;
+                size_t num_bytes = rc->n_runs * sizeof(rle16_t);
+                is_ok = write((const char *)&n_runs, sizeof(n_runs), param) &&
+                        (num_bytes == 0 ||
+                         write((const char *)rc->runs, num_bytes, param));
+                written += sizeof(n_runs) + num_bytes;
+                break;
+            }
+            default:
+                assert(false);
+                __builtin_unreachable();
+        }
+        if (!is_ok) {
+            return 0;
+        }
+    }
+    return written;
+}
+
 // Quickly checks whether there is a serialized bitmap at the pointer,
 // not exceeding size "maxbytes" in bytes. This function does not allocate
 // memory dynamically.
@@ -878,6 +941,104 @@ bool ra_portable_deserialize(roaring_array_t *answer, const char *buf, const siz
     return true;
 }
 
+bool ra_portable_deserialize_stream(roaring_array_t *answer,
+                                    roaring_read_function read, void *param) {
+    uint32_t cookie;
+    if (!read((char *)&cookie, sizeof(cookie), param)) {
+        return false;
+    }
+    if ((cookie & 0xFFFF) != SERIAL_COOKIE &&
+        cookie != SERIAL_COOKIE_NO_RUNCONTAINER) {
+        return false;
+    }
+    bool hasrun = (cookie & 0xFFFF) == SERIAL_COOKIE;
+    int32_t size;
+    if (hasrun) {
+        size = (cookie >> 16) + 1;
+    } else if (!read((char *)&size, sizeof(size), param)) {
+        return false;
+    }
+    if (size < 0 || size > (1 << 16)) {
+        return false;  // logically impossible
+    }
+
+    // run bitmap, key/cardinality pairs, and offsets, which we skip
+    size_t runs_size = hasrun ? (size + 7) / 8 : 0;
+    size_t header_size = runs_size + 4 * (size_t)size;
+    if ((!hasrun) || (size >= NO_OFFSET_THRESHOLD)) {
+        header_size += 4 * (size_t)size;
+    }
+    char *header = (char *)roaring_malloc(header_size + 1);
+    if (header == NULL) {
+        return false;
+    }
+    if (!read(header, header_size, param) ||
+        !ra_init_with_capacity(answer, size)) {
+        roaring_free(header);
+        return false;
+    }
+    const char *bitmapOfRunContainers = header;
+    const char *keyscards = header + runs_size;
+
+    // each container is read straight into its own storage
+    for (int32_t k = 0; k < size; ++k) {
+        uint16_t key, tmp;
+        memcpy(&key, keyscards + 4 * k, sizeof(key));
+        memcpy(&tmp, keyscards + 4 * k + 2, sizeof(tmp));
+        uint32_t thiscard = tmp + 1;
+        bool isrun = hasrun &&
+                     (bitmapOfRunContainers[k / 8] & (1 << (k % 8))) != 0;
+        container_t *c = NULL;
+        uint8_t typecode;
+        bool is_ok = false;
+        if (isrun) {
+            uint16_t n_runs;
+            if (read((char *)&n_runs, sizeof(n_runs), param)) {
+                run_container_t *rc =
+                    run_container_create_given_capacity(n_runs);
+                if (rc != NULL) {
+                    rc->n_runs = n_runs;
+                    is_ok = n_runs == 0 ||
+                            read((char *)rc->runs,
+                                 n_runs * sizeof(rle16_t), param);
+                }
+                c = rc;
+            }
+            typecode = RUN_CONTAINER_TYPE;
+        } else if (thiscard > DEFAULT_MAX_SIZE) {
+            bitset_container_t *bc = bitset_container_create();
+            if (bc != NULL) {
+                bc->cardinality = thiscard;
+                is_ok = read((char *)bc->words,
+                             BITSET_CONTAINER_SIZE_IN_WORDS * sizeof(uint64_t),
+                             param);
+            }
+            c = bc;
+            typecode = BITSET_CONTAINER_TYPE;
+        } else {
+            array_container_t *ac =
+                array_container_create_given_capacity(thiscard);
+            if (ac != NULL) {
+                ac->cardinality = thiscard;
+                is_ok = read((char *)ac->array, thiscard * sizeof(uint16_t),
+                             param);
+            }
+            c = ac;
+            typecode = ARRAY_CONTAINER_TYPE;
+        }
+        if (c != NULL) {
+            ra_append(answer, key, c, typecode);
+        }
+        if (!is_ok) {
+            roaring_free(header);
+            ra_clear(answer);
+            return false;
+        }
+    }
+    roaring_free(header);
+    return true;
+}
+
 #ifdef __cplusplus
 } } }  // extern "C" { namespace roaring { namespace internal {
 #endif
@@ -0,0 +1,295 @@
+#include <stdint.h>
+#include <string.h>
+
+#include <roaring/roaring_bsi.h>
+
+#ifdef __cplusplus
+extern "C" { namespace roaring { namespace api {
+#endif
+
+/*
+ * slices[i] holds the rows whose value has bit i set. Only the slices up to
+ * the highest bit of any value are allocated: a value with a higher bit set
+ * is greater than all the stored values. Every slice is a subset of the
+ * existence bitmap.
+ */
+struct roaring_bsi_s {
+    roaring_bitmap_t *existence;
+    uint32_t bit_count;  // slices[bit_count..63] are NULL
+    roaring_bitmap_t *slices[64];
+};
+
+roaring_bsi_t *roaring_bsi_create(void) {
+    roaring_bsi_t *bsi = (roaring_bsi_t *)roaring_malloc(sizeof(roaring_bsi_t));
+    if (bsi == NULL) return NULL;
+    bsi->existence = roaring_bitmap_create();
+    if (bsi->existence == NULL) {
+        roaring_free(bsi);
+        return NULL;
+    }
+    bsi->bit_count = 0;
+    memset(bsi->slices, 0, sizeof(bsi->slices));
+    return bsi;
+}
+
+void roaring_bsi_free(roaring_bsi_t *bsi) {
+    if (bsi == NULL) return;
+    for (uint32_t i = 0; i < bsi->bit_count; i++) {
+        roaring_bitmap_free(bsi->slices[i]);
+    }
+    roaring_bitmap_free(bsi->existence);
+    roaring_free(bsi);
+}
+
+bool roaring_bsi_set_many(roaring_bsi_t *bsi, size_t n, const uint32_t *rows,
+                          const uint64_t *values) {
+    if (n == 0) return true;
+    uint64_t all_bits = 0;
+    for (size_t i = 0; i < n; i++) {
+        all_bits |= values[i];
+    }
+    uint32_t bits = 0;
+    while (bits < 64 && (all_bits >> bits) != 0) bits++;
+
+    // allocate everything first, so that a failure leaves the index as it was
+    uint32_t *buffer = (uint32_t *)roaring_malloc(n * sizeof(uint32_t));
+    roaring_bitmap_t *updated = roaring_bitmap_of_ptr(n, rows);
+    uint32_t bit_count = bsi->bit_count;
+    while (bit_count < bits &&
+           (bsi->slices[bit_count] = roaring_bitmap_create()) != NULL) {
+        bit_count++;
+    }
+    if (buffer == NULL || updated == NULL || bit_count < bits) {
+        while (bit_count > bsi->bit_count) {
+            roaring_bitmap_free(bsi->slices[--bit_count]);
+            bsi->slices[bit_count] = NULL;
+        }
+        if (updated != NULL) roaring_bitmap_free(updated);
+        roaring_free(buffer);
+        return false;
+    }
+
+    if (roaring_bitmap_intersect(bsi->existence, updated)) {
+        for (uint32_t j = 0; j < bsi->bit_count; j++) {  // clear old values
+            roaring_bitmap_andnot_inplace(bsi->slices[j], updated);
+        }
+    }
+    roaring_bitmap_or_inplace(bsi->existence, updated);
+    bsi->bit_count = bit_count;
+    for (uint32_t j = 0; j < bits; j++) {
+        size_t m = 0;
+        for (size_t i = 0; i < n; i++) {  // branchless gathering
+            buffer[m] = rows[i];
+            m += (values[i] >> j) & 1;
+        }
+        roaring_bitmap_add_many(bsi->slices[j], m, buffer);
+    }
+    roaring_bitmap_free(updated);
+    roaring_free(buffer);
+    return true;
+}
+
+bool roaring_bsi_get(const roaring_bsi_t *bsi, uint32_t row, uint64_t *value) {
+    if (!roaring_bitmap_contains(bsi->existence, row)) return false;
+    uint64_t v = 0;
+    for (uint32_t i = 0; i < bsi->bit_count; i++) {
+        if (roaring_bitmap_contains(bsi->slices[i], row)) {
+            v |= UINT64_C(1) << i;
+        }
+    }
+    *value = v;
+    return true;
+}
+
+uint64_t roaring_bsi_get_cardinality(const roaring_bsi_t *bsi) {
+    return roaring_bitmap_get_cardinality(bsi->existence);
+}
+
+// the rows of filter that have a value
+static roaring_bitmap_t *bsi_candidates(const roaring_bsi_t *bsi,
+                                        const roaring_bitmap_t *filter) {
+    if (filter == NULL) return roaring_bitmap_copy(bsi->existence);
+    return roaring_bitmap_and(bsi->existence, filter);
+}
+
+roaring_bitmap_t *roaring_bsi_compare(const roaring_bsi_t *bsi, uint8_t op,
+                                      uint64_t value,
+                                      const roaring_bitmap_t *filter) {
+    if (op > ROARING_BSI_GE) return NULL;
+    const bool need_lt =
+        (op == ROARING_BSI_NEQ || op == ROARING_BSI_LT || op == ROARING_BSI_LE);
+    const bool need_gt =
+        (op == ROARING_BSI_NEQ || op == ROARING_BSI_GT || op == ROARING_BSI_GE);
+    // O'Neil: from the top bit down, the rows still equal to value so far
+    // become smaller or greater where their bit differs from that of value
+    roaring_bitmap_t *eq = bsi_candidates(bsi, filter);
+    roaring_bitmap_t *lt = roaring_bitmap_create();
+    roaring_bitmap_t *gt = roaring_bitmap_create();
+    if (bsi->bit_count < 64 && (value >> bsi->bit_count) != 0) {
+        roaring_bitmap_t *tmp = lt;  // every value is smaller
+        lt = eq;
+        eq = tmp;
+    }
+    for (uint32_t i = bsi->bit_count;
+         i-- > 0 && !roaring_bitmap_is_empty(eq);) {
+        const roaring_bitmap_t *slice = bsi->slices[i];
+        if ((value >> i) & 1) {
+            if (need_lt) {
+                roaring_bitmap_t *tmp = roaring_bitmap_andnot(eq, slice);
+                roaring_bitmap_or_inplace(lt, tmp);
+                roaring_bitmap_free(tmp);
+            }
+            roaring_bitmap_and_inplace(eq, slice);
+        } else {
+            if (need_gt) {
+                roaring_bitmap_t *tmp = roaring_bitmap_and(eq, slice);
+                roaring_bitmap_or_inplace(gt, tmp);
+                roaring_bitmap_free(tmp);
+            }
+            roaring_bitmap_andnot_inplace(eq, slice);
+        }
+    }
+
+    roaring_bitmap_t *answer;
+    switch (op) {
+        case ROARING_BSI_EQ:
+            answer = eq;
+            eq = NULL;
+            break;
+        case ROARING_BSI_NEQ:
+            roaring_bitmap_or_inplace(lt, gt);
+            answer = lt;
+            lt = NULL;
+            break;
+        case ROARING_BSI_LT:
+            answer = lt;
+            lt = NULL;
+            break;
+        case ROARING_BSI_LE:
+            roaring_bitmap_or_inplace(lt, eq);
+            answer = lt;
+            lt = NULL;
+            break;
+        case ROARING_BSI_GT:
+            answer = gt;
+            gt = NULL;
+            break;
+        default:  // ROARING_BSI_GE
+            roaring_bitmap_or_inplace(gt, eq);
+            answer = gt;
+            gt = NULL;
+            break;
+    }
+    if (eq != NULL) roaring_bitmap_free(eq);
+    if (lt != NULL) roaring_bitmap_free(lt);
+    if (gt != NULL) roaring_bitmap_free(gt);
+    return answer;
+}
+
+roaring_bitmap_t *roaring_bsi_range(const roaring_bsi_t *bsi, uint64_t min,
+                                    uint64_t max,
+                                    const roaring_bitmap_t *filter) {
+    if (min > max) return roaring_bitmap_create();
+    // the second comparison only looks at the rows that passed the first
+    roaring_bitmap_t *ge =
+        roaring_bsi_compare(bsi, ROARING_BSI_GE, min, filter);
+    roaring_bitmap_t *answer =
+        roaring_bsi_compare(bsi, ROARING_BSI_LE, max, ge);
+    roaring_bitmap_free(ge);
+    return answer;
+}
+
+uint64_t roaring_bsi_sum(const roaring_bsi_t *bsi,
+                         const roaring_bitmap_t *filter, uint64_t *count) {
+    uint64_t sum = 0;
+    for (uint32_t i = 0; i < bsi->bit_count; i++) {
+        const uint64_t ones =
+            (filter == NULL)
+                ? roaring_bitmap_get_cardinality(bsi->slices[i])
+                : roaring_bitmap_and_cardinality(bsi->slices[i], filter);
+        sum += ones << i;
+    }
+    if (count != NULL) {
+        *count = (filter == NULL)
+                     ? roaring_bitmap_get_cardinality(bsi->existence)
+                     : roaring_bitmap_and_cardinality(bsi->existence, filter);
+    }
+    return sum;
+}
+
+// from the top bit down, keeps the rows having the wanted bit if any does
+static bool bsi_extremum(const roaring_bsi_t *bsi,
+                         const roaring_bitmap_t *filter, bool greatest,
+                         uint64_t *value) {
+    roaring_bitmap_t *rows = bsi_candidates(bsi, filter);
+    if (roaring_bitmap_is_empty(rows)) {
+        roaring_bitmap_free(rows);
+        return false;
+    }
+    uint64_t v = 0;
+    for (uint32_t i = bsi->bit_count; i-- > 0;) {
+        roaring_bitmap_t *tmp =
+            greatest ? roaring_bitmap_and(rows, bsi->slices[i])
+                     : roaring_bitmap_andnot(rows, bsi->slices[i]);
+        const bool found = !roaring_bitmap_is_empty(tmp);
+        if (found) {
+            roaring_bitmap_free(rows);
+            rows = tmp;
+        } else {
+            roaring_bitmap_free(tmp);
+        }
+        if (found == greatest) v |= UINT64_C(1) << i;
+    }
+    roaring_bitmap_free(rows);
+    *value = v;
+    return true;
+}
+
+bool roaring_bsi_min(const roaring_bsi_t *bsi, const roaring_bitmap_t *filter,
+                     uint64_t *value) {
+    return bsi_extremum(bsi, filter, false, value);
+}
+
+bool roaring_bsi_max(const roaring_bsi_t *bsi, const roaring_bitmap_t *filter,
+                     uint64_t *value) {
+    return bsi_extremum(bsi, filter, true, value);
+}
+
+roaring_bitmap_t *roaring_bsi_top_k(const roaring_bsi_t *bsi,
+                                    const roaring_bitmap_t *filter,
+                                    uint64_t k) {
+    roaring_bitmap_t *ties = bsi_candidates(bsi, filter);
+    if (roaring_bitmap_get_cardinality(ties) <= k) return ties;
+    // from the top bit down, the rows that are surely in the answer move to
+    // `answer`, and those that might still be are kept in `ties`
+    roaring_bitmap_t *answer = roaring_bitmap_create();
+    uint64_t answer_card = 0;
+    for (uint32_t i = bsi->bit_count; i-- > 0;) {
+        const roaring_bitmap_t *slice = bsi->slices[i];
+        const uint64_t ones = roaring_bitmap_and_cardinality(ties, slice);
+        if (answer_card + ones < k) {
+            roaring_bitmap_t *tmp = roaring_bitmap_and(ties, slice);
+            roaring_bitmap_or_inplace(answer, tmp);
+            roaring_bitmap_free(tmp);
+            answer_card += ones;
+            roaring_bitmap_andnot_inplace(ties, slice);
+        } else {
+            roaring_bitmap_and_inplace(ties, slice);
+            if (answer_card + ones == k) break;
+        }
+    }
+    // the rows left have equal values: take the smallest ids
+    const uint64_t missing = k - answer_card;
+    uint32_t cut;
+    if (missing < roaring_bitmap_get_cardinality(ties) &&
+        roaring_bitmap_select(ties, (uint32_t)missing, &cut)) {
+        roaring_bitmap_remove_range(ties, cut, UINT64_C(1) << 32);
+    }
+    roaring_bitmap_or_inplace(answer, ties);
+    roaring_bitmap_free(ties);
+    return answer;
+}
+
+#ifdef __cplusplus
+} } }  // extern "C" { namespace roaring { namespace api {
+#endif
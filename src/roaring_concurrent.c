@@ -0,0 +1,150 @@
+#include <string.h>
+
+#include <roaring/roaring.h>
+#include <roaring/roaring_array.h>
+
+#ifdef __cplusplus
+using namespace ::roaring::internal;
+
+extern "C" { namespace roaring { namespace api {
+#endif
+
+/*
+ * Stripe i owns the keys (the high 16 bits of the values) equal to i modulo
+ * the number of stripes, in a bitmap of its own guarded by a spin lock.
+ * Dealing the keys this way spreads dense, small values (row ids, say) over
+ * all the stripes, where contiguous ranges would send them all to the first.
+ * A thread only holds the lock of one stripe at a time, while it inserts a
+ * run of values falling into that stripe. Each stripe sits on its own cache
+ * line so that threads working on neighbouring stripes do not slow each other
+ * down.
+ */
+typedef union roaring_concurrent_stripe_u {
+    struct {
+        roaring_bitmap_t bitmap;
+        croaring_lock_t lock;
+    } s;
+    char padding[64];
+} roaring_concurrent_stripe_t;
+
+struct roaring_concurrent_bitmap_s {
+    uint32_t n_stripes;
+    roaring_concurrent_stripe_t *stripes;
+};
+
+static inline uint32_t concurrent_stripe_of(
+    const roaring_concurrent_bitmap_t *cb, uint32_t val) {
+    return (val >> 16) % cb->n_stripes;
+}
+
+roaring_concurrent_bitmap_t *roaring_concurrent_bitmap_create(
+    uint32_t n_stripes) {
+#ifdef CROARING_NO_ATOMICS
+    // croaring_lock() would not keep the threads out of each other's way
+    (void)n_stripes;
+    return NULL;
+#endif
+    if (n_stripes == 0 || n_stripes > (1 << 16)) return NULL;
+    roaring_concurrent_bitmap_t *cb = (roaring_concurrent_bitmap_t *)
+        roaring_malloc(sizeof(roaring_concurrent_bitmap_t));
+    if (cb == NULL) return NULL;
+    cb->n_stripes = n_stripes;
+    cb->stripes = (roaring_concurrent_stripe_t *)roaring_aligned_malloc(
+        64, n_stripes * sizeof(roaring_concurrent_stripe_t));
+    if (cb->stripes == NULL) {
+        roaring_free(cb);
+        return NULL;
+    }
+    for (uint32_t i = 0; i < n_stripes; i++) {
+        ra_init(&cb->stripes[i].s.bitmap.high_low_container);
+        cb->stripes[i].s.lock = 0;
+    }
+    return cb;
+}
+
+void roaring_concurrent_bitmap_free(roaring_concurrent_bitmap_t *cb) {
+    if (cb == NULL) return;
+    for (uint32_t i = 0; i < cb->n_stripes; i++) {
+        ra_clear(&cb->stripes[i].s.bitmap.high_low_container);
+    }
+    roaring_aligned_free(cb->stripes);
+    roaring_free(cb);
+}
+
+void roaring_concurrent_bitmap_add(roaring_concurrent_bitmap_t *cb,
+                                   uint32_t val) {
+    roaring_concurrent_stripe_t *stripe =
+        &cb->stripes[concurrent_stripe_of(cb, val)];
+    croaring_lock(&stripe->s.lock);
+    roaring_bitmap_add(&stripe->s.bitmap, val);
+    croaring_unlock(&stripe->s.lock);
+}
+
+void roaring_concurrent_bitmap_add_many(roaring_concurrent_bitmap_t *cb,
+                                        size_t n_args, const uint32_t *vals) {
+    size_t i = 0;
+    while (i < n_args) {
+        const uint32_t s = concurrent_stripe_of(cb, vals[i]);
+        roaring_concurrent_stripe_t *stripe = &cb->stripes[s];
+        // other threads may have moved the containers since the last time
+        // we held the lock, so the context only lives as long as the lock
+        roaring_bulk_context_t context;
+        memset(&context, 0, sizeof(context));
+        croaring_lock(&stripe->s.lock);
+        do {
+            roaring_bitmap_add_bulk(&stripe->s.bitmap, &context, vals[i]);
+            i++;
+        } while (i < n_args && concurrent_stripe_of(cb, vals[i]) == s);
+        croaring_unlock(&stripe->s.lock);
+    }
+}
+
+bool roaring_concurrent_bitmap_contains(roaring_concurrent_bitmap_t *cb,
+                                        uint32_t val) {
+    roaring_concurrent_stripe_t *stripe =
+        &cb->stripes[concurrent_stripe_of(cb, val)];
+    croaring_lock(&stripe->s.lock);
+    const bool answer = roaring_bitmap_contains(&stripe->s.bitmap, val);
+    croaring_unlock(&stripe->s.lock);
+    return answer;
+}
+
+roaring_bitmap_t *roaring_concurrent_bitmap_to_bitmap(
+    roaring_concurrent_bitmap_t *cb) {
+    const uint32_t n_stripes = cb->n_stripes;
+    uint32_t size = 0;
+    for (uint32_t i = 0; i < n_stripes; i++) {
+        size += cb->stripes[i].s.bitmap.high_low_container.size;
+    }
+    // position of the next container to move, in each stripe
+    int32_t *next = (int32_t *)roaring_malloc(n_stripes * sizeof(int32_t));
+    if (next == NULL) return NULL;
+    roaring_bitmap_t *answer = roaring_bitmap_create_with_capacity(size);
+    if (answer == NULL) {
+        roaring_free(next);
+        return NULL;
+    }
+    memset(next, 0, n_stripes * sizeof(int32_t));
+    // the keys come in order by visiting the stripes in turn, and each stripe
+    // holds its keys sorted: stop as soon as all the containers are moved
+    roaring_array_t *dest = &answer->high_low_container;
+    for (uint32_t key = 0; (uint32_t)dest->size < size; key++) {
+        const uint32_t i = key % n_stripes;
+        const roaring_array_t *ra = &cb->stripes[i].s.bitmap.high_low_container;
+        if (next[i] < ra->size && ra->keys[next[i]] == key) {
+            ra_append(dest, (uint16_t)key, ra->containers[next[i]],
+                      ra->typecodes[next[i]]);
+            next[i]++;
+        }
+    }
+    for (uint32_t i = 0; i < n_stripes; i++) {
+        // the containers now belong to answer
+        cb->stripes[i].s.bitmap.high_low_container.size = 0;
+    }
+    roaring_free(next);
+    return answer;
+}
+
+#ifdef __cplusplus
+} } }  // extern "C" { namespace roaring { namespace api {
+#endif
@@ -0,0 +1,190 @@
+#include <string.h>
+
+#include <roaring/roaring.h>
+
+#ifdef __cplusplus
+extern "C" { namespace roaring { namespace api {
+#endif
+
+/*
+ * Cursors only ever move forward. An operation cursor is "settled" when its
+ * current value is the smallest value of its result that is not below the
+ * positions of its children: cursor_settle() moves the children as little as
+ * needed to get there, seeking rather than stepping whenever it can. Seeks on
+ * bitmaps gallop over the keys, then within the container, so that skipping
+ * is cheap at both levels.
+ */
+
+static bool cursor_settle(roaring_cursor_t *c) {
+    roaring_cursor_t **children = c->children;
+    switch (c->op) {
+        case ROARING_CURSOR_AND: {
+            // leapfrog: chase the largest current value until all agree
+            if (!children[0]->has_value) return (c->has_value = false);
+            uint32_t target = children[0]->current_value;
+            uint32_t agree = 1;
+            uint32_t i = (c->n_children > 1) ? 1 : 0;
+            while (agree < c->n_children) {
+                if (!roaring_cursor_move_equalorlarger(children[i], target)) {
+                    return (c->has_value = false);
+                }
+                if (children[i]->current_value == target) {
+                    agree++;
+                } else {
+                    target = children[i]->current_value;
+                    agree = 1;
+                }
+                i = (i + 1 == c->n_children) ? 0 : i + 1;
+            }
+            c->current_value = target;
+            return (c->has_value = true);
+        }
+        case ROARING_CURSOR_OR: {
+            c->has_value = false;
+            for (uint32_t i = 0; i < c->n_children; i++) {
+                if (children[i]->has_value &&
+                    (!c->has_value ||
+                     children[i]->current_value < c->current_value)) {
+                    c->current_value = children[i]->current_value;
+                    c->has_value = true;
+                }
+            }
+            return c->has_value;
+        }
+        default: {  // ROARING_CURSOR_ANDNOT
+            roaring_cursor_t *a = children[0];
+            roaring_cursor_t *b = children[1];
+            while (a->has_value) {
+                if (!roaring_cursor_move_equalorlarger(b, a->current_value) ||
+                    b->current_value != a->current_value) {
+                    c->current_value = a->current_value;
+                    return (c->has_value = true);
+                }
+                roaring_cursor_advance(a);
+            }
+            return (c->has_value = false);
+        }
+    }
+}
+
+bool roaring_cursor_move_equalorlarger(roaring_cursor_t *c, uint32_t val) {
+    if (!c->has_value || c->current_value >= val) return c->has_value;
+    switch (c->op) {
+        case ROARING_CURSOR_BITMAP:
+            c->has_value =
+                roaring_move_uint32_iterator_equalorlarger(&c->iterator, val);
+            c->current_value = c->iterator.current_value;
+            return c->has_value;
+        case ROARING_CURSOR_OR:
+            for (uint32_t i = 0; i < c->n_children; i++) {
+                roaring_cursor_move_equalorlarger(c->children[i], val);
+            }
+            return cursor_settle(c);
+        default:  // AND, ANDNOT: the others follow the first child
+            roaring_cursor_move_equalorlarger(c->children[0], val);
+            return cursor_settle(c);
+    }
+}
+
+bool roaring_cursor_advance(roaring_cursor_t *c) {
+    if (!c->has_value) return false;
+    switch (c->op) {
+        case ROARING_CURSOR_BITMAP:
+            c->has_value = roaring_advance_uint32_iterator(&c->iterator);
+            c->current_value = c->iterator.current_value;
+            return c->has_value;
+        case ROARING_CURSOR_OR:
+            for (uint32_t i = 0; i < c->n_children; i++) {
+                roaring_cursor_t *child = c->children[i];
+                if (child->has_value &&
+                    child->current_value == c->current_value) {
+                    roaring_cursor_advance(child);
+                }
+            }
+            return cursor_settle(c);
+        default:  // AND, ANDNOT: the first child is at the current value
+            roaring_cursor_advance(c->children[0]);
+            return cursor_settle(c);
+    }
+}
+
+roaring_cursor_t *roaring_cursor_create(const roaring_bitmap_t *r) {
+    roaring_cursor_t *c =
+        (roaring_cursor_t *)roaring_malloc(sizeof(roaring_cursor_t));
+    if (c == NULL) return NULL;
+    c->op = ROARING_CURSOR_BITMAP;
+    c->n_children = 0;
+    c->children = NULL;
+    roaring_init_iterator(r, &c->iterator);
+    c->has_value = c->iterator.has_value;
+    c->current_value = c->iterator.current_value;
+    return c;
+}
+
+static roaring_cursor_t *cursor_create_operation(uint8_t op, size_t n,
+                                                 roaring_cursor_t **children) {
+    bool valid = (n > 0 && n <= UINT32_MAX);
+    for (size_t i = 0; i < n; i++) {
+        if (children[i] == NULL) valid = false;
+    }
+    roaring_cursor_t *c = NULL;
+    if (valid) {
+        c = (roaring_cursor_t *)roaring_malloc(sizeof(roaring_cursor_t));
+    }
+    if (c != NULL) {
+        c->children = (roaring_cursor_t **)roaring_malloc(
+            n * sizeof(roaring_cursor_t *));
+        if (c->children == NULL) {
+            roaring_free(c);
+            c = NULL;
+        }
+    }
+    if (c == NULL) {  // the children are ours in any case
+        for (size_t i = 0; i < n; i++) {
+            roaring_cursor_free(children[i]);
+        }
+        return NULL;
+    }
+    memcpy(c->children, children, n * sizeof(roaring_cursor_t *));
+    c->op = op;
+    c->n_children = (uint32_t)n;
+    cursor_settle(c);
+    return c;
+}
+
+roaring_cursor_t *roaring_cursor_and(size_t n, roaring_cursor_t **children) {
+    return cursor_create_operation(ROARING_CURSOR_AND, n, children);
+}
+
+roaring_cursor_t *roaring_cursor_or(size_t n, roaring_cursor_t **children) {
+    return cursor_create_operation(ROARING_CURSOR_OR, n, children);
+}
+
+roaring_cursor_t *roaring_cursor_andnot(roaring_cursor_t *a,
+                                        roaring_cursor_t *b) {
+    roaring_cursor_t *children[2] = {a, b};
+    return cursor_create_operation(ROARING_CURSOR_ANDNOT, 2, children);
+}
+
+void roaring_cursor_free(roaring_cursor_t *c) {
+    if (c == NULL) return;
+    for (uint32_t i = 0; i < c->n_children; i++) {
+        roaring_cursor_free(c->children[i]);
+    }
+    roaring_free(c->children);
+    roaring_free(c);
+}
+
+uint32_t roaring_cursor_read(roaring_cursor_t *c, uint32_t *buf,
+                             uint32_t count) {
+    uint32_t n = 0;
+    while (n < count && c->has_value) {
+        buf[n++] = c->current_value;
+        roaring_cursor_advance(c);
+    }
+    return n;
+}
+
+#ifdef __cplusplus
+} } }  // extern "C" { namespace roaring { namespace api {
+#endif
@@ -0,0 +1,250 @@
+#include <string.h>
+
+#include <roaring/roaring.h>
+#include <roaring/roaring_array.h>
+#include <roaring/bitset_util.h>
+
+#ifdef __cplusplus
+using namespace ::roaring::internal;
+
+extern "C" { namespace roaring { namespace api {
+#endif
+
+/*
+ * The expression is evaluated one key at a time. For the current key, every
+ * node gets an "owner": the node whose value it equals, or -1 if its value is
+ * empty. Nodes whose value is trivially that of an operand (x | empty, x & x,
+ * ...) just take that operand's owner, so that only the nodes that actually
+ * combine two values do any work. Those write their value as 1 << 16 bits in
+ * their own scratch words. Input nodes point to their container, which is
+ * only spread into their scratch words if an operation needs it.
+ */
+typedef struct roaring_expression_state_s {
+    const roaring_expression_node_t *nodes;
+    int32_t *owners;
+    const container_t **containers;  // of the input nodes
+    uint8_t *typecodes;              // of the input nodes
+    bool *rendered;                  // whether the scratch words are set
+    uint64_t *words;  // BITSET_CONTAINER_SIZE_IN_WORDS words per node
+} roaring_expression_state_t;
+
+static uint64_t *expression_words(roaring_expression_state_t *state,
+                                  int32_t node) {
+    uint64_t *words = state->words + node * BITSET_CONTAINER_SIZE_IN_WORDS;
+    if (state->rendered[node]) return words;
+    const container_t *c = state->containers[node];
+    switch (state->typecodes[node]) {
+        case BITSET_CONTAINER_TYPE:
+            memcpy(words, const_CAST_bitset(c)->words,
+                   BITSET_CONTAINER_SIZE_IN_WORDS * sizeof(uint64_t));
+            break;
+        case ARRAY_CONTAINER_TYPE: {
+            const array_container_t *ac = const_CAST_array(c);
+            memset(words, 0, BITSET_CONTAINER_SIZE_IN_WORDS * sizeof(uint64_t));
+            bitset_set_list(words, ac->array, ac->cardinality);
+            break;
+        }
+        case RUN_CONTAINER_TYPE: {
+            const run_container_t *rc = const_CAST_run(c);
+            memset(words, 0, BITSET_CONTAINER_SIZE_IN_WORDS * sizeof(uint64_t));
+            for (int32_t i = 0; i < rc->n_runs; i++) {
+                bitset_set_lenrange(words, rc->runs[i].value,
+                                    rc->runs[i].length);
+            }
+            break;
+        }
+        default:
+            assert(false);
+            __builtin_unreachable();
+    }
+    state->rendered[node] = true;
+    return words;
+}
+
+// sets the owner of an operation node, given the owners of its operands
+static void expression_apply(roaring_expression_state_t *state, int32_t node) {
+    const roaring_expression_node_t *n = &state->nodes[node];
+    const int32_t a = state->owners[n->left];
+    const int32_t b = state->owners[n->right];
+    int32_t owner;
+    switch (n->op) {
+        case ROARING_EXPRESSION_AND:
+            owner = (a < 0 || b < 0) ? -1 : (a == b) ? a : node;
+            break;
+        case ROARING_EXPRESSION_OR:
+            owner = (a < 0) ? b : (b < 0 || a == b) ? a : node;
+            break;
+        case ROARING_EXPRESSION_XOR:
+            owner = (a < 0) ? b : (b < 0) ? a : (a == b) ? -1 : node;
+            break;
+        default:  // ROARING_EXPRESSION_ANDNOT
+            owner = (a < 0 || a == b) ? -1 : (b < 0) ? a : node;
+            break;
+    }
+    state->owners[node] = owner;
+    if (owner != node) return;
+
+    const uint64_t *wa = expression_words(state, a);
+    const uint64_t *wb = expression_words(state, b);
+    uint64_t *out = state->words + node * BITSET_CONTAINER_SIZE_IN_WORDS;
+    switch (n->op) {
+        case ROARING_EXPRESSION_AND:
+            for (int k = 0; k < BITSET_CONTAINER_SIZE_IN_WORDS; k++) {
+                out[k] = wa[k] & wb[k];
+            }
+            break;
+        case ROARING_EXPRESSION_OR:
+            for (int k = 0; k < BITSET_CONTAINER_SIZE_IN_WORDS; k++) {
+                out[k] = wa[k] | wb[k];
+            }
+            break;
+        case ROARING_EXPRESSION_XOR:
+            for (int k = 0; k < BITSET_CONTAINER_SIZE_IN_WORDS; k++) {
+                out[k] = wa[k] ^ wb[k];
+            }
+            break;
+        default:  // ROARING_EXPRESSION_ANDNOT
+            for (int k = 0; k < BITSET_CONTAINER_SIZE_IN_WORDS; k++) {
+                out[k] = wa[k] & ~wb[k];
+            }
+            break;
+    }
+    state->rendered[node] = true;
+}
+
+// turns the value of the root into a container, NULL if empty
+static container_t *expression_result(roaring_expression_state_t *state,
+                                      int32_t root, uint8_t *typecode) {
+    const int32_t owner = state->owners[root];
+    if (owner < 0) return NULL;
+    if (!state->rendered[owner]) {  // an input container, as it is
+        *typecode = state->typecodes[owner];
+        return container_clone(state->containers[owner], *typecode);
+    }
+    // the cardinality is only computed here, once per key
+    const uint64_t *words =
+        state->words + owner * BITSET_CONTAINER_SIZE_IN_WORDS;
+    int32_t card = 0;
+    for (int k = 0; k < BITSET_CONTAINER_SIZE_IN_WORDS; k++) {
+        card += hamming(words[k]);
+    }
+    if (card == 0) return NULL;
+    if (card <= DEFAULT_MAX_SIZE) {
+        array_container_t *ac = array_container_create_given_capacity(card);
+        bitset_extract_setbits_uint16(words, BITSET_CONTAINER_SIZE_IN_WORDS,
+                                      ac->array, 0);
+        ac->cardinality = card;
+        *typecode = ARRAY_CONTAINER_TYPE;
+        return ac;
+    }
+    bitset_container_t *bc = bitset_container_create();
+    memcpy(bc->words, words, BITSET_CONTAINER_SIZE_IN_WORDS * sizeof(uint64_t));
+    bc->cardinality = card;
+    *typecode = BITSET_CONTAINER_TYPE;
+    return bc;
+}
+
+// evaluates the expression key by key into answer
+static void expression_evaluate(roaring_expression_state_t *state,
+                                size_t n_nodes, size_t n_inputs,
+                                const roaring_bitmap_t **inputs,
+                                int32_t *cursors, roaring_bitmap_t *answer) {
+    const roaring_expression_node_t *nodes = state->nodes;
+    memset(cursors, 0, n_inputs * sizeof(int32_t));
+    while (true) {
+        // the smallest key that any input has left
+        int32_t key = -1;
+        for (size_t j = 0; j < n_inputs; j++) {
+            const roaring_array_t *ra = &inputs[j]->high_low_container;
+            if (cursors[j] < ra->size &&
+                (key < 0 || ra->keys[cursors[j]] < key)) {
+                key = ra->keys[cursors[j]];
+            }
+        }
+        if (key < 0) return;
+
+        for (size_t i = 0; i < n_nodes; i++) {
+            const roaring_expression_node_t *n = &nodes[i];
+            state->rendered[i] = false;
+            if (n->op != ROARING_EXPRESSION_INPUT) {
+                expression_apply(state, (int32_t)i);
+                continue;
+            }
+            const roaring_array_t *ra = &inputs[n->left]->high_low_container;
+            const int32_t pos = cursors[n->left];
+            if (pos < ra->size && ra->keys[pos] == key) {
+                uint8_t typecode = ra->typecodes[pos];
+                state->containers[i] =
+                    container_unwrap_shared(ra->containers[pos], &typecode);
+                state->typecodes[i] = typecode;
+                state->owners[i] = (int32_t)i;
+            } else {
+                state->owners[i] = -1;
+            }
+        }
+
+        uint8_t typecode;
+        container_t *c =
+            expression_result(state, (int32_t)(n_nodes - 1), &typecode);
+        if (c != NULL) {
+            ra_append(&answer->high_low_container, (uint16_t)key, c, typecode);
+        }
+
+        for (size_t j = 0; j < n_inputs; j++) {
+            const roaring_array_t *ra = &inputs[j]->high_low_container;
+            if (cursors[j] < ra->size && ra->keys[cursors[j]] == key) {
+                cursors[j]++;
+            }
+        }
+    }
+}
+
+roaring_bitmap_t *roaring_bitmap_evaluate(
+    size_t n_nodes, const roaring_expression_node_t *nodes,
+    size_t n_inputs, const roaring_bitmap_t **inputs) {
+    if (n_nodes == 0 || n_nodes > INT32_MAX / BITSET_CONTAINER_SIZE_IN_WORDS) {
+        return NULL;
+    }
+    for (size_t i = 0; i < n_nodes; i++) {
+        const roaring_expression_node_t *n = &nodes[i];
+        if (n->op == ROARING_EXPRESSION_INPUT) {
+            if (n->left >= n_inputs) return NULL;
+        } else if (n->op > ROARING_EXPRESSION_ANDNOT || n->left >= i ||
+                   n->right >= i) {
+            return NULL;  // operands must come first
+        }
+    }
+
+    roaring_expression_state_t state;
+    state.nodes = nodes;
+    state.owners = (int32_t *)roaring_malloc(n_nodes * sizeof(int32_t));
+    state.containers =
+        (const container_t **)roaring_malloc(n_nodes * sizeof(container_t *));
+    state.typecodes = (uint8_t *)roaring_malloc(n_nodes);
+    state.rendered = (bool *)roaring_malloc(n_nodes * sizeof(bool));
+    state.words = (uint64_t *)roaring_aligned_malloc(
+        32, n_nodes * BITSET_CONTAINER_SIZE_IN_WORDS * sizeof(uint64_t));
+    int32_t *cursors =
+        (int32_t *)roaring_malloc((n_inputs + 1) * sizeof(int32_t));
+    roaring_bitmap_t *answer = roaring_bitmap_create();
+    if (state.owners != NULL && state.containers != NULL &&
+        state.typecodes != NULL && state.rendered != NULL &&
+        state.words != NULL && cursors != NULL && answer != NULL) {
+        expression_evaluate(&state, n_nodes, n_inputs, inputs, cursors,
+                            answer);
+    } else if (answer != NULL) {
+        roaring_bitmap_free(answer);
+        answer = NULL;
+    }
+    roaring_free(cursors);
+    roaring_aligned_free(state.words);
+    roaring_free(state.rendered);
+    roaring_free(state.typecodes);
+    roaring_free((void *)state.containers);
+    roaring_free(state.owners);
+    return answer;
+}
+
+#ifdef __cplusplus
+} } }  // extern "C" { namespace roaring { namespace api {
+#endif
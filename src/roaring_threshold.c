@@ -0,0 +1,287 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include <roaring/roaring.h>
+#include <roaring/roaring_array.h>
+#include <roaring/bitset_util.h>
+
+#ifdef __cplusplus
+using namespace ::roaring::internal;
+
+extern "C" { namespace roaring { namespace api {
+#endif
+
+/*
+ * The bitmaps are walked one key at a time, skipping the keys found in fewer
+ * than `threshold` of them. For the other keys, the occurrences are counted
+ * in one of two ways, depending on the total cardinality of the containers:
+ *  - few values (ScanCount): one counter per 16-bit value, of which only
+ *    those of the values seen are touched, and reset afterwards;
+ *  - many values: the counters are bit-sliced, slice j holding bit j of the
+ *    counters of all 65536 values as a bitset, so that adding a container
+ *    adds a one-bit number to 64 counters per word, with carries rippling
+ *    up the slices.
+ */
+#define THRESHOLD_SCANCOUNT_MAX_CARDINALITY (4 * DEFAULT_MAX_SIZE)
+
+typedef struct roaring_threshold_state_s {
+    uint32_t threshold;
+    const container_t **containers;  // of the current key
+    uint8_t *typecodes;
+    uint32_t *counters;  // ScanCount, all zero between keys
+    uint16_t *hits;      // ScanCount, values that reached the threshold
+    uint64_t *slices;    // bit-sliced counters
+} roaring_threshold_state_t;
+
+static int threshold_uint16_compare(const void *a, const void *b) {
+    return (int)*(const uint16_t *)a - (int)*(const uint16_t *)b;
+}
+
+static inline void threshold_count(roaring_threshold_state_t *state,
+                                   uint32_t *nhits, uint16_t v) {
+    if (++state->counters[v] == state->threshold) {
+        state->hits[(*nhits)++] = v;
+    }
+}
+
+static container_t *threshold_scancount(roaring_threshold_state_t *state,
+                                        uint32_t k, uint8_t *typecode) {
+    uint32_t nhits = 0;
+    for (uint32_t i = 0; i < k; i++) {
+        const container_t *c = state->containers[i];
+        if (state->typecodes[i] == ARRAY_CONTAINER_TYPE) {
+            const array_container_t *ac = const_CAST_array(c);
+            for (int32_t j = 0; j < ac->cardinality; j++) {
+                threshold_count(state, &nhits, ac->array[j]);
+            }
+        } else {  // no bitset gets here
+            const run_container_t *rc = const_CAST_run(c);
+            for (int32_t j = 0; j < rc->n_runs; j++) {
+                const uint32_t end =
+                    (uint32_t)rc->runs[j].value + rc->runs[j].length;
+                for (uint32_t v = rc->runs[j].value; v <= end; v++) {
+                    threshold_count(state, &nhits, (uint16_t)v);
+                }
+            }
+        }
+    }
+    for (uint32_t i = 0; i < k; i++) {  // leave the counters clean
+        const container_t *c = state->containers[i];
+        if (state->typecodes[i] == ARRAY_CONTAINER_TYPE) {
+            const array_container_t *ac = const_CAST_array(c);
+            for (int32_t j = 0; j < ac->cardinality; j++) {
+                state->counters[ac->array[j]] = 0;
+            }
+        } else {
+            const run_container_t *rc = const_CAST_run(c);
+            for (int32_t j = 0; j < rc->n_runs; j++) {
+                memset(state->counters + rc->runs[j].value, 0,
+                       (rc->runs[j].length + 1) * sizeof(uint32_t));
+            }
+        }
+    }
+    if (nhits == 0) return NULL;
+    if (nhits <= DEFAULT_MAX_SIZE) {
+        array_container_t *ac = array_container_create_given_capacity(nhits);
+        qsort(state->hits, nhits, sizeof(uint16_t), threshold_uint16_compare);
+        memcpy(ac->array, state->hits, nhits * sizeof(uint16_t));
+        ac->cardinality = nhits;
+        *typecode = ARRAY_CONTAINER_TYPE;
+        return ac;
+    }
+    bitset_container_t *bc = bitset_container_create();
+    bitset_set_list(bc->words, state->hits, nhits);
+    bc->cardinality = nhits;
+    *typecode = BITSET_CONTAINER_TYPE;
+    return bc;
+}
+
+// adds one to the counters of the bits of carry, in word w of the slices
+static inline void threshold_slices_add(uint64_t *slices, uint32_t w,
+                                        uint64_t carry) {
+    for (uint64_t *s = slices + w; carry != 0;
+         s += BITSET_CONTAINER_SIZE_IN_WORDS) {
+        const uint64_t next = *s & carry;
+        *s ^= carry;
+        carry = next;
+    }
+}
+
+static container_t *threshold_bitsliced(roaring_threshold_state_t *state,
+                                        uint32_t k, uint8_t *typecode) {
+    uint64_t *slices = state->slices;
+    uint32_t nslices = 0;  // enough bits to count up to k
+    while (nslices < 32 && (k >> nslices) != 0) nslices++;
+    memset(slices, 0,
+           nslices * BITSET_CONTAINER_SIZE_IN_WORDS * sizeof(uint64_t));
+    for (uint32_t i = 0; i < k; i++) {
+        const container_t *c = state->containers[i];
+        switch (state->typecodes[i]) {
+            case BITSET_CONTAINER_TYPE: {
+                const uint64_t *words = const_CAST_bitset(c)->words;
+                for (uint32_t w = 0; w < BITSET_CONTAINER_SIZE_IN_WORDS; w++) {
+                    threshold_slices_add(slices, w, words[w]);
+                }
+                break;
+            }
+            case ARRAY_CONTAINER_TYPE: {
+                const array_container_t *ac = const_CAST_array(c);
+                int32_t j = 0;
+                while (j < ac->cardinality) {
+                    const uint32_t w = ac->array[j] >> 6;
+                    uint64_t mask = 0;
+                    do {
+                        mask |= UINT64_C(1) << (ac->array[j] & 63);
+                        j++;
+                    } while (j < ac->cardinality && (ac->array[j] >> 6) == w);
+                    threshold_slices_add(slices, w, mask);
+                }
+                break;
+            }
+            default: {  // RUN_CONTAINER_TYPE
+                const run_container_t *rc = const_CAST_run(c);
+                for (int32_t j = 0; j < rc->n_runs; j++) {
+                    const uint32_t start = rc->runs[j].value;
+                    const uint32_t end = start + rc->runs[j].length;
+                    for (uint32_t w = start >> 6; w <= end >> 6; w++) {
+                        uint64_t mask = UINT64_MAX;
+                        if (w == start >> 6) {
+                            mask &= UINT64_MAX << (start & 63);
+                        }
+                        if (w == end >> 6) {
+                            mask &= UINT64_MAX >> (63 - (end & 63));
+                        }
+                        threshold_slices_add(slices, w, mask);
+                    }
+                }
+                break;
+            }
+        }
+    }
+
+    // counter >= threshold, comparing from the most significant slice
+    bitset_container_t *bc = bitset_container_create();
+    int32_t card = 0;
+    for (uint32_t w = 0; w < BITSET_CONTAINER_SIZE_IN_WORDS; w++) {
+        uint64_t greater = 0;
+        uint64_t equal = UINT64_MAX;
+        for (uint32_t j = nslices; j-- > 0;) {
+            const uint64_t s = slices[j * BITSET_CONTAINER_SIZE_IN_WORDS + w];
+            if ((state->threshold >> j) & 1) {
+                equal &= s;
+            } else {
+                greater |= equal & s;
+                equal &= ~s;
+            }
+        }
+        bc->words[w] = greater | equal;
+        card += hamming(bc->words[w]);
+    }
+    bc->cardinality = card;
+    if (card == 0) {
+        bitset_container_free(bc);
+        return NULL;
+    }
+    if (card <= DEFAULT_MAX_SIZE) {
+        *typecode = ARRAY_CONTAINER_TYPE;
+        array_container_t *ac = array_container_from_bitset(bc);
+        bitset_container_free(bc);
+        return ac;
+    }
+    *typecode = BITSET_CONTAINER_TYPE;
+    return bc;
+}
+
+static void threshold_evaluate(roaring_threshold_state_t *state,
+                               size_t number, const roaring_bitmap_t **rs,
+                               int32_t *cursors, roaring_bitmap_t *answer) {
+    memset(cursors, 0, number * sizeof(int32_t));
+    while (true) {
+        // the smallest key that any bitmap has left
+        int32_t key = -1;
+        for (size_t j = 0; j < number; j++) {
+            const roaring_array_t *ra = &rs[j]->high_low_container;
+            if (cursors[j] < ra->size &&
+                (key < 0 || ra->keys[cursors[j]] < key)) {
+                key = ra->keys[cursors[j]];
+            }
+        }
+        if (key < 0) return;
+
+        // gather its containers
+        uint32_t k = 0;
+        uint64_t total = 0;
+        bool has_bitset = false;
+        for (size_t j = 0; j < number; j++) {
+            const roaring_array_t *ra = &rs[j]->high_low_container;
+            if (cursors[j] >= ra->size || ra->keys[cursors[j]] != key) {
+                continue;
+            }
+            uint8_t typecode = ra->typecodes[cursors[j]];
+            const container_t *c =
+                container_unwrap_shared(ra->containers[cursors[j]], &typecode);
+            state->containers[k] = c;
+            state->typecodes[k] = typecode;
+            total += container_get_cardinality(c, typecode);
+            has_bitset |= (typecode == BITSET_CONTAINER_TYPE);
+            k++;
+            cursors[j]++;
+        }
+        if (k < state->threshold) continue;  // no value can make it
+
+        uint8_t typecode;
+        container_t *c;
+        if (!has_bitset && total <= THRESHOLD_SCANCOUNT_MAX_CARDINALITY) {
+            c = threshold_scancount(state, k, &typecode);
+        } else {
+            c = threshold_bitsliced(state, k, &typecode);
+        }
+        if (c != NULL) {
+            ra_append(&answer->high_low_container, (uint16_t)key, c, typecode);
+        }
+    }
+}
+
+roaring_bitmap_t *roaring_bitmap_threshold_many(size_t number,
+                                                const roaring_bitmap_t **rs,
+                                                uint32_t threshold) {
+    if (threshold == 0) return NULL;
+    if (threshold > number) return roaring_bitmap_create();
+    if (threshold == 1) return roaring_bitmap_or_many(number, rs);
+    if (threshold == number) return roaring_bitmap_and_many(number, rs);
+
+    // the counters need one slice per bit of threshold < number
+    uint32_t nslices = 0;
+    while (nslices < 32 && ((uint64_t)number >> nslices) != 0) nslices++;
+
+    roaring_threshold_state_t state;
+    state.threshold = threshold;
+    state.containers =
+        (const container_t **)roaring_malloc(number * sizeof(container_t *));
+    state.typecodes = (uint8_t *)roaring_malloc(number);
+    state.counters = (uint32_t *)roaring_calloc(1 << 16, sizeof(uint32_t));
+    state.hits = (uint16_t *)roaring_malloc((1 << 16) * sizeof(uint16_t));
+    state.slices = (uint64_t *)roaring_aligned_malloc(
+        32, nslices * BITSET_CONTAINER_SIZE_IN_WORDS * sizeof(uint64_t));
+    int32_t *cursors = (int32_t *)roaring_malloc(number * sizeof(int32_t));
+    roaring_bitmap_t *answer = roaring_bitmap_create();
+    if (state.containers != NULL && state.typecodes != NULL &&
+        state.counters != NULL && state.hits != NULL &&
+        state.slices != NULL && cursors != NULL && answer != NULL) {
+        threshold_evaluate(&state, number, rs, cursors, answer);
+    } else if (answer != NULL) {
+        roaring_bitmap_free(answer);
+        answer = NULL;
+    }
+    roaring_free(cursors);
+    roaring_aligned_free(state.slices);
+    roaring_free(state.hits);
+    roaring_free(state.counters);
+    roaring_free(state.typecodes);
+    roaring_free((void *)state.containers);
+    return answer;
+}
+
+#ifdef __cplusplus
+} } }  // extern "C" { namespace roaring { namespace api {
+#endif
@@ -132,6 +132,45 @@ DEFINE_TEST(and_or_test) {
     array_container_free(TMP);
 }
 
+// exercises the vectorized kernels with many block/tail alignments
+DEFINE_TEST(intersection_strides_test) {
+    DESCRIBE_TEST;
+
+    const uint32_t strides[] = {1, 2, 3, 5, 7, 8, 31, 32, 33, 64, 100};
+    const size_t num_strides = sizeof(strides) / sizeof(strides[0]);
+    array_container_t* TMP = array_container_create();
+    assert_non_null(TMP);
+
+    for (size_t i = 0; i < num_strides; i++) {
+        for (size_t j = 0; j < num_strides; j++) {
+            array_container_t* B1 = array_container_create();
+            array_container_t* B2 = array_container_create();
+            array_container_t* BO = array_container_create();
+            const uint32_t offset = (uint32_t)(i * 7 + j);
+            for (uint32_t x = offset; x < 4096 + i * 13; x += strides[i]) {
+                array_container_add(B1, x);
+            }
+            for (uint32_t x = 0; x < 4096 + j * 11; x += strides[j]) {
+                array_container_add(B2, x);
+            }
+            for (uint32_t x = 0; x < 4096 + i * 13; x++) {
+                if (array_container_contains(B1, x) &&
+                    array_container_contains(B2, x)) {
+                    array_container_add(BO, x);
+                }
+            }
+            array_container_intersection(B1, B2, TMP);
+            assert_true(array_container_equals(BO, TMP));
+            assert_int_equal(array_container_cardinality(BO),
+                             array_container_intersection_cardinality(B1, B2));
+            array_container_free(B1);
+            array_container_free(B2);
+            array_container_free(BO);
+        }
+    }
+    array_container_free(TMP);
+}
+
 DEFINE_TEST(to_uint32_array_test) {
     for (size_t offset = 1; offset < 128; offset *= 2) {
         array_container_t* B = array_container_create();
@@ -195,7 +234,9 @@ DEFINE_TEST(capacity_test) {
 int main() {
     const struct CMUnitTest tests[] = {
         cmocka_unit_test(printf_test), cmocka_unit_test(add_contains_test),
-        cmocka_unit_test(and_or_test), cmocka_unit_test(to_uint32_array_test),
+        cmocka_unit_test(and_or_test),
+        cmocka_unit_test(intersection_strides_test),
+        cmocka_unit_test(to_uint32_array_test),
         cmocka_unit_test(select_test),
         cmocka_unit_test(capacity_test)
     };
@@ -18,6 +18,7 @@ using roaring::Roaring;  // the C++ wrapper class
 
 #include "roaring64map.hh"
 using roaring::Roaring64Map;  // C++ class extended for 64-bit numbers
+using roaring::Roaring64FlatMap;  // same, stored in a sorted vector
 
 #include "test.h"
 
@@ -604,6 +605,139 @@ DEFINE_TEST(test_cpp_bidirectional_iterator_64) {
 	assert_true(i == roaring.begin());
 }
 
+// the flat storage must behave exactly like the std::map one
+DEFINE_TEST(test_cpp_flat_map_64) {
+    Roaring64Map tree1, tree2;
+    Roaring64FlatMap flat1, flat2;
+    uint64_t x = 1;
+    for (int k = 0; k < 20000; ++k) {
+        x = x * 6364136223846793005ULL + 1442695040888963407ULL;
+        // a few dozens of high 32-bit buckets
+        uint64_t value = ((x >> 58) << 32) | (x & 0xFFFFF);
+        if (k % 2 == 0) {
+            tree1.add(value);
+            flat1.add(value);
+        } else {
+            tree2.add(value);
+            flat2.add(value);
+        }
+    }
+    flat2.add(uint64_t(0x7FFFFFFF00000000ULL));
+    tree2.add(uint64_t(0x7FFFFFFF00000000ULL));
+    flat1.remove(uint64_t(0));
+    tree1.remove(uint64_t(0));
+
+    assert_true(flat1.cardinality() == tree1.cardinality());
+    assert_true(flat1.minimum() == tree1.minimum());
+    assert_true(flat2.maximum() == tree2.maximum());
+    assert_true(flat1.rank(x) == tree1.rank(x));
+    uint64_t e1, e2;
+    assert_true(flat1.select(1234, &e1) && tree1.select(1234, &e2));
+    assert_true(e1 == e2);
+    assert_true(flat1.contains(e1) &&
+                !flat1.contains(uint64_t(e1 + (1ULL << 62))));
+
+    std::vector<uint64_t> values;
+    for (uint64_t v : flat1) values.push_back(v);
+    size_t pos = 0;
+    for (uint64_t v : tree1) assert_true(v == values[pos++]);
+    assert_true(pos == values.size());
+
+    auto check = [](const Roaring64FlatMap &flat, const Roaring64Map &tree) {
+        std::vector<uint64_t> a(flat.cardinality()), b(tree.cardinality());
+        assert_true(a.size() == b.size());
+        flat.toUint64Array(a.data());
+        tree.toUint64Array(b.data());
+        assert_true(a == b);
+    };
+    check(flat1 | flat2, tree1 | tree2);
+    check(flat1 & flat2, tree1 & tree2);
+    check(flat1 ^ flat2, tree1 ^ tree2);
+    check(flat1 - flat2, tree1 - tree2);
+    const Roaring64FlatMap *flat_inputs[] = {&flat1, &flat2, &flat1};
+    const Roaring64Map *tree_inputs[] = {&tree1, &tree2, &tree1};
+    check(Roaring64FlatMap::fastunion(3, flat_inputs),
+          Roaring64Map::fastunion(3, tree_inputs));
+
+    // both use the same serialized format
+    std::vector<char> buf(flat2.getSizeInBytes());
+    assert_true(flat2.write(buf.data()) == buf.size());
+    Roaring64Map tree_read = Roaring64Map::readSafe(buf.data(), buf.size());
+    assert_true(tree_read == tree2);
+    Roaring64FlatMap flat_read =
+        Roaring64FlatMap::readSafe(buf.data(), buf.size());
+    assert_true(flat_read == flat2);
+
+    flat_read -= flat2;
+    assert_true(flat_read.isEmpty());
+    assert_true(flat_read.shrinkToFit() > 0);
+}
+
+DEFINE_TEST(test_cpp_frozen_64) {
+    Roaring64Map r;
+    for (uint64_t k = 0; k < 100000; k += 3) r.add(k);  // array and bitset
+    for (uint64_t k = 0; k < 200000; k++) r.add(uint64_t((5ULL << 32) + k));
+    r.add(uint64_t(0xFFFFFFFFFFFFFFFFULL));
+    r.add(uint64_t(7ULL << 32));
+    r.remove(uint64_t(7ULL << 32));  // leaves an empty bucket behind
+    r.runOptimize();
+
+    const size_t size = r.getFrozenSizeInBytes();
+    char *buf = (char *)roaring_aligned_malloc(32, size + 32);
+    r.writeFrozen(buf);
+    {
+        roaring::Roaring64MapFrozenView view(buf, size);
+        assert_true(view.cardinality() == r.cardinality());
+        assert_true(view.minimum() == r.minimum());
+        assert_true(view.maximum() == r.maximum());
+        const uint64_t probes[] = {0, 1, 3, 99999, 100000, 5ULL << 32,
+                                   (5ULL << 32) + 199999, (5ULL << 32) + 200000,
+                                   7ULL << 32, 0xFFFFFFFFFFFFFFFFULL};
+        for (uint64_t x : probes) {
+            assert_true(view.contains(x) == r.contains(x));
+            assert_true(view.rank(x) == r.rank(x));
+        }
+        uint64_t e1, e2;
+        for (uint64_t rnk = 0; rnk < r.cardinality(); rnk += 9999) {
+            assert_true(view.select(rnk, &e1) && r.select(rnk, &e2));
+            assert_true(e1 == e2);
+        }
+        assert_false(view.select(r.cardinality(), &e1));
+
+        std::vector<uint64_t> a(view.cardinality()), b(r.cardinality());
+        view.toUint64Array(a.data());
+        r.toUint64Array(b.data());
+        assert_true(a == b);
+
+        Roaring64Map copy;
+        view.copyTo(copy);
+        assert_true(copy == r);
+        copy.add(uint64_t(2));
+        assert_true(copy.contains(uint64_t(2)) && !view.contains(2));
+    }
+
+    // the buffer must be aligned, complete and well-formed
+    roaring::Roaring64MapFrozenView view;
+    assert_true(view.reset(buf, size));
+    assert_true(view.cardinality() == r.cardinality());
+    assert_false(view.reset(buf, size - 1));
+    assert_true(view.isEmpty());
+    buf[0] ^= 1;
+    assert_false(view.reset(buf, size));
+    buf[0] ^= 1;
+    memmove(buf + 8, buf, size);
+    assert_false(view.reset(buf + 8, size));
+    roaring_aligned_free(buf);
+
+    Roaring64Map empty;
+    alignas(32) char empty_buf[32];
+    assert_true(empty.getFrozenSizeInBytes() == 16);
+    empty.writeFrozen(empty_buf);
+    roaring::Roaring64MapFrozenView empty_view(empty_buf, 16);
+    assert_true(empty_view.isEmpty());
+    assert_true(empty_view.cardinality() == 0);
+}
+
 int main() {
     roaring::misc::tellmeall();
     const struct CMUnitTest tests[] = {
@@ -623,7 +757,9 @@ int main() {
         cmocka_unit_test(test_run_compression_cpp_false),
 		cmocka_unit_test(test_cpp_clear_64),
 		cmocka_unit_test(test_cpp_move_64),
-		cmocka_unit_test(test_cpp_bidirectional_iterator_64)};
+		cmocka_unit_test(test_cpp_bidirectional_iterator_64),
+		cmocka_unit_test(test_cpp_flat_map_64),
+		cmocka_unit_test(test_cpp_frozen_64)};
 
     return cmocka_run_group_tests(tests, NULL, NULL);
 }
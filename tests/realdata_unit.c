@@ -702,6 +702,38 @@ bool compare_wide_unions(roaring_bitmap_t **rnorun, roaring_bitmap_t **rruns,
     return true;
 }
 
+bool compare_wide_intersections(roaring_bitmap_t **rnorun,
+                                roaring_bitmap_t **rruns, size_t count) {
+    // intersecting all bitmaps at once would usually be empty, so we
+    // intersect sliding windows of consecutive bitmaps
+    const size_t window = 3;
+    for (size_t i = 0; i + window <= count; ++i) {
+        roaring_bitmap_t *tempandnorun = roaring_bitmap_and_many(
+            window, (const roaring_bitmap_t **)(rnorun + i));
+        roaring_bitmap_t *tempandruns = roaring_bitmap_and_many(
+            window, (const roaring_bitmap_t **)(rruns + i));
+        if (!slow_bitmap_equals(tempandnorun, tempandruns)) {
+            printf("[compare_wide_intersections] Intersections don't agree! "
+                   "(fast run-norun) \n");
+            return false;
+        }
+        roaring_bitmap_t *longtempandnorun =
+            roaring_bitmap_and(rnorun[i], rnorun[i + 1]);
+        for (size_t j = 2; j < window; ++j) {
+            roaring_bitmap_and_inplace(longtempandnorun, rnorun[i + j]);
+        }
+        if (!slow_bitmap_equals(longtempandnorun, tempandnorun)) {
+            printf("[compare_wide_intersections] Intersections don't agree! "
+                   "(regular) \n");
+            return false;
+        }
+        roaring_bitmap_free(longtempandnorun);
+        roaring_bitmap_free(tempandnorun);
+        roaring_bitmap_free(tempandruns);
+    }
+    return true;
+}
+
 bool compare_wide_xors(roaring_bitmap_t **rnorun, roaring_bitmap_t **rruns,
                        size_t count) {
     roaring_bitmap_t *tempornorun =
@@ -830,6 +862,10 @@ bool loadAndCheckAll(const char *dirname, bool copy_on_write) {
         return false;  //  memory leaks
     }
 
+    if (!compare_wide_intersections(bitmaps, bitmapswrun, count)) {
+        return false;  //  memory leaks
+    }
+
     if (!compare_negations(bitmaps, bitmapswrun, count)) {
         return false;  //  memory leaks
     }
@@ -0,0 +1,411 @@
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <roaring/roaring64.h>
+
+#ifdef __cplusplus  // stronger type checking errors if C built in C++ mode
+    using namespace roaring::api;
+#endif
+
+#include "test.h"
+
+
+static unsigned int seed = 123456789;
+static const int OUR_RAND_MAX = (1 << 30) - 1;
+inline static unsigned int our_rand() {  // we do not want to depend on a system-specific
+                                // random number generator
+    seed = (1103515245 * seed + 12345);
+    return seed & OUR_RAND_MAX;
+}
+
+// random values clustered in a few 16-bit and 32-bit buckets
+static uint64_t random_value() {
+    static const uint64_t bases[] = {0, UINT64_C(0x10000),
+                                     UINT64_C(0xFFFFFFFF0000),
+                                     UINT64_C(0x100000000),
+                                     UINT64_C(0x123456789ABC0000),
+                                     UINT64_C(0xFFFFFFFFFFFF0000)};
+    return bases[our_rand() % 6] + (our_rand() % 0x18000);
+}
+
+static int compare_uint64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+static size_t sort_unique(uint64_t *vals, size_t n) {
+    if (n == 0) return 0;
+    qsort(vals, n, sizeof(uint64_t), compare_uint64);
+    size_t out = 1;
+    for (size_t i = 1; i < n; i++) {
+        if (vals[i] != vals[out - 1]) vals[out++] = vals[i];
+    }
+    return out;
+}
+
+static void assert_bitmap_values(const roaring64_bitmap_t *r,
+                                 const uint64_t *vals, size_t n) {
+    assert_true(roaring64_bitmap_get_cardinality(r) == n);
+    uint64_t *out = (uint64_t *)malloc(sizeof(uint64_t) * (n + 1));
+    roaring64_bitmap_to_uint64_array(r, out);
+    for (size_t i = 0; i < n; i++) {
+        assert_true(out[i] == vals[i]);
+    }
+    free(out);
+}
+
+DEFINE_TEST(test_add_contains_remove) {
+    roaring64_bitmap_t *r = roaring64_bitmap_create();
+    assert_true(roaring64_bitmap_is_empty(r));
+    assert_true(roaring64_bitmap_minimum(r) == UINT64_MAX);
+    assert_true(roaring64_bitmap_maximum(r) == 0);
+
+    const uint64_t vals[] = {0, 1, 65535, 65536, UINT64_C(0xFFFFFFFF),
+                             UINT64_C(0x100000000), UINT64_C(1) << 48,
+                             UINT64_MAX - 1, UINT64_MAX};
+    const size_t n = sizeof(vals) / sizeof(vals[0]);
+    for (size_t i = n; i > 0; i--) {
+        assert_true(roaring64_bitmap_add_checked(r, vals[i - 1]));
+        assert_false(roaring64_bitmap_add_checked(r, vals[i - 1]));
+    }
+    assert_bitmap_values(r, vals, n);
+    assert_true(roaring64_bitmap_minimum(r) == 0);
+    assert_true(roaring64_bitmap_maximum(r) == UINT64_MAX);
+    assert_false(roaring64_bitmap_contains(r, 2));
+    assert_false(roaring64_bitmap_contains(r, UINT64_C(1) << 32 | 1));
+
+    for (size_t i = 0; i < n; i++) {
+        assert_true(roaring64_bitmap_contains(r, vals[i]));
+        assert_true(roaring64_bitmap_remove_checked(r, vals[i]));
+        assert_false(roaring64_bitmap_remove_checked(r, vals[i]));
+        assert_false(roaring64_bitmap_contains(r, vals[i]));
+    }
+    assert_true(roaring64_bitmap_is_empty(r));
+    roaring64_bitmap_free(r);
+}
+
+DEFINE_TEST(test_add_many_matches_add) {
+    const size_t n = 20000;
+    uint64_t *vals = (uint64_t *)malloc(sizeof(uint64_t) * n);
+    for (size_t i = 0; i < n; i++) vals[i] = random_value();
+
+    roaring64_bitmap_t *r1 = roaring64_bitmap_of_ptr(n, vals);
+    roaring64_bitmap_t *r2 = roaring64_bitmap_create();
+    for (size_t i = 0; i < n; i++) roaring64_bitmap_add(r2, vals[i]);
+    assert_true(roaring64_bitmap_equals(r1, r2));
+
+    size_t unique = sort_unique(vals, n);
+    assert_bitmap_values(r1, vals, unique);
+
+    roaring64_bitmap_t *copy = roaring64_bitmap_copy(r1);
+    assert_true(roaring64_bitmap_equals(r1, copy));
+    roaring64_bitmap_remove(copy, vals[0]);
+    assert_false(roaring64_bitmap_equals(r1, copy));
+    assert_true(roaring64_bitmap_is_subset(copy, r1));
+    assert_false(roaring64_bitmap_is_subset(r1, copy));
+
+    roaring64_bitmap_free(copy);
+    roaring64_bitmap_free(r1);
+    roaring64_bitmap_free(r2);
+    free(vals);
+}
+
+// values spread over the whole 64-bit range, nearly one per container
+static uint64_t sparse_value() {
+    uint64_t x = ((uint64_t)our_rand() << 34) ^ ((uint64_t)our_rand() << 17) ^
+                 our_rand();
+    // some share their high bytes, so that the index nodes fill up
+    return (our_rand() % 4 == 0) ? (x & UINT64_C(0xFFFFFF)) : x;
+}
+
+DEFINE_TEST(test_sparse_values) {
+    const size_t n = 100000;
+    uint64_t *vals = (uint64_t *)malloc(sizeof(uint64_t) * n);
+    for (size_t i = 0; i < n; i++) vals[i] = sparse_value();
+
+    roaring64_bitmap_t *r = roaring64_bitmap_create();
+    for (size_t i = 0; i < n; i++) roaring64_bitmap_add(r, vals[i]);
+    roaring64_bitmap_t *odd = roaring64_bitmap_create();
+    for (size_t i = 1; i < n; i += 2) roaring64_bitmap_add(odd, vals[i]);
+
+    // remove the values of odd from r, in the order they were added
+    roaring64_bitmap_t *even = roaring64_bitmap_copy(r);
+    for (size_t i = 1; i < n; i += 2) roaring64_bitmap_remove(even, vals[i]);
+    roaring64_bitmap_t *andnot = roaring64_bitmap_andnot(r, odd);
+    assert_true(roaring64_bitmap_equals(even, andnot));
+    roaring64_bitmap_t *merged = roaring64_bitmap_or(even, odd);
+    assert_true(roaring64_bitmap_equals(merged, r));
+    roaring64_bitmap_xor_inplace(merged, odd);
+    assert_true(roaring64_bitmap_equals(merged, even));
+    roaring64_bitmap_and_inplace(merged, odd);
+    assert_true(roaring64_bitmap_is_empty(merged));
+
+    size_t unique = sort_unique(vals, n);
+    assert_bitmap_values(r, vals, unique);
+    assert_true(roaring64_bitmap_minimum(r) == vals[0]);
+    assert_true(roaring64_bitmap_maximum(r) == vals[unique - 1]);
+    uint64_t element;
+    assert_true(roaring64_bitmap_select(r, unique / 2, &element));
+    assert_true(element == vals[unique / 2]);
+
+    // empties the index from the middle outwards
+    roaring64_bitmap_remove_range_closed(r, vals[unique / 3],
+                                         vals[2 * unique / 3]);
+    assert_true(roaring64_bitmap_get_cardinality(r) ==
+                unique - (2 * unique / 3 - unique / 3 + 1));
+    for (size_t i = 0; i < unique; i++) {
+        roaring64_bitmap_remove(r, vals[i]);
+    }
+    assert_true(roaring64_bitmap_is_empty(r));
+
+    roaring64_bitmap_free(merged);
+    roaring64_bitmap_free(andnot);
+    roaring64_bitmap_free(even);
+    roaring64_bitmap_free(odd);
+    roaring64_bitmap_free(r);
+    free(vals);
+}
+
+DEFINE_TEST(test_ranges) {
+    roaring64_bitmap_t *r = roaring64_bitmap_create();
+    // a few values that the ranges must keep
+    roaring64_bitmap_add(r, 5);
+    roaring64_bitmap_add(r, UINT64_C(0x100000005));
+    roaring64_bitmap_add(r, UINT64_C(0x200000000));
+
+    // crosses the 32-bit boundary, and merges into an existing container
+    const uint64_t min = UINT64_C(0xFFFF0000) - 3;
+    const uint64_t max = UINT64_C(0x100020000) + 7;
+    roaring64_bitmap_add_range_closed(r, min, max);
+    assert_true(roaring64_bitmap_get_cardinality(r) == max - min + 1 + 2);
+    assert_true(roaring64_bitmap_contains(r, 5));
+    assert_true(roaring64_bitmap_contains(r, min));
+    assert_true(roaring64_bitmap_contains(r, UINT64_C(0xFFFFFFFF)));
+    assert_true(roaring64_bitmap_contains(r, UINT64_C(0x100000000)));
+    assert_true(roaring64_bitmap_contains(r, max));
+    assert_false(roaring64_bitmap_contains(r, min - 1));
+    assert_false(roaring64_bitmap_contains(r, max + 1));
+    assert_true(roaring64_bitmap_contains(r, UINT64_C(0x200000000)));
+    assert_true(roaring64_bitmap_rank(r, max) == max - min + 1 + 1);
+
+    roaring64_bitmap_remove_range_closed(r, min + 10, max - 10);
+    assert_true(roaring64_bitmap_get_cardinality(r) == 20 + 2);
+    assert_true(roaring64_bitmap_contains(r, min + 9));
+    assert_false(roaring64_bitmap_contains(r, min + 10));
+    assert_false(roaring64_bitmap_contains(r, max - 10));
+    assert_true(roaring64_bitmap_contains(r, max - 9));
+    assert_true(roaring64_bitmap_contains(r, UINT64_C(0x200000000)));
+
+    // the top of the 64-bit range, where the next key would overflow
+    roaring64_bitmap_add_range_closed(r, UINT64_MAX - 70000, UINT64_MAX);
+    assert_true(roaring64_bitmap_contains(r, UINT64_MAX));
+    assert_true(roaring64_bitmap_maximum(r) == UINT64_MAX);
+    roaring64_bitmap_remove_range_closed(r, UINT64_MAX - 70000, UINT64_MAX);
+    assert_true(roaring64_bitmap_maximum(r) == UINT64_C(0x200000000));
+
+    roaring64_bitmap_remove_range_closed(r, 0, UINT64_MAX);
+    assert_true(roaring64_bitmap_is_empty(r));
+    roaring64_bitmap_free(r);
+}
+
+DEFINE_TEST(test_rank_select) {
+    const size_t n = 5000;
+    uint64_t *vals = (uint64_t *)malloc(sizeof(uint64_t) * n);
+    for (size_t i = 0; i < n; i++) vals[i] = random_value();
+    size_t unique = sort_unique(vals, n);
+    roaring64_bitmap_t *r = roaring64_bitmap_of_ptr(unique, vals);
+    roaring64_bitmap_run_optimize(r);
+
+    for (size_t i = 0; i < unique; i++) {
+        uint64_t element;
+        assert_true(roaring64_bitmap_select(r, i, &element));
+        assert_true(element == vals[i]);
+        assert_true(roaring64_bitmap_rank(r, vals[i]) == i + 1);
+    }
+    uint64_t element;
+    assert_false(roaring64_bitmap_select(r, unique, &element));
+    assert_true(roaring64_bitmap_rank(r, UINT64_MAX) == unique);
+
+    roaring64_bitmap_free(r);
+    free(vals);
+}
+
+typedef enum { OP_AND, OP_OR, OP_XOR, OP_ANDNOT } op_t;
+
+// the values of the reference result, merging the two sorted inputs
+static size_t reference_op(op_t op, const uint64_t *a, size_t na,
+                           const uint64_t *b, size_t nb, uint64_t *out) {
+    size_t i = 0, j = 0, k = 0;
+    while (i < na || j < nb) {
+        bool in_a = i < na && (j == nb || a[i] <= b[j]);
+        bool in_b = j < nb && (i == na || b[j] <= a[i]);
+        uint64_t v = in_a ? a[i] : b[j];
+        bool keep = false;
+        switch (op) {
+            case OP_AND: keep = in_a && in_b; break;
+            case OP_OR: keep = true; break;
+            case OP_XOR: keep = in_a != in_b; break;
+            case OP_ANDNOT: keep = in_a && !in_b; break;
+        }
+        if (keep) out[k++] = v;
+        if (in_a) i++;
+        if (in_b) j++;
+    }
+    return k;
+}
+
+static void check_op(op_t op, const roaring64_bitmap_t *r1,
+                     const roaring64_bitmap_t *r2, const uint64_t *a,
+                     size_t na, const uint64_t *b, size_t nb) {
+    uint64_t *expected = (uint64_t *)malloc(sizeof(uint64_t) * (na + nb + 1));
+    size_t n = reference_op(op, a, na, b, nb, expected);
+
+    roaring64_bitmap_t *result = NULL;
+    uint64_t card = 0;
+    roaring64_bitmap_t *inplace = roaring64_bitmap_copy(r1);
+    switch (op) {
+        case OP_AND:
+            result = roaring64_bitmap_and(r1, r2);
+            card = roaring64_bitmap_and_cardinality(r1, r2);
+            roaring64_bitmap_and_inplace(inplace, r2);
+            assert_true(roaring64_bitmap_intersect(r1, r2) == (n > 0));
+            break;
+        case OP_OR:
+            result = roaring64_bitmap_or(r1, r2);
+            card = roaring64_bitmap_or_cardinality(r1, r2);
+            roaring64_bitmap_or_inplace(inplace, r2);
+            break;
+        case OP_XOR:
+            result = roaring64_bitmap_xor(r1, r2);
+            card = roaring64_bitmap_xor_cardinality(r1, r2);
+            roaring64_bitmap_xor_inplace(inplace, r2);
+            break;
+        case OP_ANDNOT:
+            result = roaring64_bitmap_andnot(r1, r2);
+            card = roaring64_bitmap_andnot_cardinality(r1, r2);
+            roaring64_bitmap_andnot_inplace(inplace, r2);
+            break;
+    }
+    assert_true(card == n);
+    assert_bitmap_values(result, expected, n);
+    assert_true(roaring64_bitmap_equals(result, inplace));
+
+    roaring64_bitmap_free(inplace);
+    roaring64_bitmap_free(result);
+    free(expected);
+}
+
+DEFINE_TEST(test_set_operations) {
+    for (int trial = 0; trial < 4; trial++) {
+        const size_t n = (trial == 0) ? 10 : 3000 << trial;
+        uint64_t *a = (uint64_t *)malloc(sizeof(uint64_t) * n);
+        uint64_t *b = (uint64_t *)malloc(sizeof(uint64_t) * n);
+        for (size_t i = 0; i < n; i++) {
+            a[i] = random_value();
+            b[i] = random_value();
+        }
+        size_t na = sort_unique(a, n);
+        size_t nb = sort_unique(b, n);
+        roaring64_bitmap_t *r1 = roaring64_bitmap_of_ptr(na, a);
+        roaring64_bitmap_t *r2 = roaring64_bitmap_of_ptr(nb, b);
+        if (trial == 3) {
+            roaring64_bitmap_add_range_closed(r2, 0, 200000);
+            roaring64_bitmap_run_optimize(r2);
+            // keep the reference in sync
+            free(b);
+            nb = roaring64_bitmap_get_cardinality(r2);
+            b = (uint64_t *)malloc(sizeof(uint64_t) * nb);
+            roaring64_bitmap_to_uint64_array(r2, b);
+        }
+        check_op(OP_AND, r1, r2, a, na, b, nb);
+        check_op(OP_OR, r1, r2, a, na, b, nb);
+        check_op(OP_XOR, r1, r2, a, na, b, nb);
+        check_op(OP_ANDNOT, r1, r2, a, na, b, nb);
+        check_op(OP_ANDNOT, r2, r1, b, nb, a, na);
+        roaring64_bitmap_free(r1);
+        roaring64_bitmap_free(r2);
+        free(a);
+        free(b);
+    }
+}
+
+DEFINE_TEST(test_portable_serialization) {
+    roaring64_bitmap_t *r = roaring64_bitmap_create();
+    for (size_t i = 0; i < 10000; i++) roaring64_bitmap_add(r, random_value());
+    roaring64_bitmap_add_range_closed(r, UINT64_C(0x500000000),
+                                      UINT64_C(0x500100000));
+    roaring64_bitmap_run_optimize(r);
+
+    size_t size = roaring64_bitmap_portable_size_in_bytes(r);
+    char *buf = (char *)malloc(size);
+    assert_true(roaring64_bitmap_portable_serialize(r, buf) == size);
+
+    uint64_t bucket_count;
+    memcpy(&bucket_count, buf, sizeof(bucket_count));
+    assert_true(bucket_count > 1);
+
+    roaring64_bitmap_t *r2 = roaring64_bitmap_portable_deserialize_safe(buf,
+                                                                        size);
+    assert_non_null(r2);
+    assert_true(roaring64_bitmap_equals(r, r2));
+    roaring64_bitmap_free(r2);
+
+    // truncated buffers must be rejected
+    for (size_t len = 0; len < size; len += 1 + len / 4) {
+        assert_null(roaring64_bitmap_portable_deserialize_safe(buf, len));
+    }
+
+    // the buckets must be in increasing order
+    uint32_t first_bucket = 7;
+    memcpy(buf + sizeof(uint64_t), &first_bucket, sizeof(first_bucket));
+    assert_null(roaring64_bitmap_portable_deserialize_safe(buf, size));
+
+    // an empty bitmap is just a zero bucket count
+    roaring64_bitmap_t *empty = roaring64_bitmap_create();
+    assert_true(roaring64_bitmap_portable_size_in_bytes(empty) ==
+                sizeof(uint64_t));
+    assert_true(roaring64_bitmap_portable_serialize(empty, buf) ==
+                sizeof(uint64_t));
+    r2 = roaring64_bitmap_portable_deserialize_safe(buf, sizeof(uint64_t));
+    assert_non_null(r2);
+    assert_true(roaring64_bitmap_is_empty(r2));
+    roaring64_bitmap_free(r2);
+    roaring64_bitmap_free(empty);
+
+    free(buf);
+    roaring64_bitmap_free(r);
+}
+
+static bool stop_after_three(uint64_t value, void *param) {
+    (void)value;
+    int *count = (int *)param;
+    return ++(*count) < 3;
+}
+
+DEFINE_TEST(test_iterate) {
+    const uint64_t vals[] = {1, UINT64_C(1) << 32, UINT64_C(1) << 48,
+                             UINT64_MAX};
+    roaring64_bitmap_t *r = roaring64_bitmap_of_ptr(4, vals);
+    int count = 0;
+    assert_false(roaring64_bitmap_iterate(r, stop_after_three, &count));
+    assert_int_equal(count, 3);
+    assert_bitmap_values(r, vals, 4);
+    roaring64_bitmap_free(r);
+}
+
+int main() {
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_add_contains_remove),
+        cmocka_unit_test(test_add_many_matches_add),
+        cmocka_unit_test(test_sparse_values),
+        cmocka_unit_test(test_ranges),
+        cmocka_unit_test(test_rank_select),
+        cmocka_unit_test(test_set_operations),
+        cmocka_unit_test(test_portable_serialization),
+        cmocka_unit_test(test_iterate),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
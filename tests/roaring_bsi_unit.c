@@ -0,0 +1,259 @@
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <roaring/roaring_bsi.h>
+
+#ifdef __cplusplus  // stronger type checking errors if C built in C++ mode
+    using namespace roaring::api;
+#endif
+
+#include "test.h"
+
+
+static unsigned int seed = 123456789;
+static const int OUR_RAND_MAX = (1 << 30) - 1;
+inline static unsigned int our_rand() {  // we do not want to depend on a system-specific
+                                // random number generator
+    seed = (1103515245 * seed + 12345);
+    return seed & OUR_RAND_MAX;
+}
+
+enum { ROWS = 5000 };
+
+// a column of ROWS rows, with a value for some of them, and the same in a BSI
+typedef struct column_s {
+    bool present[ROWS];
+    uint64_t values[ROWS];
+    roaring_bsi_t *bsi;
+} column_t;
+
+static void column_set(column_t *col, size_t n, const uint32_t *rows,
+                       const uint64_t *values) {
+    for (size_t i = 0; i < n; i++) {
+        col->present[rows[i]] = true;
+        col->values[rows[i]] = values[i];
+    }
+    assert_true(roaring_bsi_set_many(col->bsi, n, rows, values));
+}
+
+// random values spread over a few magnitudes, with many duplicates
+static uint64_t random_value() {
+    switch (our_rand() % 4) {
+        case 0: return our_rand() % 10;
+        case 1: return 1000 + our_rand() % 100;
+        case 2: return ((uint64_t)our_rand() << 20) + our_rand() % 3;
+        default: return UINT64_MAX - our_rand() % 5;
+    }
+}
+
+static column_t *column_create() {
+    column_t *col = (column_t *)calloc(1, sizeof(column_t));
+    col->bsi = roaring_bsi_create();
+    uint32_t rows[ROWS];
+    uint64_t values[ROWS];
+    size_t n = 0;
+    for (uint32_t row = 0; row < ROWS; row++) {
+        if (our_rand() % 5 == 0) continue;  // no value
+        rows[n] = row;
+        values[n] = random_value();
+        n++;
+    }
+    column_set(col, n, rows, values);
+    // overwrite some of the values, in no particular order
+    n = 0;
+    for (uint32_t row = ROWS; row-- > 0;) {
+        if (our_rand() % 7 != 0) continue;
+        rows[n] = row;
+        values[n] = our_rand() % 2000;
+        n++;
+    }
+    column_set(col, n, rows, values);
+    return col;
+}
+
+static void column_free(column_t *col) {
+    roaring_bsi_free(col->bsi);
+    free(col);
+}
+
+static roaring_bitmap_t *random_filter() {
+    roaring_bitmap_t *filter = roaring_bitmap_create();
+    for (uint32_t row = 0; row < ROWS + 100; row++) {
+        if (our_rand() % 3 == 0) roaring_bitmap_add(filter, row);
+    }
+    return filter;
+}
+
+static bool in_filter(const roaring_bitmap_t *filter, uint32_t row) {
+    return filter == NULL || roaring_bitmap_contains(filter, row);
+}
+
+static bool compare(uint8_t op, uint64_t x, uint64_t y) {
+    switch (op) {
+        case ROARING_BSI_EQ: return x == y;
+        case ROARING_BSI_NEQ: return x != y;
+        case ROARING_BSI_LT: return x < y;
+        case ROARING_BSI_LE: return x <= y;
+        case ROARING_BSI_GT: return x > y;
+        default: return x >= y;
+    }
+}
+
+DEFINE_TEST(test_set_get) {
+    column_t *col = column_create();
+    uint64_t count = 0;
+    for (uint32_t row = 0; row < ROWS + 10; row++) {
+        uint64_t value;
+        const bool present = row < ROWS && col->present[row];
+        assert_true(roaring_bsi_get(col->bsi, row, &value) == present);
+        if (present) {
+            assert_true(value == col->values[row]);
+            count++;
+        }
+    }
+    assert_true(roaring_bsi_get_cardinality(col->bsi) == count);
+    column_free(col);
+}
+
+DEFINE_TEST(test_compare) {
+    column_t *col = column_create();
+    roaring_bitmap_t *filter = random_filter();
+    const uint64_t pivots[] = {0, 5, 1050, 1999, UINT64_C(1) << 40,
+                               UINT64_MAX - 2, UINT64_MAX};
+    for (int f = 0; f < 2; f++) {
+        const roaring_bitmap_t *flt = f ? filter : NULL;
+        for (size_t p = 0; p < sizeof(pivots) / sizeof(pivots[0]); p++) {
+            for (uint8_t op = ROARING_BSI_EQ; op <= ROARING_BSI_GE; op++) {
+                roaring_bitmap_t *r =
+                    roaring_bsi_compare(col->bsi, op, pivots[p], flt);
+                for (uint32_t row = 0; row < ROWS; row++) {
+                    const bool expected = col->present[row] &&
+                                          in_filter(flt, row) &&
+                                          compare(op, col->values[row],
+                                                  pivots[p]);
+                    assert_true(roaring_bitmap_contains(r, row) == expected);
+                }
+                roaring_bitmap_free(r);
+            }
+        }
+        roaring_bitmap_t *r = roaring_bsi_range(col->bsi, 5, 1500, flt);
+        for (uint32_t row = 0; row < ROWS; row++) {
+            const bool expected = col->present[row] && in_filter(flt, row) &&
+                                  col->values[row] >= 5 &&
+                                  col->values[row] <= 1500;
+            assert_true(roaring_bitmap_contains(r, row) == expected);
+        }
+        roaring_bitmap_free(r);
+    }
+    assert_null(roaring_bsi_compare(col->bsi, ROARING_BSI_GE + 1, 0, NULL));
+
+    // a value above all the slices
+    roaring_bsi_t *small = roaring_bsi_create();
+    const uint32_t rows[] = {1, 2, 3};
+    const uint64_t values[] = {0, 1, 0};
+    assert_true(roaring_bsi_set_many(small, 3, rows, values));
+    roaring_bitmap_t *r = roaring_bsi_compare(small, ROARING_BSI_LT, 2, NULL);
+    assert_true(roaring_bitmap_get_cardinality(r) == 3);
+    roaring_bitmap_free(r);
+    r = roaring_bsi_compare(small, ROARING_BSI_EQ, 0, NULL);
+    assert_true(roaring_bitmap_get_cardinality(r) == 2);
+    roaring_bitmap_free(r);
+    roaring_bsi_free(small);
+
+    roaring_bitmap_free(filter);
+    column_free(col);
+}
+
+DEFINE_TEST(test_aggregates) {
+    column_t *col = column_create();
+    roaring_bitmap_t *filter = random_filter();
+    for (int f = 0; f < 2; f++) {
+        const roaring_bitmap_t *flt = f ? filter : NULL;
+        uint64_t sum = 0, count = 0, min = UINT64_MAX, max = 0;
+        for (uint32_t row = 0; row < ROWS; row++) {
+            if (!col->present[row] || !in_filter(flt, row)) continue;
+            uint64_t v = col->values[row];
+            sum += v;
+            count++;
+            if (v < min) min = v;
+            if (v > max) max = v;
+        }
+        uint64_t bsi_count, value;
+        assert_true(roaring_bsi_sum(col->bsi, flt, &bsi_count) == sum);
+        assert_true(bsi_count == count);
+        assert_true(roaring_bsi_min(col->bsi, flt, &value));
+        assert_true(value == min);
+        assert_true(roaring_bsi_max(col->bsi, flt, &value));
+        assert_true(value == max);
+    }
+    roaring_bitmap_t *none = roaring_bitmap_from_range(ROWS, ROWS + 10, 1);
+    uint64_t value;
+    assert_false(roaring_bsi_min(col->bsi, none, &value));
+    assert_false(roaring_bsi_max(col->bsi, none, &value));
+    roaring_bitmap_free(none);
+    roaring_bitmap_free(filter);
+    column_free(col);
+}
+
+DEFINE_TEST(test_top_k) {
+    column_t *col = column_create();
+    roaring_bitmap_t *filter = random_filter();
+    const uint64_t ks[] = {0, 1, 10, 100, 777, ROWS};
+    for (int f = 0; f < 2; f++) {
+        const roaring_bitmap_t *flt = f ? filter : NULL;
+        for (size_t j = 0; j < sizeof(ks) / sizeof(ks[0]); j++) {
+            const uint64_t k = ks[j];
+            roaring_bitmap_t *r = roaring_bsi_top_k(col->bsi, flt, k);
+            uint64_t candidates = 0;
+            for (uint32_t row = 0; row < ROWS; row++) {
+                candidates += col->present[row] && in_filter(flt, row);
+            }
+            const uint64_t expected_card = k < candidates ? k : candidates;
+            assert_true(roaring_bitmap_get_cardinality(r) == expected_card);
+            // every row taken beats or ties every row left out, and ties
+            // are broken in favor of the smaller row ids
+            uint64_t min_in = UINT64_MAX, max_out = 0;
+            for (uint32_t row = 0; row < ROWS; row++) {
+                if (roaring_bitmap_contains(r, row)) {
+                    assert_true(col->present[row] && in_filter(flt, row));
+                    if (col->values[row] < min_in) min_in = col->values[row];
+                } else if (col->present[row] && in_filter(flt, row)) {
+                    if (col->values[row] > max_out) max_out = col->values[row];
+                }
+            }
+            if (expected_card == 0 || expected_card == candidates) {
+                roaring_bitmap_free(r);
+                continue;
+            }
+            assert_true(min_in >= max_out);
+            bool out_seen = false;
+            for (uint32_t row = 0; row < ROWS; row++) {
+                if (!col->present[row] || !in_filter(flt, row) ||
+                    col->values[row] != max_out) {
+                    continue;
+                }
+                if (roaring_bitmap_contains(r, row)) {
+                    assert_false(out_seen);
+                } else {
+                    out_seen = true;
+                }
+            }
+            roaring_bitmap_free(r);
+        }
+    }
+    roaring_bitmap_free(filter);
+    column_free(col);
+}
+
+int main() {
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_set_get),
+        cmocka_unit_test(test_compare),
+        cmocka_unit_test(test_aggregates),
+        cmocka_unit_test(test_top_k),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
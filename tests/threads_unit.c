@@ -0,0 +1,200 @@
+/*
+ * threads_unit.c
+ *
+ * Bitmaps used from several POSIX threads at once. Only the main thread
+ * runs the cmocka assertions: the threads report their checks back.
+ */
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <roaring/roaring.h>
+#include <roaring/portability.h>  // CROARING_NO_ATOMICS
+
+#ifdef __cplusplus  // stronger type checking errors if C built in C++ mode
+    using namespace roaring::api;
+#endif
+
+#include "test.h"
+
+enum { N_THREADS = 8, N_ROUNDS = 50, N_KEYS = 4 };
+
+// arrays, a bitset and a run, none of them holding a thread_value()
+static roaring_bitmap_t *make_shared_source() {
+    roaring_bitmap_t *r = roaring_bitmap_create();
+    for (uint32_t i = 0; i < 200; i += 2) {
+        roaring_bitmap_add(r, i);
+        roaring_bitmap_add(r, (3u << 16) + 300 * i);
+    }
+    for (uint32_t i = 0; i < 65536; i += 2) {
+        roaring_bitmap_add(r, (1u << 16) + i);
+    }
+    roaring_bitmap_add_range(r, 2u << 16, (2u << 16) + 40000);
+    return r;
+}
+
+// a value that is not in the source, distinct for each thread and key
+static uint32_t thread_value(int thread, uint32_t key) {
+    return (key << 16) + 65535 - 2 * thread;
+}
+
+typedef struct snapshot_task_s {
+    roaring_bitmap_t *snapshot;  // owned by the thread
+    const roaring_bitmap_t *expected;
+    int thread;
+    bool ok;
+} snapshot_task_t;
+
+static void *modify_snapshot(void *arg) {
+    snapshot_task_t *task = (snapshot_task_t *)arg;
+    roaring_bitmap_t *s = task->snapshot;
+    bool ok = roaring_bitmap_equals(s, task->expected);
+    roaring_bitmap_t *nested = roaring_bitmap_snapshot(s);
+    // every container is written to, and thus unshared
+    for (uint32_t key = 0; key < N_KEYS; key++) {
+        roaring_bitmap_add(s, thread_value(task->thread, key));
+        ok = ok && roaring_bitmap_contains(s, thread_value(task->thread, key));
+    }
+    ok = ok && roaring_bitmap_get_cardinality(s) ==
+                   roaring_bitmap_get_cardinality(task->expected) + N_KEYS;
+    ok = ok && roaring_bitmap_equals(nested, task->expected);
+    for (uint32_t key = 0; key < N_KEYS; key++) {
+        roaring_bitmap_remove(s, thread_value(task->thread, key));
+    }
+    ok = ok && roaring_bitmap_equals(s, task->expected);
+    roaring_bitmap_free(nested);
+    roaring_bitmap_free(s);
+    task->ok = ok;
+    return NULL;
+}
+
+DEFINE_TEST(test_snapshots_across_threads) {
+#ifdef CROARING_NO_ATOMICS
+    skip();
+#endif
+    roaring_bitmap_t *expected = make_shared_source();
+    for (int round = 0; round < N_ROUNDS; round++) {
+        roaring_bitmap_t *r = make_shared_source();
+        snapshot_task_t tasks[N_THREADS];
+        pthread_t threads[N_THREADS];
+        for (int t = 0; t < N_THREADS; t++) {
+            tasks[t].snapshot = roaring_bitmap_snapshot(r);
+            tasks[t].expected = expected;
+            tasks[t].thread = t;
+            tasks[t].ok = false;
+        }
+        for (int t = 0; t < N_THREADS; t++) {
+            assert_int_equal(pthread_create(&threads[t], NULL,
+                                            modify_snapshot, &tasks[t]),
+                             0);
+        }
+        // meanwhile, the source lets go of the containers it shares
+        roaring_bitmap_add(r, 1);
+        roaring_bitmap_remove_range(r, 1u << 16, 2u << 16);
+        roaring_bitmap_remove(r, (2u << 16) + 5);
+        roaring_bitmap_free(r);
+        for (int t = 0; t < N_THREADS; t++) {
+            assert_int_equal(pthread_join(threads[t], NULL), 0);
+            assert_true(tasks[t].ok);
+        }
+    }
+    roaring_bitmap_free(expected);
+}
+
+enum { N_IDS = 1 << 19, N_SPREAD = 5000, BATCH = 1000 };
+
+typedef struct insert_task_s {
+    roaring_concurrent_bitmap_t *cb;
+    int thread;
+    bool ok;
+} insert_task_t;
+
+// one value out of three of the dense ids, and values all over the range
+static bool inserted(int thread, uint32_t i) {
+    return i % N_THREADS == (uint32_t)thread && i % 3 != 0;
+}
+
+static uint32_t spread_value(int thread, uint32_t i) {
+    return (uint32_t)(i * N_THREADS + thread) * 2654435761u;
+}
+
+// the threads interleave their dense ids, so they all hit the same stripes
+static void *insert_values(void *arg) {
+    insert_task_t *task = (insert_task_t *)arg;
+    uint32_t batch[BATCH];
+    size_t n = 0;
+    bool ok = true;
+    for (uint32_t i = 0; i < N_IDS; i++) {
+        if (!inserted(task->thread, i)) continue;
+        if (i % 2 == 0) {
+            roaring_concurrent_bitmap_add(task->cb, i);
+        } else {
+            batch[n++] = i;
+            if (n == BATCH) {
+                roaring_concurrent_bitmap_add_many(task->cb, n, batch);
+                n = 0;
+            }
+        }
+        if (i % 97 == 0 && i % 2 == 0) {
+            ok = ok && roaring_concurrent_bitmap_contains(task->cb, i);
+        }
+    }
+    roaring_concurrent_bitmap_add_many(task->cb, n, batch);
+    for (uint32_t i = 0; i < N_SPREAD; i++) {
+        const uint32_t v = spread_value(task->thread, i);
+        roaring_concurrent_bitmap_add(task->cb, v);
+        ok = ok && roaring_concurrent_bitmap_contains(task->cb, v);
+    }
+    task->ok = ok;
+    return NULL;
+}
+
+DEFINE_TEST(test_concurrent_insertions) {
+#ifdef CROARING_NO_ATOMICS
+    skip();
+#endif
+    roaring_bitmap_t *expected = roaring_bitmap_create();
+    for (int t = 0; t < N_THREADS; t++) {
+        for (uint32_t i = 0; i < N_IDS; i++) {
+            if (inserted(t, i)) roaring_bitmap_add(expected, i);
+        }
+        for (uint32_t i = 0; i < N_SPREAD; i++) {
+            roaring_bitmap_add(expected, spread_value(t, i));
+        }
+    }
+    const uint32_t stripe_counts[] = {1, 5, 64};
+    for (size_t k = 0; k < sizeof(stripe_counts) / sizeof(uint32_t); k++) {
+        roaring_concurrent_bitmap_t *cb =
+            roaring_concurrent_bitmap_create(stripe_counts[k]);
+        assert_non_null(cb);
+        insert_task_t tasks[N_THREADS];
+        pthread_t threads[N_THREADS];
+        for (int t = 0; t < N_THREADS; t++) {
+            tasks[t].cb = cb;
+            tasks[t].thread = t;
+            tasks[t].ok = false;
+            assert_int_equal(pthread_create(&threads[t], NULL, insert_values,
+                                            &tasks[t]),
+                             0);
+        }
+        for (int t = 0; t < N_THREADS; t++) {
+            assert_int_equal(pthread_join(threads[t], NULL), 0);
+            assert_true(tasks[t].ok);
+        }
+        roaring_bitmap_t *r = roaring_concurrent_bitmap_to_bitmap(cb);
+        assert_non_null(r);
+        assert_true(roaring_bitmap_equals(r, expected));
+        roaring_bitmap_free(r);
+        roaring_concurrent_bitmap_free(cb);
+    }
+    roaring_bitmap_free(expected);
+}
+
+int main() {
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_snapshots_across_threads),
+        cmocka_unit_test(test_concurrent_insertions),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -657,6 +657,15 @@ void test_example(bool copy_on_write) {
     assert_true(roaring_bitmap_get_cardinality(i1_2) ==
                 roaring_bitmap_and_cardinality(r1, r2));
 
+    // we can compute a big intersection
+    roaring_bitmap_t *i1_2_3 = roaring_bitmap_and(i1_2, r3);
+    const roaring_bitmap_t *allmybitmaps_a[] = {r1, r2, r3};
+    roaring_bitmap_t *bigintersection =
+        roaring_bitmap_and_many(3, allmybitmaps_a);
+    assert_true(roaring_bitmap_equals(i1_2_3, bigintersection));
+
+    roaring_bitmap_free(i1_2_3);
+    roaring_bitmap_free(bigintersection);
     roaring_bitmap_free(i1_2);
 
     // we can write a bitmap to a pointer and recover it later
@@ -3486,6 +3495,69 @@ DEFINE_TEST(test_or_many_memory_leak) {
     }
 }
 
+// runs the tasks in reverse order, to make sure that they are independent
+static void reverse_executor(roaring_task task, void *task_data, size_t count,
+                             void *executor_data) {
+    size_t *calls = (size_t *)executor_data;
+    for (size_t i = count; i > 0; i--) {
+        task(task_data, i - 1);
+        (*calls)++;
+    }
+}
+
+void test_or_many_parallel(bool copy_on_write) {
+    const size_t number = 20;
+    roaring_bitmap_t *bitmaps[20];
+    for (size_t i = 0; i < number; i++) {
+        bitmaps[i] = roaring_bitmap_create();
+        roaring_bitmap_set_copy_on_write(bitmaps[i], copy_on_write);
+        for (int j = 0; j < 2000; j++) {
+            // sparse values over the whole range, plus some dense areas
+            roaring_bitmap_add(bitmaps[i], our_rand() * 4);
+            roaring_bitmap_add(bitmaps[i], (uint32_t)(i * 100000 + j * 3));
+        }
+        if (i % 3 == 0) {
+            roaring_bitmap_add_range(bitmaps[i], i << 20, (i << 20) + 300000);
+        }
+        roaring_bitmap_run_optimize(bitmaps[i]);
+    }
+    const roaring_bitmap_t **inputs = (const roaring_bitmap_t **)bitmaps;
+    roaring_bitmap_t *expected = roaring_bitmap_or_many(number, inputs);
+
+    const size_t shard_counts[] = {0, 1, 2, 7, 64, 1000};
+    for (size_t k = 0; k < sizeof(shard_counts) / sizeof(size_t); k++) {
+        size_t calls = 0;
+        roaring_bitmap_t *bigunion = roaring_bitmap_or_many_parallel(
+            number, inputs, shard_counts[k], reverse_executor, &calls);
+        assert_true(calls >= 1);
+        assert_true(calls <= 256);
+        assert_true(roaring_bitmap_equals(expected, bigunion));
+        roaring_bitmap_free(bigunion);
+
+        bigunion = roaring_bitmap_or_many_parallel(number, inputs,
+                                                   shard_counts[k], NULL, NULL);
+        assert_true(roaring_bitmap_equals(expected, bigunion));
+        roaring_bitmap_free(bigunion);
+    }
+
+    roaring_bitmap_t *empty = roaring_bitmap_create();
+    const roaring_bitmap_t *empties[] = {empty, empty};
+    roaring_bitmap_t *emptyunion =
+        roaring_bitmap_or_many_parallel(2, empties, 4, NULL, NULL);
+    assert_true(roaring_bitmap_is_empty(emptyunion));
+    roaring_bitmap_free(emptyunion);
+    roaring_bitmap_free(empty);
+
+    roaring_bitmap_free(expected);
+    for (size_t i = 0; i < number; i++) {
+        roaring_bitmap_free(bitmaps[i]);
+    }
+}
+
+DEFINE_TEST(test_or_many_parallel_true) { test_or_many_parallel(true); }
+
+DEFINE_TEST(test_or_many_parallel_false) { test_or_many_parallel(false); }
+
 void test_iterator_generate_data(uint32_t **values_out, uint32_t *count_out) {
     const size_t capacity = 1000*1000;
     uint32_t* values =
@@ -4151,6 +4223,1060 @@ DEFINE_TEST(test_frozen_serialization_max_containers) {
     frozen_serialization_compare(r);
 }
 
+void portable_view_compare(const roaring_bitmap_t *r1) {
+    size_t num_bytes = roaring_bitmap_portable_size_in_bytes(r1);
+    char *buf = (char*)roaring_bitmap_aligned_malloc(32, num_bytes + 32);
+    // every offset, so that each container is in turn misaligned
+    for (size_t offset = 0; offset < 32; offset++) {
+        roaring_bitmap_portable_serialize(r1, buf + offset);
+        const roaring_bitmap_t *r2 =
+            roaring_bitmap_portable_view(buf + offset, num_bytes);
+        assert_non_null(r2);
+        assert_true(roaring_bitmap_equals(r1, r2));
+        assert_true(roaring_bitmap_get_cardinality(r2) ==
+                    roaring_bitmap_get_cardinality(r1));
+        roaring_bitmap_t *r3 = roaring_bitmap_and(r1, r2);
+        assert_true(roaring_bitmap_equals(r1, r3));
+        roaring_bitmap_free(r3);
+        roaring_bitmap_free(r2);
+    }
+    for (size_t len = 0; len < num_bytes; len += 1 + len / 8) {
+        assert_null(roaring_bitmap_portable_view(buf, len));
+    }
+    roaring_bitmap_aligned_free(buf);
+}
+
+DEFINE_TEST(test_portable_view) {
+    const uint64_t s = 65536;
+
+    roaring_bitmap_t *r = roaring_bitmap_create();
+    portable_view_compare(r);
+    roaring_bitmap_add(r, 0);
+    roaring_bitmap_add(r, UINT32_MAX);
+    roaring_bitmap_add(r, 1000);
+    roaring_bitmap_add(r, 2000);
+    roaring_bitmap_add(r, 100000);
+    roaring_bitmap_add_range(r, s*10 + 100, s*13 - 100);
+    for (uint64_t i = 0; i < s*3; i += 2) {
+        roaring_bitmap_add(r, s*20 + i);
+    }
+    portable_view_compare(r);  // no run containers
+    roaring_bitmap_run_optimize(r);
+    portable_view_compare(r);
+    roaring_bitmap_free(r);
+
+    r = roaring_bitmap_create();
+    for (int64_t i = 0; i < 65536; i++) {
+        roaring_bitmap_add(r, 65536 * i);
+    }
+    portable_view_compare(r);
+    roaring_bitmap_free(r);
+}
+
+typedef struct {
+    char *buf;
+    size_t size;
+    size_t capacity;  // writes fail past this
+    size_t calls;
+} stream_buffer_t;
+
+static bool stream_write(const char *data, size_t length, void *param) {
+    stream_buffer_t *sb = (stream_buffer_t *)param;
+    sb->calls++;
+    if (length > sb->capacity - sb->size) return false;
+    memcpy(sb->buf + sb->size, data, length);
+    sb->size += length;
+    return true;
+}
+
+static bool stream_read(char *data, size_t length, void *param) {
+    stream_buffer_t *sb = (stream_buffer_t *)param;
+    sb->calls++;
+    if (length > sb->capacity - sb->size) return false;
+    memcpy(data, sb->buf + sb->size, length);
+    sb->size += length;
+    return true;
+}
+
+void portable_stream_compare(const roaring_bitmap_t *r1) {
+    size_t num_bytes = roaring_bitmap_portable_size_in_bytes(r1);
+    char *expected = (char *)malloc(num_bytes);
+    roaring_bitmap_portable_serialize(r1, expected);
+
+    stream_buffer_t sb = {(char *)malloc(num_bytes + 4), 0, num_bytes + 4, 0};
+    assert_true(roaring_bitmap_portable_serialize_stream(r1, stream_write,
+                                                         &sb) == num_bytes);
+    assert_true(sb.size == num_bytes);
+    assert_true(memcmp(sb.buf, expected, num_bytes) == 0);
+    assert_true(sb.calls >= (size_t)r1->high_low_container.size + 1);
+
+    // the reader stops at the end of the bitmap
+    memcpy(sb.buf + num_bytes, "tail", 4);
+    sb.size = 0;
+    roaring_bitmap_t *r2 =
+        roaring_bitmap_portable_deserialize_stream(stream_read, &sb);
+    assert_non_null(r2);
+    assert_true(sb.size == num_bytes);
+    assert_true(roaring_bitmap_equals(r1, r2));
+    roaring_bitmap_free(r2);
+
+    for (size_t len = 0; len < num_bytes; len += 1 + len / 8) {
+        sb.size = 0;
+        sb.capacity = len;
+        assert_true(roaring_bitmap_portable_serialize_stream(
+                        r1, stream_write, &sb) == 0);
+        sb.size = 0;
+        assert_null(roaring_bitmap_portable_deserialize_stream(stream_read,
+                                                               &sb));
+    }
+    free(sb.buf);
+    free(expected);
+}
+
+DEFINE_TEST(test_portable_stream) {
+    const uint64_t s = 65536;
+
+    roaring_bitmap_t *r = roaring_bitmap_create();
+    portable_stream_compare(r);
+    roaring_bitmap_add(r, 0);
+    roaring_bitmap_add(r, UINT32_MAX);
+    roaring_bitmap_add(r, 1000);
+    portable_stream_compare(r);  // below the offset threshold
+    roaring_bitmap_add(r, 100000);
+    roaring_bitmap_add_range(r, s*10 + 100, s*13 - 100);
+    for (uint64_t i = 0; i < s*3; i += 2) {
+        roaring_bitmap_add(r, s*20 + i);
+    }
+    portable_stream_compare(r);
+    roaring_bitmap_run_optimize(r);
+    portable_stream_compare(r);
+    roaring_bitmap_free(r);
+}
+
+// small arrays spread over many keys, a run across containers, bitsets,
+// and the largest value
+static roaring_bitmap_t *make_mixed_bitmap() {
+    roaring_bitmap_t *r = roaring_bitmap_create();
+    for (uint32_t i = 0; i < 100; i++) {
+        roaring_bitmap_add(r, i * 65536 * 7 + i * 3);
+    }
+    roaring_bitmap_add_range(r, 3000000, 3300000);
+    for (uint32_t i = 0; i < 200000; i += 3) {
+        roaring_bitmap_add(r, 5000000 + i);
+    }
+    roaring_bitmap_add(r, UINT32_MAX);
+    return r;
+}
+
+DEFINE_TEST(test_rank_index) {
+    roaring_bitmap_t *r = roaring_bitmap_create();
+    roaring_rank_index_t *index = roaring_rank_index_create(r);
+    uint32_t element;
+    assert_true(roaring_bitmap_rank_indexed(r, index, 12345) == 0);
+    assert_false(roaring_bitmap_select_indexed(r, index, 0, &element));
+    roaring_rank_index_free(index);
+    roaring_bitmap_free(r);
+
+    r = make_mixed_bitmap();
+    for (int run = 0; run < 2; run++) {
+        index = roaring_rank_index_create(r);
+        assert_non_null(index);
+        for (uint64_t x = 0; x <= UINT32_MAX; x += 9973) {
+            assert_true(roaring_bitmap_rank_indexed(r, index, (uint32_t)x) ==
+                        roaring_bitmap_rank(r, (uint32_t)x));
+        }
+        assert_true(roaring_bitmap_rank_indexed(r, index, UINT32_MAX) ==
+                    roaring_bitmap_get_cardinality(r));
+        uint64_t card = roaring_bitmap_get_cardinality(r);
+        for (uint32_t rank = 0; rank <= card; rank += 7) {
+            uint32_t expected;
+            bool valid = roaring_bitmap_select(r, rank, &expected);
+            assert_true(roaring_bitmap_select_indexed(r, index, rank,
+                                                      &element) == valid);
+            if (valid) assert_true(element == expected);
+        }
+        assert_true(roaring_bitmap_select_indexed(r, index, (uint32_t)card - 1,
+                                                  &element));
+        assert_true(element == UINT32_MAX);
+        roaring_rank_index_free(index);
+        roaring_bitmap_run_optimize(r);
+    }
+
+    // an index rebuilt after each change
+    index = roaring_rank_index_create(r);
+    for (int change = 0; change < 3; change++) {
+        if (change == 0) roaring_bitmap_add(r, 1);  // in an existing container
+        if (change == 1) roaring_bitmap_add(r, 70000);  // a new container
+        if (change == 2) roaring_bitmap_remove_range(r, 0, 3100000);
+        assert_true(roaring_rank_index_rebuild(r, index));
+        for (uint64_t x = 0; x <= UINT32_MAX; x += 99991) {
+            assert_true(roaring_bitmap_rank_indexed(r, index, (uint32_t)x) ==
+                        roaring_bitmap_rank(r, (uint32_t)x));
+        }
+        uint64_t card = roaring_bitmap_get_cardinality(r);
+        for (uint32_t rank = 0; rank <= card; rank += 997) {
+            uint32_t expected;
+            bool valid = roaring_bitmap_select(r, rank, &expected);
+            assert_true(roaring_bitmap_select_indexed(r, index, rank,
+                                                      &element) == valid);
+            if (valid) assert_true(element == expected);
+        }
+    }
+    roaring_rank_index_free(index);
+    roaring_bitmap_free(r);
+}
+
+DEFINE_TEST(test_rank_select_many) {
+    roaring_bitmap_t *r = make_mixed_bitmap();
+
+    const size_t n = 100000;
+    uint32_t *values = (uint32_t *)malloc(n * sizeof(uint32_t));
+    uint64_t *ranks = (uint64_t *)malloc(n * sizeof(uint64_t));
+    uint32_t *elements = (uint32_t *)malloc(n * sizeof(uint32_t));
+    for (int run = 0; run < 2; run++) {
+        // sorted, with duplicates, values past the end and gaps between keys
+        for (size_t i = 0; i < n; i++) {
+            values[i] = (i < n / 2) ? (uint32_t)(i / 2 * 113)
+                                    : (uint32_t)(i * 42949);
+        }
+        values[n - 1] = UINT32_MAX;
+        roaring_bitmap_rank_many(r, values, values + n, ranks);
+        for (size_t i = 0; i < n; i++) {
+            assert_true(ranks[i] == roaring_bitmap_rank(r, values[i]));
+        }
+
+        uint64_t card = roaring_bitmap_get_cardinality(r);
+        size_t expected_selected = 0;
+        for (size_t i = 0; i < n; i++) {
+            values[i] = (uint32_t)(i / 2 * 9);  // some past the cardinality
+            if (values[i] < card) expected_selected++;
+        }
+        assert_true(expected_selected < n);
+        size_t selected =
+            roaring_bitmap_select_many(r, values, values + n, elements);
+        assert_true(selected == expected_selected);
+        for (size_t i = 0; i < selected; i++) {
+            uint32_t expected;
+            assert_true(roaring_bitmap_select(r, values[i], &expected));
+            assert_true(elements[i] == expected);
+        }
+        roaring_bitmap_run_optimize(r);
+    }
+    roaring_bitmap_free(r);
+
+    // the ranks of a full bitmap do not fit in 32 bits
+    r = roaring_bitmap_from_range(0, UINT64_C(0x100000000), 1);
+    values[0] = 5;
+    values[1] = UINT32_MAX - 65536;
+    values[2] = UINT32_MAX;
+    assert_true(roaring_bitmap_select_many(r, values, values + 3, elements) ==
+                3);
+    assert_true(elements[0] == 5);
+    assert_true(elements[1] == UINT32_MAX - 65536);
+    assert_true(elements[2] == UINT32_MAX);
+    roaring_bitmap_rank_many(r, values, values + 3, ranks);
+    assert_true(ranks[2] == UINT64_C(0x100000000));
+    roaring_bitmap_free(r);
+    free(elements);
+    free(ranks);
+    free(values);
+}
+
+DEFINE_TEST(test_contains_many) {
+    roaring_bitmap_t *r = make_mixed_bitmap();
+
+    const size_t n = 300000;
+    uint32_t *vals = (uint32_t *)malloc(n * sizeof(uint32_t));
+    bool *results = (bool *)malloc(n * sizeof(bool));
+    for (int run = 0; run < 2; run++) {
+        // sorted, then out of order within and across containers
+        for (size_t i = 0; i < n; i++) {
+            vals[i] = (uint32_t)(i * 29 / 2);
+        }
+        vals[n - 1] = UINT32_MAX;
+        for (size_t i = n / 2; i < n - 1; i += 101) {
+            uint32_t tmp = vals[i];
+            vals[i] = vals[i - 50];
+            vals[i - 50] = tmp;
+        }
+        for (size_t i = 0; i < n; i += 1000) {
+            vals[i] = i * 65536 * 7 + i * 3;
+        }
+        roaring_bitmap_contains_many(r, n, vals, results);
+        size_t found = 0;
+        for (size_t i = 0; i < n; i++) {
+            assert_true(results[i] == roaring_bitmap_contains(r, vals[i]));
+            found += results[i];
+        }
+        assert_true(found > 0 && found < n);
+        roaring_bitmap_run_optimize(r);
+    }
+    roaring_bitmap_contains_many(r, 0, vals, results);
+    free(results);
+    free(vals);
+    roaring_bitmap_free(r);
+}
+
+DEFINE_TEST(test_from_sorted) {
+    roaring_bitmap_t *r = roaring_bitmap_from_sorted(0, NULL);
+    assert_true(roaring_bitmap_is_empty(r));
+    roaring_bitmap_free(r);
+
+    roaring_bitmap_t *expected = make_mixed_bitmap();
+    for (uint32_t i = 0; i < 65536; i += 8) {  // many short runs
+        roaring_bitmap_add_range(expected, 9000000 + i, 9000000 + i + 5);
+    }
+
+    uint64_t card = roaring_bitmap_get_cardinality(expected);
+    uint32_t *vals = (uint32_t *)malloc(card * sizeof(uint32_t));
+    roaring_bitmap_to_uint32_array(expected, vals);
+    r = roaring_bitmap_from_sorted(card, vals);
+    assert_true(roaring_bitmap_equals(r, expected));
+    roaring_bitmap_run_optimize(expected);
+    assert_true(roaring_bitmap_portable_size_in_bytes(r) ==
+                roaring_bitmap_portable_size_in_bytes(expected));
+    roaring_bitmap_free(r);
+    free(vals);
+    roaring_bitmap_free(expected);
+}
+
+DEFINE_TEST(test_bulk_builder) {
+    roaring_bitmap_t *expected = make_mixed_bitmap();
+    roaring_bitmap_remove(expected, UINT32_MAX);  // added at the end
+    roaring_bitmap_t *r = roaring_bitmap_create();
+    roaring_bulk_builder_t builder;
+    assert_true(roaring_bulk_builder_init(&builder, r));
+    assert_true(roaring_bulk_builder_flush(&builder));
+    roaring_uint32_iterator_t it;
+    roaring_init_iterator(expected, &it);
+    for (; it.has_value; roaring_advance_uint32_iterator(&it)) {
+        assert_true(roaring_bulk_builder_add(&builder, it.current_value));
+        // duplicates are skipped
+        assert_true(roaring_bulk_builder_add(&builder, it.current_value));
+    }
+    assert_true(roaring_bulk_builder_flush(&builder));
+    assert_true(roaring_bitmap_equals(r, expected));
+
+    // more values for the last key, after a flush
+    const uint32_t last = roaring_bitmap_maximum(expected);
+    for (uint32_t i = 1; i < 60000; i += 5) {
+        roaring_bitmap_add(expected, last + i);
+        assert_true(roaring_bulk_builder_add(&builder, last + i));
+    }
+    roaring_bitmap_add(expected, UINT32_MAX);
+    assert_true(roaring_bulk_builder_add(&builder, UINT32_MAX));
+    assert_true(roaring_bulk_builder_finish(&builder));
+    assert_true(roaring_bitmap_equals(r, expected));
+    roaring_bitmap_run_optimize(expected);
+    assert_true(roaring_bitmap_portable_size_in_bytes(r) <=
+                roaring_bitmap_portable_size_in_bytes(expected));
+    roaring_bitmap_free(r);
+    roaring_bitmap_free(expected);
+}
+
+DEFINE_TEST(test_bulk_context) {
+    roaring_bitmap_t *expected = roaring_bitmap_create();
+    roaring_bitmap_t *r = roaring_bitmap_create();
+    roaring_bitmap_t *copy = NULL;
+    roaring_bitmap_t *copy_expected = NULL;
+    roaring_bulk_context_t context;
+    memset(&context, 0, sizeof(context));
+    uint32_t state = 1234;
+    for (int round = 0; round < 3; round++) {
+        if (round == 1) {
+            // the containers become shared with a copy
+            roaring_bitmap_set_copy_on_write(r, true);
+            copy = roaring_bitmap_copy(r);
+            copy_expected = roaring_bitmap_copy(expected);
+            memset(&context, 0, sizeof(context));
+        }
+        for (int i = 0; i < 200000; i++) {
+            // clustered: a few values in a row share their high 16 bits
+            state = state * 1103515245 + 12345;
+            uint32_t val = (state >> 4) % (1 << 20);
+            if (i % 4 == 0) val += round * (1 << 22);
+            switch ((state >> 28) % 4) {
+                case 0:
+                case 1:
+                    roaring_bitmap_add(expected, val);
+                    roaring_bitmap_add_bulk(r, &context, val);
+                    break;
+                case 2:
+                    roaring_bitmap_remove(expected, val);
+                    roaring_bitmap_remove_bulk(r, &context, val);
+                    break;
+                default:
+                    assert_true(roaring_bitmap_contains_bulk(r, &context, val) ==
+                                roaring_bitmap_contains(expected, val));
+            }
+        }
+        assert_true(roaring_bitmap_equals(r, expected));
+    }
+    assert_true(roaring_bitmap_equals(copy, copy_expected));
+    roaring_bitmap_free(copy);
+    roaring_bitmap_free(copy_expected);
+
+    // emptied containers are removed
+    memset(&context, 0, sizeof(context));
+    for (uint32_t val = 0; val < 1000; val++) {
+        roaring_bitmap_add_bulk(r, &context, (7 << 16) + val);
+    }
+    for (uint32_t val = 0; val < (1 << 17); val++) {
+        roaring_bitmap_remove_bulk(r, &context, (6 << 16) + val);
+        assert_false(roaring_bitmap_contains_bulk(r, &context, (6 << 16) + val));
+    }
+    assert_true(roaring_bitmap_range_cardinality(r, 6 << 16, 8 << 16) == 0);
+    roaring_bitmap_free(r);
+    roaring_bitmap_free(expected);
+}
+
+// reads the ranges of r, count at a time, and checks them against its values
+static void check_iterator_ranges(const roaring_bitmap_t *r, uint32_t count) {
+    uint64_t card = roaring_bitmap_get_cardinality(r);
+    uint32_t *vals = (uint32_t *)malloc((card + 1) * sizeof(uint32_t));
+    roaring_bitmap_to_uint32_array(r, vals);
+    uint64_t *ranges = (uint64_t *)malloc(2 * count * sizeof(uint64_t));
+    roaring_uint32_iterator_t it;
+    roaring_init_iterator(r, &it);
+    uint64_t pos = 0;
+    uint32_t n;
+    do {
+        n = roaring_read_uint32_iterator_ranges(&it, ranges, count);
+        for (uint32_t k = 0; k < n; k++) {
+            uint64_t start = ranges[2 * k], end = ranges[2 * k + 1];
+            assert_true(start < end);
+            // maximal: the value before the range is not in the bitmap
+            assert_true(pos == 0 || vals[pos - 1] + UINT64_C(1) < start);
+            for (uint64_t v = start; v < end; v++, pos++) {
+                assert_true(pos < card && vals[pos] == v);
+            }
+        }
+        assert_true(it.has_value == (pos < card));
+        if (it.has_value) assert_true(it.current_value == vals[pos]);
+    } while (n == count);
+    assert_true(pos == card);
+    free(ranges);
+    free(vals);
+}
+
+DEFINE_TEST(test_iterator_ranges) {
+    roaring_bitmap_t *r = roaring_bitmap_create();
+    check_iterator_ranges(r, 1);
+    roaring_bitmap_free(r);
+    r = make_mixed_bitmap();
+    for (uint32_t i = 0; i < 100; i++) {
+        roaring_bitmap_add_range(r, i * 65536 * 7 + i * 4,
+                                 i * 65536 * 7 + i * 5);
+    }
+    for (uint32_t i = 0; i < 65536 * 3; i += 300) {
+        roaring_bitmap_add_range(r, 70000000 + i, 70000000 + i + 200);
+    }
+    roaring_bitmap_add_range(r, UINT32_MAX - 100000, UINT64_C(0x100000000));
+    for (int run = 0; run < 2; run++) {
+        check_iterator_ranges(r, 1);
+        check_iterator_ranges(r, 7);
+        check_iterator_ranges(r, 1000000);
+        roaring_bitmap_run_optimize(r);
+    }
+
+    // ranges pick up from where other iterator functions left
+    roaring_uint32_iterator_t it;
+    roaring_init_iterator(r, &it);
+    roaring_move_uint32_iterator_equalorlarger(&it, 70000100);
+    uint64_t ranges[4];
+    assert_true(roaring_read_uint32_iterator_ranges(&it, ranges, 2) == 2);
+    assert_true(ranges[0] == 70000100 && ranges[1] == 70000200);
+    assert_true(ranges[2] == 70000300 && ranges[3] == 70000500);
+    assert_true(it.has_value && it.current_value == 70000600);
+    roaring_bitmap_free(r);
+
+    r = roaring_bitmap_from_range(0, UINT64_C(0x100000000), 1);
+    roaring_init_iterator(r, &it);
+    assert_true(roaring_read_uint32_iterator_ranges(&it, ranges, 2) == 1);
+    assert_true(ranges[0] == 0 && ranges[1] == UINT64_C(0x100000000));
+    assert_false(it.has_value);
+    roaring_bitmap_free(r);
+}
+
+// checks roaring_bitmap_add_offset against adding the offset value by value
+static void check_add_offset(const roaring_bitmap_t *r, int64_t offset) {
+    roaring_bitmap_t *expected = roaring_bitmap_create();
+    roaring_uint32_iterator_t it;
+    roaring_init_iterator(r, &it);
+    // larger offsets move every value out of range (and would overflow v)
+    const bool in_range = offset > -(INT64_C(1) << 33) &&
+                          offset < (INT64_C(1) << 33);
+    for (; in_range && it.has_value; roaring_advance_uint32_iterator(&it)) {
+        int64_t v = (int64_t)it.current_value + offset;
+        if (v >= 0 && v <= UINT32_MAX) roaring_bitmap_add(expected, (uint32_t)v);
+    }
+    roaring_bitmap_t *shifted = roaring_bitmap_add_offset(r, offset);
+    assert_true(roaring_bitmap_equals(shifted, expected));
+    // the containers keep their invariants
+    for (int32_t i = 0; i < shifted->high_low_container.size; i++) {
+        uint8_t type = shifted->high_low_container.typecodes[i];
+        int card = container_get_cardinality(
+            shifted->high_low_container.containers[i], type);
+        assert_true(card > 0);
+        if (type == ARRAY_CONTAINER_TYPE) assert_true(card <= DEFAULT_MAX_SIZE);
+        if (type == BITSET_CONTAINER_TYPE) assert_true(card > DEFAULT_MAX_SIZE);
+    }
+    roaring_bitmap_free(shifted);
+    roaring_bitmap_free(expected);
+}
+
+DEFINE_TEST(test_add_offset) {
+    roaring_bitmap_t *r = roaring_bitmap_create();
+    check_add_offset(r, 12345);
+    roaring_bitmap_free(r);
+    r = make_mixed_bitmap();
+    for (uint32_t i = 0; i < 100; i++) {
+        roaring_bitmap_add(r, i * 65536 * 7 + 65535 - i);
+    }
+    for (uint32_t i = 0; i < 65536 * 3; i += 300) {
+        roaring_bitmap_add_range(r, 70000000 + i, 70000000 + i + 200);
+    }
+    roaring_bitmap_add_range(r, UINT32_MAX - 100000, UINT64_C(0x100000000));
+    const int64_t offsets[] = {0,       1,           -1,         64,
+                               -64,     65535,       -65535,     65536,
+                               -65536,  100000,      -100000,    3 * 65536,
+                               1000001, -60000000,   4000000000, -4000000000,
+                               INT64_C(1) << 32, -(INT64_C(1) << 32),
+                               INT64_MAX, INT64_MIN};
+    for (int run = 0; run < 2; run++) {
+        for (size_t i = 0; i < sizeof(offsets) / sizeof(offsets[0]); i++) {
+            check_add_offset(r, offsets[i]);
+        }
+        roaring_bitmap_run_optimize(r);
+    }
+    roaring_bitmap_free(r);
+}
+
+DEFINE_TEST(test_evaluate) {
+    roaring_bitmap_t *inputs[6];
+    uint32_t state = 42;
+    for (int k = 0; k < 6; k++) {
+        inputs[k] = roaring_bitmap_create();
+        for (int i = 0; i < 100000; i++) {
+            state = state * 1103515245 + 12345;
+            roaring_bitmap_add(inputs[k], (state >> 8) % (1 << 22));
+        }
+        roaring_bitmap_add_range(inputs[k], k * 500000, k * 500000 + 300000);
+    }
+    roaring_bitmap_run_optimize(inputs[2]);
+    roaring_bitmap_add_range(inputs[5], 50000000, 50100000);  // a lone key
+    const roaring_bitmap_t **rs = (const roaring_bitmap_t **)inputs;
+
+    // ((A | B | C) & ~D & (E | F)) ^ (A & A)
+    const roaring_expression_node_t nodes[] = {
+        {ROARING_EXPRESSION_INPUT, 0, 0},   // 0: A
+        {ROARING_EXPRESSION_INPUT, 1, 0},   // 1: B
+        {ROARING_EXPRESSION_OR, 0, 1},      // 2
+        {ROARING_EXPRESSION_INPUT, 2, 0},   // 3: C
+        {ROARING_EXPRESSION_OR, 2, 3},      // 4
+        {ROARING_EXPRESSION_INPUT, 3, 0},   // 5: D
+        {ROARING_EXPRESSION_ANDNOT, 4, 5},  // 6
+        {ROARING_EXPRESSION_INPUT, 4, 0},   // 7: E
+        {ROARING_EXPRESSION_INPUT, 5, 0},   // 8: F
+        {ROARING_EXPRESSION_OR, 7, 8},      // 9
+        {ROARING_EXPRESSION_AND, 6, 9},     // 10
+        {ROARING_EXPRESSION_AND, 0, 0},     // 11
+        {ROARING_EXPRESSION_XOR, 10, 11},   // 12
+    };
+    const size_t n_nodes = sizeof(nodes) / sizeof(nodes[0]);
+    roaring_bitmap_t *abc = roaring_bitmap_or_many(3, rs);
+    roaring_bitmap_andnot_inplace(abc, inputs[3]);
+    roaring_bitmap_t *ef = roaring_bitmap_or(inputs[4], inputs[5]);
+    roaring_bitmap_and_inplace(abc, ef);
+    roaring_bitmap_xor_inplace(abc, inputs[0]);
+    roaring_bitmap_t *r = roaring_bitmap_evaluate(n_nodes, nodes, 6, rs);
+    assert_non_null(r);
+    assert_true(roaring_bitmap_equals(r, abc));
+    roaring_bitmap_free(r);
+
+    // every prefix is an expression too
+    r = roaring_bitmap_evaluate(9, nodes, 6, rs);
+    assert_true(roaring_bitmap_equals(r, inputs[5]));
+    roaring_bitmap_free(r);
+    r = roaring_bitmap_evaluate(7, nodes, 6, rs);
+    roaring_bitmap_t *expected = roaring_bitmap_or_many(3, rs);
+    roaring_bitmap_andnot_inplace(expected, inputs[3]);
+    assert_true(roaring_bitmap_equals(r, expected));
+    roaring_bitmap_free(expected);
+    roaring_bitmap_free(r);
+
+    // x ^ x and x & ~x are empty
+    const roaring_expression_node_t empty[] = {
+        {ROARING_EXPRESSION_INPUT, 1, 0},
+        {ROARING_EXPRESSION_INPUT, 1, 0},
+        {ROARING_EXPRESSION_XOR, 0, 1},
+        {ROARING_EXPRESSION_ANDNOT, 1, 0},
+        {ROARING_EXPRESSION_OR, 2, 3},
+    };
+    r = roaring_bitmap_evaluate(5, empty, 6, rs);
+    assert_true(roaring_bitmap_is_empty(r));
+    roaring_bitmap_free(r);
+
+    // operands must exist and come first
+    const roaring_expression_node_t invalid[] = {
+        {ROARING_EXPRESSION_INPUT, 0, 0},
+        {ROARING_EXPRESSION_AND, 0, 1},
+    };
+    assert_null(roaring_bitmap_evaluate(2, invalid, 6, rs));
+    assert_null(roaring_bitmap_evaluate(1, invalid, 0, rs));
+    assert_null(roaring_bitmap_evaluate(0, invalid, 6, rs));
+
+    roaring_bitmap_free(ef);
+    roaring_bitmap_free(abc);
+    for (int k = 0; k < 6; k++) {
+        roaring_bitmap_free(inputs[k]);
+    }
+}
+
+DEFINE_TEST(test_snapshot) {
+    roaring_bitmap_t *r = roaring_bitmap_create();
+    for (uint32_t i = 0; i < 100; i++) {
+        roaring_bitmap_add(r, i * 3);             // array
+        roaring_bitmap_add(r, 65536 + i * 600);   // array
+    }
+    roaring_bitmap_add_range(r, 200000, 250000);  // run
+    for (uint32_t i = 0; i < 65536; i += 2) {
+        roaring_bitmap_add(r, 327680 + i);        // bitset
+    }
+    roaring_bitmap_t *expected = roaring_bitmap_copy(r);
+    assert_false(roaring_bitmap_get_copy_on_write(expected));
+
+    roaring_bitmap_t *s1 = roaring_bitmap_snapshot(r);
+    roaring_bitmap_t *s2 = roaring_bitmap_snapshot(r);
+    assert_true(roaring_bitmap_get_copy_on_write(r));
+    assert_true(roaring_bitmap_get_copy_on_write(s1));
+    assert_true(roaring_bitmap_equals(s1, expected));
+    assert_true(roaring_bitmap_equals(s2, expected));
+
+    // modifying the source leaves the snapshots as they were
+    roaring_bitmap_add(r, 1);
+    roaring_bitmap_remove(r, 200001);
+    roaring_bitmap_remove_range(r, 327680, 330000);
+    assert_true(roaring_bitmap_contains(r, 1));
+    assert_true(roaring_bitmap_equals(s1, expected));
+    assert_true(roaring_bitmap_equals(s2, expected));
+
+    // and so does modifying or freeing another snapshot
+    roaring_bitmap_add(s1, 7);
+    roaring_bitmap_t *s3 = roaring_bitmap_snapshot(s1);
+    roaring_bitmap_clear(s1);
+    roaring_bitmap_free(r);
+    assert_true(roaring_bitmap_equals(s2, expected));
+    assert_true(roaring_bitmap_contains(s3, 7));
+    roaring_bitmap_remove(s3, 7);
+    assert_true(roaring_bitmap_equals(s3, expected));
+    roaring_bitmap_free(s1);
+    roaring_bitmap_free(s3);
+    assert_true(roaring_bitmap_equals(s2, expected));
+
+    // the last owner can modify the containers in place
+    roaring_bitmap_add(s2, 2);
+    assert_true(roaring_bitmap_contains(s2, 2));
+    assert_int_equal(roaring_bitmap_get_cardinality(s2),
+                     roaring_bitmap_get_cardinality(expected) + 1);
+    roaring_bitmap_free(s2);
+    roaring_bitmap_free(expected);
+}
+
+DEFINE_TEST(test_concurrent_bitmap) {
+    assert_null(roaring_concurrent_bitmap_create(0));
+    assert_null(roaring_concurrent_bitmap_create(65537));
+#ifdef CROARING_NO_ATOMICS
+    assert_null(roaring_concurrent_bitmap_create(4));
+    return;
+#endif
+
+    enum { N = 20000 };
+    uint32_t *vals = (uint32_t *)malloc(N * sizeof(uint32_t));
+    uint32_t state = 12345;
+    for (int i = 0; i < N; i++) {
+        state = state * 1103515245 + 12345;
+        if (i % 4 == 0) {
+            vals[i] = state;                          // anywhere
+        } else {
+            vals[i] = 70000 * (uint32_t)(i / 1000) + (state >> 20);  // clustered
+        }
+    }
+    vals[0] = 0;
+    vals[1] = UINT32_MAX;
+    roaring_bitmap_t *expected = roaring_bitmap_of_ptr(N, vals);
+
+    const uint32_t stripe_counts[] = {1, 3, 64, 65536};
+    for (size_t k = 0; k < sizeof(stripe_counts) / sizeof(uint32_t); k++) {
+        roaring_concurrent_bitmap_t *cb =
+            roaring_concurrent_bitmap_create(stripe_counts[k]);
+        assert_non_null(cb);
+        roaring_concurrent_bitmap_add_many(cb, N / 2, vals);
+        for (int i = N / 2; i < N; i++) {
+            roaring_concurrent_bitmap_add(cb, vals[i]);
+        }
+        for (int i = 0; i < N; i += 7) {
+            assert_true(roaring_concurrent_bitmap_contains(cb, vals[i]));
+        }
+        assert_false(roaring_concurrent_bitmap_contains(cb, 70000 * 30));
+
+        roaring_bitmap_t *r = roaring_concurrent_bitmap_to_bitmap(cb);
+        assert_true(roaring_bitmap_equals(r, expected));
+        assert_false(roaring_concurrent_bitmap_contains(cb, vals[2]));
+
+        // the concurrent bitmap can be filled again
+        roaring_concurrent_bitmap_add_many(cb, N, vals);
+        roaring_bitmap_t *again = roaring_concurrent_bitmap_to_bitmap(cb);
+        assert_true(roaring_bitmap_equals(again, expected));
+        roaring_concurrent_bitmap_add(cb, 5);
+        roaring_concurrent_bitmap_free(cb);  // with values left
+        roaring_bitmap_free(again);
+        roaring_bitmap_free(r);
+    }
+    roaring_bitmap_free(expected);
+    free(vals);
+}
+
+// checks that the cursor walks through the values of expected, with seeks
+static void check_cursor(roaring_cursor_t *c,
+                         const roaring_bitmap_t *expected) {
+    assert_non_null(c);
+    const uint64_t card = roaring_bitmap_get_cardinality(expected);
+    uint32_t *vals = (uint32_t *)malloc((card + 1) * sizeof(uint32_t));
+    roaring_bitmap_to_uint32_array(expected, vals);
+    uint32_t buf[100];
+    uint64_t pos = 0;
+    // the first values in a batch, the others one by one
+    uint32_t n = roaring_cursor_read(c, buf, 100);
+    assert_int_equal(n, card < 100 ? card : 100);
+    for (uint32_t i = 0; i < n; i++) {
+        assert_int_equal(buf[i], vals[pos++]);
+    }
+    for (int skip = 0; c->has_value; skip++) {
+        assert_int_equal(c->current_value, vals[pos]);
+        if (skip % 50 == 49) {  // seek ahead, sometimes past a key
+            uint32_t target =
+                c->current_value + (skip % 100 == 99 ? 70000 : 300);
+            roaring_cursor_move_equalorlarger(c, target);
+            while (pos < card && vals[pos] < target) pos++;
+        } else {
+            pos++;
+            roaring_cursor_advance(c);
+        }
+    }
+    assert_int_equal(pos, card);
+    roaring_cursor_advance(c);
+    assert_false(c->has_value);
+    free(vals);
+    roaring_cursor_free(c);
+}
+
+DEFINE_TEST(test_cursor) {
+    roaring_bitmap_t *a = roaring_bitmap_create();
+    roaring_bitmap_t *b = roaring_bitmap_create();
+    roaring_bitmap_t *c = roaring_bitmap_create();
+    for (uint32_t i = 0; i < 400000; i += 3) roaring_bitmap_add(a, i);
+    roaring_bitmap_add_range(a, 1000000, 1200000);
+    for (uint32_t i = 0; i < 1100000; i += 7) roaring_bitmap_add(b, i);
+    roaring_bitmap_add_range(b, 150000, 250000);
+    for (uint32_t i = 0; i < 1200000; i += 1009) roaring_bitmap_add(c, i);
+    roaring_bitmap_add_range(c, 1100000, 1100100);
+    roaring_bitmap_add(c, UINT32_MAX);
+    roaring_bitmap_run_optimize(a);
+    roaring_bitmap_run_optimize(b);
+
+    // (a & b & c) | (a & ~b)
+    roaring_bitmap_t *abc = roaring_bitmap_and(a, b);
+    roaring_bitmap_and_inplace(abc, c);
+    roaring_bitmap_t *a_b = roaring_bitmap_andnot(a, b);
+    roaring_bitmap_t *expected = roaring_bitmap_or(abc, a_b);
+    roaring_cursor_t *and_children[3] = {roaring_cursor_create(a),
+                                         roaring_cursor_create(b),
+                                         roaring_cursor_create(c)};
+    roaring_cursor_t *or_children[2] = {
+        roaring_cursor_and(3, and_children),
+        roaring_cursor_andnot(roaring_cursor_create(a),
+                              roaring_cursor_create(b))};
+    check_cursor(roaring_cursor_or(2, or_children), expected);
+    roaring_cursor_t *abc_children[3] = {roaring_cursor_create(a),
+                                         roaring_cursor_create(b),
+                                         roaring_cursor_create(c)};
+    check_cursor(roaring_cursor_and(3, abc_children), abc);
+    check_cursor(roaring_cursor_andnot(roaring_cursor_create(a),
+                                       roaring_cursor_create(b)), a_b);
+
+    // c & ~(a | b), and the trivial cases
+    roaring_bitmap_t *ab = roaring_bitmap_or(a, b);
+    roaring_bitmap_t *c_ab = roaring_bitmap_andnot(c, ab);
+    roaring_cursor_t *ab_children[2] = {roaring_cursor_create(a),
+                                        roaring_cursor_create(b)};
+    check_cursor(roaring_cursor_andnot(roaring_cursor_create(c),
+                                       roaring_cursor_or(2, ab_children)),
+                 c_ab);
+    check_cursor(roaring_cursor_create(c), c);
+    roaring_cursor_t *single[1] = {roaring_cursor_create(b)};
+    check_cursor(roaring_cursor_and(1, single), b);
+    roaring_bitmap_t *empty = roaring_bitmap_create();
+    roaring_cursor_t *with_empty[2] = {roaring_cursor_create(a),
+                                       roaring_cursor_create(empty)};
+    check_cursor(roaring_cursor_and(2, with_empty), empty);
+
+    // a NULL child makes the whole expression fail
+    roaring_cursor_t *with_null[2] = {roaring_cursor_create(a), NULL};
+    assert_null(roaring_cursor_and(2, with_null));
+    assert_null(roaring_cursor_or(0, NULL));
+
+    roaring_bitmap_free(empty);
+    roaring_bitmap_free(c_ab);
+    roaring_bitmap_free(ab);
+    roaring_bitmap_free(expected);
+    roaring_bitmap_free(a_b);
+    roaring_bitmap_free(abc);
+    roaring_bitmap_free(c);
+    roaring_bitmap_free(b);
+    roaring_bitmap_free(a);
+}
+
+DEFINE_TEST(test_threshold_many) {
+    enum { N = 7 };
+    roaring_bitmap_t *rs[N];
+    uint32_t state = 99;
+    for (int k = 0; k < N; k++) {
+        rs[k] = roaring_bitmap_create();
+        // key 0: sparse arrays, counted one value at a time
+        for (int i = 0; i < 300; i++) {
+            state = state * 1103515245 + 12345;
+            roaring_bitmap_add(rs[k], (state >> 16) % 1000);
+        }
+        // key 1: dense bitsets, counted with bit slices
+        for (int i = 0; i < 20000; i++) {
+            state = state * 1103515245 + 12345;
+            roaring_bitmap_add(rs[k], 65536 + (state >> 16) % 40000);
+        }
+        // key 2: runs, key 3: only in some bitmaps
+        roaring_bitmap_add_range(rs[k], 131072 + 1000 * k, 131072 + 30000);
+        if (k % 3 == 0) roaring_bitmap_add_range(rs[k], 196608, 196700);
+        // key 4: a mix of all three
+        roaring_bitmap_add_range(rs[k], 262144 + 100 * k, 262144 + 500 * k);
+        for (uint32_t i = 0; i < 65536; i += 3 + k) {
+            if (k % 2 == 0) roaring_bitmap_add(rs[k], 262144 + i);
+        }
+        roaring_bitmap_run_optimize(rs[k]);
+    }
+    roaring_bitmap_set_copy_on_write(rs[1], true);
+    roaring_bitmap_t *cow = roaring_bitmap_copy(rs[1]);  // shares containers
+
+    roaring_bitmap_t *all =
+        roaring_bitmap_or_many(N, (const roaring_bitmap_t **)rs);
+    for (uint32_t t = 1; t <= N + 1; t++) {
+        roaring_bitmap_t *expected = roaring_bitmap_create();
+        roaring_uint32_iterator_t it;
+        roaring_init_iterator(all, &it);
+        for (; it.has_value; roaring_advance_uint32_iterator(&it)) {
+            uint32_t count = 0;
+            for (int k = 0; k < N; k++) {
+                count += roaring_bitmap_contains(rs[k], it.current_value);
+            }
+            if (count >= t) roaring_bitmap_add(expected, it.current_value);
+        }
+        roaring_bitmap_t *r =
+            roaring_bitmap_threshold_many(N, (const roaring_bitmap_t **)rs, t);
+        assert_non_null(r);
+        assert_true(roaring_bitmap_equals(r, expected));
+        roaring_bitmap_free(r);
+        roaring_bitmap_free(expected);
+    }
+    assert_null(
+        roaring_bitmap_threshold_many(N, (const roaring_bitmap_t **)rs, 0));
+
+    roaring_bitmap_free(all);
+    roaring_bitmap_free(cow);
+    for (int k = 0; k < N; k++) {
+        roaring_bitmap_free(rs[k]);
+    }
+}
+
+// counts the blocks that are currently allocated through the hooks
+static int64_t live_allocations = 0;
+static int64_t aligned_allocations = 0;
+// the number of allocations that may still succeed, or -1 for no limit
+static int64_t allocations_left = -1;
+
+static bool take_allocation() {
+    if (allocations_left == 0) return false;
+    if (allocations_left > 0) allocations_left--;
+    return true;
+}
+
+static void *counting_malloc(size_t n) {
+    if (!take_allocation()) return NULL;
+    void *p = malloc(n);
+    if (p != NULL) live_allocations++;
+    return p;
+}
+
+static void *counting_realloc(void *p, size_t n) {
+    void *answer = realloc(p, n);
+    if (p == NULL && answer != NULL) live_allocations++;
+    return answer;
+}
+
+static void *counting_calloc(size_t n, size_t size) {
+    if (!take_allocation()) return NULL;
+    void *p = calloc(n, size);
+    if (p != NULL) live_allocations++;
+    return p;
+}
+
+static void counting_free(void *p) {
+    if (p != NULL) live_allocations--;
+    free(p);
+}
+
+static void *counting_aligned_malloc(size_t alignment, size_t size) {
+    if (!take_allocation()) return NULL;
+    void *p = roaring_bitmap_aligned_malloc(alignment, size);
+    if (p != NULL) {
+        live_allocations++;
+        aligned_allocations++;
+    }
+    return p;
+}
+
+static void counting_aligned_free(void *p) {
+    if (p != NULL) live_allocations--;
+    roaring_bitmap_aligned_free(p);
+}
+
+DEFINE_TEST(test_memory_hooks) {
+    roaring_memory_t hooks = {counting_malloc,  counting_realloc,
+                              counting_calloc,  counting_free,
+                              counting_aligned_malloc, counting_aligned_free};
+    roaring_init_memory_hook(hooks);
+
+    roaring_bitmap_t *r1 = roaring_bitmap_create();
+    assert_true(live_allocations > 0);
+    for (uint32_t i = 0; i < 100000; i += 3) {
+        roaring_bitmap_add(r1, i);  // grows arrays, then turns into bitsets
+    }
+    roaring_bitmap_add_range(r1, 500000, 600000);
+    roaring_bitmap_t *r2 = roaring_bitmap_from_range(50000, 550000, 7);
+    roaring_bitmap_t *r3 = roaring_bitmap_or(r1, r2);
+    roaring_bitmap_and_inplace(r3, r2);
+    roaring_bitmap_run_optimize(r3);
+    const roaring_bitmap_t *all[] = {r1, r2, r3};
+    roaring_bitmap_t *r4 = roaring_bitmap_or_many_heap(3, all);
+    assert_true(aligned_allocations > 0);
+
+    size_t size = roaring_bitmap_portable_size_in_bytes(r4);
+    char *buf = (char *)roaring_malloc(size);
+    roaring_bitmap_portable_serialize(r4, buf);
+    roaring_bitmap_t *r5 = roaring_bitmap_portable_deserialize(buf);
+    assert_true(roaring_bitmap_equals(r4, r5));
+    roaring_free(buf);
+
+    roaring_bitmap_free(r1);
+    roaring_bitmap_free(r2);
+    roaring_bitmap_free(r3);
+    roaring_bitmap_free(r4);
+    roaring_bitmap_free(r5);
+    assert_int_equal(live_allocations, 0);
+
+    roaring_reset_memory_hook();
+}
+
+DEFINE_TEST(test_scratch_arena) {
+    roaring_memory_t hooks = {counting_malloc,  counting_realloc,
+                              counting_calloc,  counting_free,
+                              counting_aligned_malloc, counting_aligned_free};
+    roaring_init_memory_hook(hooks);
+
+    roaring_bitmap_t *h1 = roaring_bitmap_from_range(0, 1000000, 3);
+    roaring_bitmap_t *h2 = roaring_bitmap_from_range(0, 1000000, 5);
+    const uint64_t h1_card = roaring_bitmap_get_cardinality(h1);
+    roaring_arena_t *arena = roaring_arena_create(1 << 24);
+    assert_non_null(arena);
+
+    for (int round = 0; round < 3; round++) {
+        const int64_t allocations = live_allocations;
+        assert_null(roaring_arena_set_current(arena));
+
+        roaring_bitmap_t *s1 = roaring_bitmap_create();
+        for (uint32_t i = 0; i < 1000000; i += 5) {
+            roaring_bitmap_add(s1, i);  // grows the arrays in place
+        }
+        roaring_bitmap_t *s2 = roaring_bitmap_and(s1, h1);
+        roaring_bitmap_or_inplace(s2, h2);
+        roaring_bitmap_t *s3 = roaring_bitmap_xor(s2, h1);
+        roaring_bitmap_run_optimize(s3);
+        roaring_bitmap_free(s1);  // optional
+
+        assert_ptr_equal(roaring_arena_set_current(NULL), arena);
+        // everything came from the arena
+        assert_int_equal(live_allocations, allocations);
+
+        assert_true(roaring_bitmap_equals(s2, h2));
+        roaring_bitmap_t *expected = roaring_bitmap_xor(h2, h1);
+        assert_true(roaring_bitmap_equals(s3, expected));
+        roaring_bitmap_free(expected);
+
+        roaring_arena_reset(arena);
+    }
+
+    // blocks from the hooks are still released normally in an arena
+    roaring_arena_set_current(arena);
+    roaring_bitmap_free(h2);
+    roaring_arena_set_current(NULL);
+    roaring_arena_free(arena);
+
+    // reset keeps the chunk of an oversized block over the regular ones
+    arena = roaring_arena_create(4096);
+    roaring_arena_set_current(arena);
+    roaring_malloc(1 << 20);
+    roaring_malloc(100);  // in a new, smaller chunk
+    roaring_arena_reset(arena);
+    const int64_t allocations = live_allocations;
+    assert_non_null(roaring_malloc(1 << 19));
+    assert_int_equal(live_allocations, allocations);
+    roaring_arena_set_current(NULL);
+    roaring_arena_free(arena);
+
+    assert_int_equal(roaring_bitmap_get_cardinality(h1), h1_card);
+    roaring_bitmap_free(h1);
+    assert_int_equal(live_allocations, 0);
+
+    roaring_reset_memory_hook();
+}
+
+DEFINE_TEST(test_add_offset_out_of_memory) {
+    roaring_memory_t hooks = {counting_malloc,  counting_realloc,
+                              counting_calloc,  counting_free,
+                              counting_aligned_malloc, counting_aligned_free};
+    roaring_init_memory_hook(hooks);
+
+    roaring_bitmap_t *r = make_mixed_bitmap();
+    roaring_bitmap_run_optimize(r);
+    roaring_bitmap_t *expected = roaring_bitmap_add_offset(r, 40000);
+    assert_non_null(expected);
+    const int64_t allocations = live_allocations;
+    // every allocation in turn fails, until there are enough of them
+    for (int64_t budget = 0;; budget++) {
+        allocations_left = budget;
+        roaring_bitmap_t *shifted = roaring_bitmap_add_offset(r, 40000);
+        allocations_left = -1;
+        if (shifted != NULL) {
+            assert_true(roaring_bitmap_equals(shifted, expected));
+            roaring_bitmap_free(shifted);
+            break;
+        }
+        assert_int_equal(live_allocations, allocations);
+    }
+    roaring_bitmap_free(expected);
+    roaring_bitmap_free(r);
+    assert_int_equal(live_allocations, 0);
+
+    roaring_reset_memory_hook();
+}
 
 int main() {
     tellmeall();
@@ -4261,6 +5387,8 @@ int main() {
         cmocka_unit_test(select_test),
         cmocka_unit_test(test_subset),
         cmocka_unit_test(test_or_many_memory_leak),
+        cmocka_unit_test(test_or_many_parallel_true),
+        cmocka_unit_test(test_or_many_parallel_false),
         // cmocka_unit_test(test_run_to_bitset),
         // cmocka_unit_test(test_run_to_array),
         cmocka_unit_test(test_read_uint32_iterator_array),
@@ -4279,6 +5407,24 @@ int main() {
         cmocka_unit_test(test_range_cardinality),
         cmocka_unit_test(test_frozen_serialization),
         cmocka_unit_test(test_frozen_serialization_max_containers),
+        cmocka_unit_test(test_portable_view),
+        cmocka_unit_test(test_portable_stream),
+        cmocka_unit_test(test_rank_index),
+        cmocka_unit_test(test_rank_select_many),
+        cmocka_unit_test(test_contains_many),
+        cmocka_unit_test(test_from_sorted),
+        cmocka_unit_test(test_bulk_builder),
+        cmocka_unit_test(test_bulk_context),
+        cmocka_unit_test(test_iterator_ranges),
+        cmocka_unit_test(test_add_offset),
+        cmocka_unit_test(test_evaluate),
+        cmocka_unit_test(test_snapshot),
+        cmocka_unit_test(test_concurrent_bitmap),
+        cmocka_unit_test(test_cursor),
+        cmocka_unit_test(test_threshold_many),
+        cmocka_unit_test(test_memory_hooks),
+        cmocka_unit_test(test_scratch_arena),
+        cmocka_unit_test(test_add_offset_out_of_memory),
     };
 
     return cmocka_run_group_tests(tests, NULL, NULL);